@@ -21,17 +21,18 @@ GLfloat translationX = 0.0;
 GLfloat translationY = 0.0;
 GLfloat zoom = 1.0;
 
-// spinning state
-bool spinning = true;
+// spinning state; the timer only runs while spinning, so a still picture costs nothing
+bool spinning = false;
+int spinChain = 0;  // only the newest chain keeps running if p then c is pressed before a pending tick fires
 
 // Timer function to spin the object continuously
-void rotateTimer(int value) {
-    if (spinning) {
+void rotateTimer(int chain) {
+    if (spinning && chain == spinChain) {
         angle += 1.0;
         if (angle >= 360.0)
             angle = 0.0;
         glutPostRedisplay();
-        glutTimerFunc(10, rotateTimer, 0);
+        glutTimerFunc(10, rotateTimer, chain);
     }
 }
 
@@ -39,12 +40,14 @@ void rotateTimer(int value) {
 void keyboard(unsigned char key, int x, int y) {
     switch (key) {
         case 'c':               // Start spinning
+            if (spinning)       // already running one timer chain
+                return;
             spinning = true;
-            rotateTimer(0);
-            break;
+            rotateTimer(++spinChain);  // a chain left over from before p lapses
+            return;             // the timer redraws
         case 'p':               // Stop spinning
             spinning = false;
-            break;
+            return;             // picture unchanged
         case 'u':               // Move up
             translationY += 0.1;
             break;
@@ -65,12 +68,14 @@ void keyboard(unsigned char key, int x, int y) {
             break;
         case '-':               // Zoom out
             if (zoom <= 0.1){
-                break;
+                return;         // nothing changed
             }
             else{
                 zoom -= 0.1;
                 break;
             }
+        default:                // unhandled key, nothing changed
+            return;
     }
     glutPostRedisplay();
 }
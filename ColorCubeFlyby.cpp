@@ -9,6 +9,7 @@
 #include <GL/glut.h>
 #endif
 #include <cmath>
+#include "headless.h"
 
 // The cube has opposite corners at (0,0,0) and (1,1,1), which are black and
 // white respectively.  The x-axis is the red gradient, the y-axis is the
@@ -94,7 +95,7 @@ void display() {
   Cube::draw();
   drawBlueMeshPlanes(); // Draw the blue mesh planes
   glFlush();
-  glutSwapBuffers();
+  if (!headlessActive()) glutSwapBuffers();
   
   
 
@@ -104,11 +105,15 @@ void display() {
 // curve u->(8*cos(u), 7*cos(u)-1, 4*cos(u/3)+2).  We keep the camera looking
 // at the center of the cube (0.5, 0.5, 0.5) and vary the up vector to achieve
 // a weird tumbling effect.
-void timer(int v) {
+void update() {
   static GLfloat u = 0.0;
   u += 0.01;
   glLoadIdentity();
   gluLookAt(8*cos(u), 7*cos(u)-1, 4*cos(u/3)+2, .5, .5, .5, cos(u), 1, 0);
+}
+
+void timer(int v) {
+  update();
   glutPostRedisplay();
   glutTimerFunc(1000/60.0, timer, v);
 }
@@ -136,6 +141,17 @@ void reshape(int w, int h) {
 
 // The usual main for a GLUT application.
 int main(int argc, char** argv) {
+  // --headless renders a fixed number of frames offscreen and exits
+  if (headlessInit(argc, argv, 500, 500, 0, 0, false)) {
+    reshape(headlessWidth(), headlessHeight());
+    while (headlessRunning()) {
+      update();
+      display();
+      headlessEndFrame();
+    }
+    return headlessFinish();
+  }
+
   glutInit(&argc, argv);
   glutInitDisplayMode(GLUT_DOUBLE | GLUT_RGB);
   glutInitWindowSize(500, 500);
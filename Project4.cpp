@@ -3,6 +3,7 @@
 #include <SOIL/SOIL.h>
 #include <fstream>
 #include <string>
+#include "headless.h"
 
 GLuint textureID; // Texture ID
 GLuint shaderProgram;
@@ -42,20 +43,12 @@ void setupShaders() {
     GLuint vertexShader = glCreateShader(GL_VERTEX_SHADER);
     GLuint fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
 
-    // Load vertex shader from file
-    std::ifstream vertexShaderFile("vertexShader.glsl");
-    std::string vertexShaderSource((std::istreambuf_iterator<char>(vertexShaderFile)),
-                                std::istreambuf_iterator<char>());
-    const char* vertexShaderSourceCStr = vertexShaderSource.c_str();
-    glShaderSource(vertexShader, 1, &vertexShaderSourceCStr, NULL);
+    // Use the vertex shader source embedded above instead of reading it from disk
+    glShaderSource(vertexShader, 1, &vertexShaderSource, NULL);
     glCompileShader(vertexShader);
 
-    // Load fragment shader from file
-    std::ifstream fragmentShaderFile("fragmentShader.glsl");
-    std::string fragmentShaderSource((std::istreambuf_iterator<char>(fragmentShaderFile)),
-                                  std::istreambuf_iterator<char>());
-    const char* fragmentShaderSourceCStr = fragmentShaderSource.c_str();
-    glShaderSource(fragmentShader, 1, &fragmentShaderSourceCStr, NULL);
+    // Use the fragment shader source embedded above instead of reading it from disk
+    glShaderSource(fragmentShader, 1, &fragmentShaderSource, NULL);
     glCompileShader(fragmentShader);
 
     shaderProgram = glCreateProgram();
@@ -583,13 +576,9 @@ void display() {
     glEnd();
 
 
-    glEnable(GL_TEXTURE_2D);
+    // The texture shader samples unit 0 directly, so fixed-function GL_TEXTURE_2D is never toggled
     glBindTexture(GL_TEXTURE_2D, textureID);
 
-    // Enable blending for transparent textures
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-
     // Use the texture shader
     glUseProgram(shaderProgram);
 
@@ -606,15 +595,11 @@ void display() {
     glTexCoord2f(0.0f, 1.0f); glVertex2f(0.0f, 662.0f);
     glEnd();
 
-    // Reset to default shader and disable texturing
+    // Reset to default shader
     glUseProgram(0);
-    glDisable(GL_TEXTURE_2D);
-    glBindTexture(GL_TEXTURE_2D, 0);
 
-    // Disable blending
-    glDisable(GL_BLEND);
-
-    glutSwapBuffers();
+    if (!headlessActive())
+        glutSwapBuffers();
 }
 
 void reshape(int width, int height) {
@@ -626,16 +611,33 @@ void reshape(int width, int height) {
 }
 
 int main(int argc, char** argv) {
-    glutInit(&argc, argv);
-    glutInitDisplayMode(GLUT_DOUBLE | GLUT_RGB);
-    glutInitWindowSize(485, 662);
-    glutCreateWindow("Project 4 Rendering");
+    // --headless renders a fixed number of frames offscreen instead of opening a window
+    bool headless = headlessInit(argc, argv, 485, 662, 0, 0, false);
+    if (!headless) {
+        glutInit(&argc, argv);
+        glutInitDisplayMode(GLUT_DOUBLE | GLUT_RGB);
+        glutInitWindowSize(485, 662);
+        glutCreateWindow("Project 4 Rendering");
+    }
 
     glewInit();
 
     loadTexture();
     setupShaders();
 
+    // Blending is set once: the opaque polygons are unaffected by it and only the textured quads need it
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    if (headless) {
+        reshape(headlessWidth(), headlessHeight());
+        while (headlessRunning()) {
+            display();
+            headlessEndFrame();
+        }
+        return headlessFinish();
+    }
+
     glutDisplayFunc(display);
     glutReshapeFunc(reshape);
 
@@ -41,20 +41,12 @@ void setupShaders() {
     GLuint vertexShader = glCreateShader(GL_VERTEX_SHADER);
     GLuint fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
 
-    // Load vertex shader from file
-    std::ifstream vertexShaderFile("vertexShader.glsl");
-    std::string vertexShaderSource((std::istreambuf_iterator<char>(vertexShaderFile)),
-                                std::istreambuf_iterator<char>());
-    const char* vertexShaderSourceCStr = vertexShaderSource.c_str();
-    glShaderSource(vertexShader, 1, &vertexShaderSourceCStr, NULL);
+    // Use the vertex shader source embedded above instead of reading it from disk
+    glShaderSource(vertexShader, 1, &vertexShaderSource, NULL);
     glCompileShader(vertexShader);
 
-    // Load fragment shader from file
-    std::ifstream fragmentShaderFile("fragmentShader.glsl");
-    std::string fragmentShaderSource((std::istreambuf_iterator<char>(fragmentShaderFile)),
-                                  std::istreambuf_iterator<char>());
-    const char* fragmentShaderSourceCStr = fragmentShaderSource.c_str();
-    glShaderSource(fragmentShader, 1, &fragmentShaderSourceCStr, NULL);
+    // Use the fragment shader source embedded above instead of reading it from disk
+    glShaderSource(fragmentShader, 1, &fragmentShaderSource, NULL);
     glCompileShader(fragmentShader);
 
     shaderProgram = glCreateProgram();
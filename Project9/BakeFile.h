@@ -0,0 +1,64 @@
+// Bake File
+
+#pragma once
+
+#include <cstddef> // Include size_t
+#include <cstdint> // Include fixed-width integers
+
+// Binary baked lighting, written by lightbake for one compiled scene and loaded by BakedLighting.h. Every
+// value is two bytes: ambient occlusion (the unoccluded fraction of the hemisphere) and key light visibility
+// (the fraction of the light's sphere that is not blocked). Fields are little-endian and 4-byte aligned.
+// Bump BAKE_FILE_VERSION whenever a record changes.
+//
+//   BakeFileHeader
+//   BakeFileObject[objectCount]           at objectOffset, one per scene object in scene order
+//   uint8_t atlas[atlasWidth * atlasHeight * 2] at atlasOffset, rows bottom to top
+//   uint8_t vertices[vertexCount * 2]     at vertexOffset
+//
+// Objects drawn with the built-in cube get a lightmap tile of 3x2 faces, each faceSize texels square, laid
+// out in CUBE_MESH_DATA face order left to right and bottom to top. Texel (i, j) of a face is the value at
+// texture coordinate ((i + 0.5) / faceSize, (j + 0.5) / faceSize). Objects drawn with a single-mesh model get
+// one value per model vertex instead, in the order Model.h loads them.
+
+const char BAKE_FILE_MAGIC[4] = { 'P', '9', 'B', 'K' }; // First bytes of every bake file
+const uint32_t BAKE_FILE_VERSION = 1; // Current format version
+
+// How an object's values are stored
+enum BakeKind : uint32_t {
+    BAKE_NONE = 0, // Not baked: group node, multi-mesh model, or failed to load
+    BAKE_LIGHTMAP = 1, // Tile in the atlas
+    BAKE_VERTEX = 2, // Run of per-vertex values
+};
+
+// Start of the file
+struct BakeFileHeader {
+    char magic[4]; // BAKE_FILE_MAGIC
+    uint32_t version; // BAKE_FILE_VERSION
+    uint32_t fileSize; // Bytes in the file
+    uint32_t sceneHash; // BakeFileHash of the scene file it was baked from
+    uint32_t objectCount, objectOffset; // Object table
+    uint32_t faceSize; // Texels across one cube face
+    uint32_t atlasWidth, atlasHeight, atlasOffset; // Lightmap atlas
+    uint32_t vertexCount, vertexOffset; // Per-vertex values
+    uint32_t samples; // Ambient occlusion rays per value, for reporting
+};
+static_assert(sizeof(BakeFileHeader) == 52, "BakeFileHeader must have no padding"); // Check layout
+
+// Where one scene object's values are
+struct BakeFileObject {
+    uint32_t kind; // BakeKind
+    uint32_t first; // BAKE_LIGHTMAP: tile's left texel column; BAKE_VERTEX: first vertex value
+    uint32_t second; // BAKE_LIGHTMAP: tile's bottom texel row; BAKE_VERTEX: vertex count
+};
+static_assert(sizeof(BakeFileObject) == 12, "BakeFileObject must have no padding"); // Check layout
+
+// FNV-1a hash of a scene file's bytes, so a bake is only used with the exact scene it was traced from
+inline uint32_t BakeFileHash(const void* data, size_t size) {
+    const unsigned char* bytes = (const unsigned char*)data; // Bytes
+    uint32_t hash = 2166136261u; // Offset basis
+    for (size_t i = 0; i < size; i++) { // Iterate over bytes
+        hash ^= bytes[i]; // Mix in byte
+        hash *= 16777619u; // FNV prime
+    }
+    return hash; // Return hash
+}
@@ -0,0 +1,190 @@
+// Baked Lighting
+
+#pragma once
+
+#include <cstring> // Include cstring for memcmp
+#include <fstream> // Include fstream
+#include <iostream> // Include iostream
+#include <iterator> // Include istreambuf_iterator
+#include <vector> // Include vector
+
+#include <GL/glew.h> // Include glew
+
+#include "GLState.h" // Include GL state cache
+#include "BakeFile.h" // Include bake file format
+#include "SceneFile.h" // Include scene file format
+
+const GLuint BAKED_ATLAS_UNIT = 5; // Lightmap atlas, sampled by the fragment stages
+const GLuint BAKED_OBJECTS_UNIT = 6; // Bake entry per object, read by the vertex stages
+const GLuint BAKED_VERTICES_UNIT = 7; // Per-vertex values, read by the vertex stages
+
+// Ambient occlusion and key light visibility traced offline by lightbake for objects that never move. Each
+// object has a uvec4 entry in a buffer texture that its vertex stage reads: the kind of bake, then the
+// lightmap tile's corner and face size for cubes, or the first per-vertex value for models. Vertex stages
+// pass the face and texel (or the vertex's values) on, and the fragment stages scale ambient light by the
+// occlusion and the key light by the visibility. Objects with no entry are lit exactly as before.
+//
+// Textures are always created, empty until a bake is loaded, so the shaders never read an unbound unit. An
+// object that starts moving is unbaked and falls back to the shadow map; shadows it cast into its static
+// neighbours' bake stay where they were until the scene is baked again.
+class BakedLighting {
+public:
+    // Creates an empty table for objectCount objects
+    BakedLighting(GLuint objectCount) : objectCount(objectCount), lightmapped(0), perVertex(0) {
+        GLStateCache& state = GLStateCache::Get(); // State cache
+        std::vector<GLuint> entries(objectCount * 4 + 4, 0); // Nothing baked [at least one entry]
+        glGenBuffers(1, &this->objectBuffer); // Entry per object
+        state.BindBuffer(GL_TEXTURE_BUFFER, this->objectBuffer); // Bind buffer
+        glBufferData(GL_TEXTURE_BUFFER, entries.size() * sizeof(GLuint), &entries[0], GL_STATIC_DRAW); // Upload
+        glGenBuffers(1, &this->vertexBuffer); // Per-vertex values
+        state.BindBuffer(GL_TEXTURE_BUFFER, this->vertexBuffer); // Bind buffer
+        glBufferData(GL_TEXTURE_BUFFER, 4, NULL, GL_STATIC_DRAW); // Placeholder until loaded
+        glGenTextures(1, &this->objects); // Entry view
+        state.BindTexture(BAKED_OBJECTS_UNIT, GL_TEXTURE_BUFFER, this->objects); // Bind texture
+        glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32UI, this->objectBuffer); // Four uints per texel
+        glGenTextures(1, &this->vertices); // Value view
+        state.BindTexture(BAKED_VERTICES_UNIT, GL_TEXTURE_BUFFER, this->vertices); // Bind texture
+        glTexBuffer(GL_TEXTURE_BUFFER, GL_RG8, this->vertexBuffer); // Two normalized bytes per texel
+        glGenTextures(1, &this->atlas); // Lightmap atlas
+        state.BindTexture(BAKED_ATLAS_UNIT, GL_TEXTURE_2D, this->atlas); // Bind texture
+        GLubyte white[2] = { 255, 255 }; // Unoccluded and lit
+        upload(1, 1, white); // Placeholder until loaded
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR); // Bilinear inside each face
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    }
+
+    // Destructor
+    ~BakedLighting() {
+        this->Release(); // Deallocate, if not done yet
+    }
+
+    // Deallocates the GL objects. Call while the context is still current; the destructor then does nothing.
+    void Release() {
+        if (!this->objectBuffer) // If already released
+            return;
+        glDeleteTextures(1, &this->objects); // Deallocate views
+        glDeleteTextures(1, &this->vertices);
+        glDeleteTextures(1, &this->atlas); // Deallocate atlas
+        glDeleteBuffers(1, &this->objectBuffer); // Deallocate buffers
+        glDeleteBuffers(1, &this->vertexBuffer);
+        this->objects = this->vertices = this->atlas = 0; // Nothing left to delete
+        this->objectBuffer = this->vertexBuffer = 0;
+    }
+
+    // Loads a bake of scene. sceneObjects maps each scene object to its object index, SCENE_FILE_NONE for
+    // group nodes. Prints an error and returns false, leaving everything unbaked, if the file is missing,
+    // damaged, or was baked from a different scene file.
+    bool Load(const char* path, const SceneFile& scene, const std::vector<GLuint>& sceneObjects) {
+        std::ifstream file(path, std::ios::binary); // Bake file
+        if (!file) { // If missing
+            std::cout << "ERROR::BAKE::FILE_NOT_READ " << path << std::endl; // Print error
+            return false;
+        }
+        std::vector<char> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>()); // Whole file, small
+        if (bytes.size() < sizeof(BakeFileHeader) || memcmp(&bytes[0], BAKE_FILE_MAGIC, 4) != 0) { // If not a bake file
+            std::cout << "ERROR::BAKE::NOT_A_BAKE_FILE " << path << std::endl; // Print error
+            return false;
+        }
+        BakeFileHeader header; // Header
+        memcpy(&header, &bytes[0], sizeof(header)); // Copy, vector data is not promised 4-byte alignment
+        if (header.version != BAKE_FILE_VERSION) { // If written by another lightbake
+            std::cout << "ERROR::BAKE::VERSION " << header.version << " (expected " << BAKE_FILE_VERSION << ") " << path << std::endl; // Print error
+            return false;
+        }
+        if (header.fileSize != bytes.size() ||
+            !fits(bytes.size(), header.objectOffset, header.objectCount, sizeof(BakeFileObject)) ||
+            !fits(bytes.size(), header.atlasOffset, header.atlasWidth * header.atlasHeight, 2) ||
+            !fits(bytes.size(), header.vertexOffset, header.vertexCount, 2)) { // If a table runs off the end
+            std::cout << "ERROR::BAKE::TRUNCATED " << path << std::endl; // Print error
+            return false;
+        }
+        if (header.sceneHash != BakeFileHash(scene.Data(), scene.Size()) || header.objectCount != sceneObjects.size()) { // If the scene changed since
+            std::cout << "ERROR::BAKE::STALE " << path << " was baked from another scene, run lightbake again" << std::endl; // Print error
+            return false;
+        }
+
+        // Entries by object index
+        std::vector<BakeFileObject> records(header.objectCount); // Object table
+        if (header.objectCount) // If any objects
+            memcpy(&records[0], &bytes[header.objectOffset], header.objectCount * sizeof(BakeFileObject)); // Copy
+        std::vector<GLuint> entries(this->objectCount * 4 + 4, 0); // Nothing baked unless listed
+        for (size_t o = 0; o < records.size(); o++) { // Iterate over scene objects
+            GLuint object = sceneObjects[o]; // Object index
+            const BakeFileObject& record = records[o]; // Its bake
+            if (object >= this->objectCount || record.kind == BAKE_NONE) // If a group node or not baked
+                continue;
+            if (record.kind == BAKE_LIGHTMAP && (record.first + 3 * header.faceSize > header.atlasWidth || record.second + 2 * header.faceSize > header.atlasHeight)) // If the tile is off the atlas
+                continue;
+            if (record.kind == BAKE_VERTEX && (record.first > header.vertexCount || record.second > header.vertexCount - record.first)) // If the run is off the end
+                continue;
+            entries[object * 4] = record.kind; // Kind
+            entries[object * 4 + 1] = record.first; // Tile column or first value
+            entries[object * 4 + 2] = record.second; // Tile row or value count
+            entries[object * 4 + 3] = header.faceSize; // Face size
+            (record.kind == BAKE_LIGHTMAP ? this->lightmapped : this->perVertex)++; // Count
+        }
+
+        // Upload
+        GLStateCache& state = GLStateCache::Get(); // State cache
+        state.BindBuffer(GL_TEXTURE_BUFFER, this->objectBuffer); // Bind buffer
+        glBufferSubData(GL_TEXTURE_BUFFER, 0, entries.size() * sizeof(GLuint), &entries[0]); // Entries
+        if (header.vertexCount) { // If any per-vertex values
+            state.BindBuffer(GL_TEXTURE_BUFFER, this->vertexBuffer); // Bind buffer
+            glBufferData(GL_TEXTURE_BUFFER, header.vertexCount * 2, &bytes[header.vertexOffset], GL_STATIC_DRAW); // Values, the view follows the new storage
+        }
+        if (header.atlasWidth && header.atlasHeight) { // If any lightmaps
+            state.BindTexture(BAKED_ATLAS_UNIT, GL_TEXTURE_2D, this->atlas); // Bind texture
+            upload(header.atlasWidth, header.atlasHeight, &bytes[header.atlasOffset]); // Atlas
+        }
+        std::cout << "Baked lighting: " << this->lightmapped << " lightmapped, " << this->perVertex << " per-vertex objects, " << header.samples << " rays per value from " << path << std::endl; // Report
+        return true;
+    }
+
+    // Drops an object's bake, for objects that start moving
+    void Unbake(GLuint object) {
+        if (object >= this->objectCount) // If out of range
+            return;
+        GLuint none[4] = { BAKE_NONE, 0, 0, 0 }; // Empty entry
+        GLStateCache::Get().BindBuffer(GL_TEXTURE_BUFFER, this->objectBuffer); // Bind buffer
+        glBufferSubData(GL_TEXTURE_BUFFER, object * sizeof(none), sizeof(none), none); // Clear entry
+    }
+
+    // Binds the table, values and atlas to their units
+    void Bind() {
+        GLStateCache& state = GLStateCache::Get(); // State cache
+        state.BindTexture(BAKED_ATLAS_UNIT, GL_TEXTURE_2D, this->atlas); // Atlas
+        state.BindTexture(BAKED_OBJECTS_UNIT, GL_TEXTURE_BUFFER, this->objects); // Entries
+        state.BindTexture(BAKED_VERTICES_UNIT, GL_TEXTURE_BUFFER, this->vertices); // Values
+    }
+
+    // Objects with a lightmap tile
+    GLuint LightmappedCount() const {
+        return this->lightmapped; // Return count
+    }
+
+    // Objects with per-vertex values
+    GLuint PerVertexCount() const {
+        return this->perVertex; // Return count
+    }
+
+private:
+    GLuint objectCount; // Entries in the table
+    GLuint lightmapped, perVertex; // Loaded bakes by kind
+    GLuint objectBuffer, vertexBuffer; // Buffer storage
+    GLuint objects, vertices; // Buffer texture views
+    GLuint atlas; // Lightmap atlas
+
+    // True when count records of recordSize bytes at offset lie inside a file of size bytes
+    static bool fits(size_t size, uint32_t offset, uint32_t count, size_t recordSize) {
+        return offset <= size && (uint64_t)count * recordSize <= size - offset; // In bounds
+    }
+
+    // Uploads two-byte texels to the bound 2D texture; rows are always a whole number of texels
+    static void upload(GLuint width, GLuint height, const void* texels) {
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 2); // Rows of RG8 texels are only 2-byte aligned
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RG8, width, height, 0, GL_RG, GL_UNSIGNED_BYTE, texels); // Upload
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4); // Restore default
+    }
+};
@@ -0,0 +1,265 @@
+// Cached Shadow Map
+
+#pragma once
+
+#include <algorithm> // Include algorithm for max
+#include <cmath> // Include cmath for sqrt
+#include <iostream> // Include iostream
+#include <vector> // Include vector
+
+#include <GL/glew.h> // Include glew
+#include <glm/glm.hpp> // Include glm
+#include <glm/gtc/matrix_transform.hpp> // Include glm matrix math
+
+#include "shader.h" // Include shader pipelines
+#include "GLState.h" // Include GL state cache
+#include "VertexLayout.h" // Include vertex layout descriptors
+#include "ObjectConstants.h" // Include object and frame constants
+
+// Texture unit the fragment stages read the shadow cube map from (layout(binding = 4) in lit.frag)
+const GLuint SHADOW_MAP_UNIT = 4;
+const float SHADOW_NORMAL_OFFSET_TEXELS = 5.0f; // Texels receivers are pushed along their normal before the lookup
+const float SHADOW_PCF_TEXELS = 1.5f; // Filter radius in texels
+
+// Shadows from the key light, a point light, in a depth cube map. Casters are split in two sets:
+//   static  -> drawn into a cached cube map only when the light moves or the static set changes
+//   dynamic -> drawn every frame into a copy of the cached map, only on the faces their bounds touch
+// Each frame the faces dynamic casters touched last frame or touch now are restored from the cache with
+// glCopyImageSubData and the dynamic casters are drawn over them. Untouched faces keep last frame's contents,
+// which already equal the cache. With nothing moving a frame costs no shadow draws at all, and otherwise the
+// cost follows the moving casters and the faces they cover, not the size of the scene.
+//
+// Casters start static. An object that moves is made dynamic for good with SetDynamic, which rebuilds the
+// cache once without it. Fragment stages sample the composited map with hardware depth comparison and a few
+// filtered taps (PCF); FrameConstants::shadowParams tells them the projection and filter size.
+class CachedShadowMap {
+public:
+    // Counts for one frame
+    struct FrameStats {
+        unsigned int staticCasters; // Casters in the cached map
+        unsigned int dynamicCasters; // Casters drawn every frame
+        unsigned int rebuilds; // Cache rebuilds so far
+        unsigned int facesRestored; // Faces copied from the cache this frame
+        unsigned int dynamicDraws; // Dynamic caster draws this frame
+    };
+
+    // Constructor. size is the width of each cube face in texels, nearPlane and farPlane bound the light's range.
+    CachedShadowMap(GLuint size = 1024, float nearPlane = 0.05f, float farPlane = 25.0f) : size(size), nearPlane(nearPlane), farPlane(farPlane),
+        enabled(true), staticDirty(true), lightPos(0.0f), touchedFaces(0), framebuffer(0), shader("shadow.vs", "depth.frag") {
+        this->stats = FrameStats(); // Zero counts
+        this->maps[0] = this->createMap(); // Cached static casters
+        this->maps[1] = this->createMap(); // Cache plus this frame's dynamic casters
+        glGenFramebuffers(1, &this->framebuffer); // Depth-only target
+        GLint bound = 0; // Framebuffer to restore
+        glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &bound); // Remember it
+        glBindFramebuffer(GL_FRAMEBUFFER, this->framebuffer); // Bind target
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_CUBE_MAP_POSITIVE_X, this->maps[0], 0); // Attach a face
+        glDrawBuffer(GL_NONE); // No color
+        glReadBuffer(GL_NONE);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) { // If unusable
+            std::cout << "ERROR::SHADOW_MAP::FRAMEBUFFER_INCOMPLETE" << std::endl; // Error message
+            this->enabled = false; // Render without shadows
+        }
+        glBindFramebuffer(GL_FRAMEBUFFER, (GLuint)bound); // Restore framebuffer
+        GLStateCache::Get().Enable(GL_TEXTURE_CUBE_MAP_SEAMLESS); // Filter across face edges
+    }
+
+    // Turns shadows on or off. When off Update draws nothing and tells the fragment stages to skip the lookup.
+    void Enable(bool on) {
+        this->enabled = on; // Set flag
+    }
+
+    // Whether shadows are drawn
+    bool Enabled() const {
+        return this->enabled; // Return flag
+    }
+
+    // Registers one mesh of an object as a caster. min and max are its object-space bounding box.
+    void AddCaster(GLuint objectIndex, const DrawGeometry& geometry, const glm::vec3& min, const glm::vec3& max) {
+        Caster caster = { objectIndex, geometry, (min + max) * 0.5f, glm::length(max - min) * 0.5f, false }; // Caster
+        this->casters.push_back(caster); // Store caster
+        this->staticDirty = true; // Static set changed
+    }
+
+    // Makes every caster of an object dynamic. Its shadow leaves the cache, which is rebuilt once.
+    void SetDynamic(GLuint objectIndex) {
+        for (size_t c = 0; c < this->casters.size(); c++) // Iterate over casters
+            if (this->casters[c].object == objectIndex && !this->casters[c].dynamic) { // If a static caster of the object
+                this->casters[c].dynamic = true; // Draw every frame
+                this->staticDirty = true; // Static set changed
+            }
+    }
+
+    // Renders this frame's shadow map and fills in frame.shadowParams. Call after the frame's object constants
+    // are bound. The draw framebuffer and viewport are restored afterwards.
+    void Update(const glm::vec3& light, const ObjectConstantsStage& objects, FrameConstants& frame) {
+        frame.shadowParams = glm::vec4(this->nearPlane, this->enabled ? this->farPlane : 0.0f, SHADOW_NORMAL_OFFSET_TEXELS * 2.0f / this->size, SHADOW_PCF_TEXELS * 2.0f / this->size); // Fragment stage constants
+        this->stats.facesRestored = 0; // Zero per-frame counts
+        this->stats.dynamicDraws = 0;
+        if (!this->enabled) // If off
+            return;
+        GLStateCache& state = GLStateCache::Get(); // State cache
+        if (light != this->lightPos) { // If the light moved
+            this->lightPos = light; // New light position
+            this->staticDirty = true; // Every face sees something else
+        }
+
+        // Faces each dynamic caster touches this frame
+        GLuint faces = 0; // Faces with dynamic casters
+        this->dynamicFaces.clear(); // Drop last frame's list
+        for (size_t c = 0; c < this->casters.size(); c++) { // Iterate over casters
+            if (!this->casters[c].dynamic) // If static
+                continue;
+            GLuint mask = this->faceMask(this->casters[c], objects.GetModel(this->casters[c].object)); // Faces it covers
+            this->dynamicFaces.push_back(mask); // Remember for drawing
+            faces |= mask; // Accumulate
+        }
+        if (!this->staticDirty && faces == 0 && this->touchedFaces == 0) { // If nothing to do
+            state.BindTexture(SHADOW_MAP_UNIT, GL_TEXTURE_CUBE_MAP, this->maps[1]); // Last frame's map is current
+            return;
+        }
+
+        GLint bound = 0; // Framebuffer to restore
+        glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &bound); // Remember it
+        GLint viewport[4]; // Viewport to restore
+        glGetIntegerv(GL_VIEWPORT, viewport); // Remember it
+        glBindFramebuffer(GL_FRAMEBUFFER, this->framebuffer); // Draw into the shadow map
+        glViewport(0, 0, this->size, this->size); // Whole face
+        state.Enable(GL_DEPTH_TEST); // Depth test
+        state.DepthMask(GL_TRUE); // Depth writes
+        state.DepthFunc(GL_LESS); // Nearest caster wins
+        state.BindTexture(SHADOW_MAP_UNIT, GL_TEXTURE_CUBE_MAP, 0); // Never sample a map while drawing it
+        this->shader.Use(); // Shadow pipeline
+
+        GLuint restore = this->touchedFaces | faces; // Faces whose old dynamic shadows must go
+        if (this->staticDirty) { // If the cache is stale
+            std::vector<GLuint> staticFaces(this->casters.size(), 0); // Face mask per caster, 0 for dynamic ones
+            this->stats.staticCasters = 0; // Recount
+            for (size_t c = 0; c < this->casters.size(); c++) { // Iterate over casters
+                if (this->casters[c].dynamic) // If dynamic
+                    continue;
+                staticFaces[c] = this->faceMask(this->casters[c], objects.GetModel(this->casters[c].object)); // Faces it covers
+                this->stats.staticCasters++; // Count static
+            }
+            for (GLuint f = 0; f < 6; f++) { // Iterate over faces
+                this->bindFace(this->maps[0], f); // Draw into the cache
+                glClear(GL_DEPTH_BUFFER_BIT); // Nothing in range
+                for (size_t c = 0; c < this->casters.size(); c++) // Iterate over casters
+                    if (staticFaces[c] & (1u << f)) // If a static caster on this face
+                        this->drawCaster(this->casters[c]); // Draw it
+            }
+            this->stats.dynamicCasters = (unsigned int)(this->casters.size() - this->stats.staticCasters); // Count dynamic
+            this->stats.rebuilds++; // Count rebuild
+            this->staticDirty = false; // Cache is current
+            restore = 0x3F; // Every face changed
+        }
+        for (GLuint f = 0; f < 6; f++) { // Iterate over faces
+            if (!(restore & (1u << f))) // If the face still equals the cache
+                continue;
+            glCopyImageSubData(this->maps[0], GL_TEXTURE_CUBE_MAP, 0, 0, 0, f, this->maps[1], GL_TEXTURE_CUBE_MAP, 0, 0, 0, f, this->size, this->size, 1); // Cached face
+            this->stats.facesRestored++; // Count copy
+            if (!(faces & (1u << f))) // If no dynamic caster covers it
+                continue;
+            this->bindFace(this->maps[1], f); // Draw into this frame's map
+            size_t d = 0; // Index into dynamicFaces
+            for (size_t c = 0; c < this->casters.size(); c++) { // Iterate over casters
+                if (!this->casters[c].dynamic) // If static
+                    continue;
+                if (this->dynamicFaces[d++] & (1u << f)) { // If it covers this face
+                    this->drawCaster(this->casters[c]); // Draw it
+                    this->stats.dynamicDraws++; // Count draw
+                }
+            }
+        }
+        this->touchedFaces = faces; // Restore these next frame
+
+        glBindFramebuffer(GL_FRAMEBUFFER, (GLuint)bound); // Restore framebuffer
+        glViewport(viewport[0], viewport[1], viewport[2], viewport[3]); // Restore viewport
+        state.BindTexture(SHADOW_MAP_UNIT, GL_TEXTURE_CUBE_MAP, this->maps[1]); // Sampled by the fragment stages
+    }
+
+    // Returns this frame's counts
+    FrameStats Stats() const {
+        return this->stats; // Return counts
+    }
+
+private:
+    // One mesh casting shadows
+    struct Caster {
+        GLuint object; // Index into the object constants
+        DrawGeometry geometry; // Buffers, drawn from the position stream
+        glm::vec3 center; // Object-space bounding sphere center
+        float radius; // Object-space bounding sphere radius
+        bool dynamic; // Drawn every frame instead of cached
+    };
+
+    GLuint size; // Face width in texels
+    float nearPlane, farPlane; // Light's depth range
+    bool enabled; // Shadows on
+    bool staticDirty; // Cache must be rebuilt
+    glm::vec3 lightPos; // Light position the cache was built for
+    GLuint touchedFaces; // Faces dynamic casters were drawn on last frame
+    GLuint maps[2]; // Cached static map, and the map sampled this frame
+    GLuint framebuffer; // Depth-only framebuffer
+    ShaderPipeline shader; // Shadow pipeline
+    std::vector<Caster> casters; // Every caster
+    std::vector<GLuint> dynamicFaces; // Face mask per dynamic caster this frame
+    FrameStats stats; // Counts
+
+    // Creates a depth cube map sampled with hardware comparison
+    GLuint createMap() {
+        GLStateCache& state = GLStateCache::Get(); // State cache
+        GLuint map = 0; // Cube map
+        glGenTextures(1, &map); // Create texture
+        state.BindTexture(SHADOW_MAP_UNIT, GL_TEXTURE_CUBE_MAP, map); // Bind texture
+        glTexStorage2D(GL_TEXTURE_CUBE_MAP, 1, GL_DEPTH_COMPONENT24, this->size, this->size); // Six depth faces
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR); // Filtered comparison, 2x2 PCF per tap
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE); // Lookups return lit fraction
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL); // Lit if no nearer caster
+        return map; // Return map
+    }
+
+    // Attaches one face of a map and sets the light's view and projection for it
+    void bindFace(GLuint map, GLuint face) {
+        static const glm::vec3 directions[6] = { glm::vec3(1, 0, 0), glm::vec3(-1, 0, 0), glm::vec3(0, 1, 0), glm::vec3(0, -1, 0), glm::vec3(0, 0, 1), glm::vec3(0, 0, -1) }; // Face axes
+        static const glm::vec3 ups[6] = { glm::vec3(0, -1, 0), glm::vec3(0, -1, 0), glm::vec3(0, 0, 1), glm::vec3(0, 0, -1), glm::vec3(0, -1, 0), glm::vec3(0, -1, 0) }; // Cube map orientation
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, map, 0); // Attach face
+        glm::mat4 projection = glm::perspective(glm::radians(90.0f), 1.0f, this->nearPlane, this->farPlane); // Quarter turn per face
+        glm::mat4 view = glm::lookAt(this->lightPos, this->lightPos + directions[face], ups[face]); // Look down the face axis
+        this->shader.SetMat4("lightViewProjection", projection * view); // Face transform
+    }
+
+    // Draws one caster's position stream
+    void drawCaster(const Caster& caster) {
+        this->shader.SetUint("objectIndex", caster.object); // Select object constants
+        BindDepthGeometry(caster.geometry); // Bind position stream
+        if (caster.geometry.ebo != 0) // If indexed
+            glDrawElements(GL_TRIANGLES, caster.geometry.count, GL_UNSIGNED_INT, 0); // Draw elements
+        else
+            glDrawArrays(GL_TRIANGLES, 0, caster.geometry.count); // Draw arrays
+    }
+
+    // Bit per cube face (+x, -x, +y, -y, +z, -z) whose frustum the caster's bounding sphere reaches
+    GLuint faceMask(const Caster& caster, const glm::mat4& model) const {
+        glm::vec3 center = glm::vec3(model * glm::vec4(caster.center, 1.0f)) - this->lightPos; // Sphere center from the light
+        float scale = sqrt(std::max(glm::dot(glm::vec3(model[0]), glm::vec3(model[0])), std::max(glm::dot(glm::vec3(model[1]), glm::vec3(model[1])), glm::dot(glm::vec3(model[2]), glm::vec3(model[2]))))); // Largest axis scale
+        float radius = caster.radius * scale; // World radius
+        if (glm::length(center) - radius > this->farPlane) // If out of the light's range
+            return 0;
+        float slack = radius * 1.41421356f; // A side plane of a face is at 45 degrees
+        GLuint mask = 0; // Faces reached
+        for (int axis = 0; axis < 3; axis++) { // Iterate over axes
+            float a = center[(axis + 1) % 3], b = center[(axis + 2) % 3]; // The other two components
+            for (int sign = 0; sign < 2; sign++) { // Positive then negative face
+                float along = sign ? -center[axis] : center[axis]; // Distance down the face axis
+                if (along + radius > this->nearPlane && along + slack >= std::fabs(a) && along + slack >= std::fabs(b)) // If inside the face's pyramid
+                    mask |= 1u << (axis * 2 + sign); // Face reached
+            }
+        }
+        return mask; // Return faces
+    }
+};
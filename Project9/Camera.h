@@ -4,6 +4,7 @@
 #include <GL/glew.h> // Glew include
 #include <glm/glm.hpp> // GLM include
 #include <glm/gtc/matrix_transform.hpp> // Matrix transform include
+#include <glm/gtc/quaternion.hpp> // Quaternion include
 
 #include <vector> // Include vector
 
@@ -28,116 +29,288 @@ const float YAW = -90.0f; // Initialize yaw [flip screen to normal]
 const float PITCH = 0.0f; // Initailize pitch
 const float ROLL = 0.0f; // Initialize roll
 const float SPEED = 2.5f; // Initialize speed
+const float TURN = 2.0f; // Degrees turned per rotation input
+const float FOVY = 45.0f; // Initialize vertical field of view [as passed to glm::perspective]
+const float NEAR_PLANE = 0.1f; // Initialize near plane distance
+const float FAR_PLANE = 100.0f; // Initialize far plane distance
 
 
-// An abstract camera class that processes input and calculates the corresponding Euler Angles, Vectors and Matrices for use in OpenGL
+// An abstract camera class that processes input and keeps its orientation as a quaternion. Rotation inputs turn
+// it about its own axes. The direction vectors and the view, projection and view-projection matrices are
+// derived lazily and cached: each is rebuilt only when something it depends on changed, so asking a camera that
+// has not moved for its matrices costs a flag check.
 class Camera
 {
 public:
-	// Camera Attributes
-	glm::vec3 Position; // Position vector
-	glm::vec3 Front; // Front dir vector
-	glm::vec3 Up; // Up dir vector
-	glm::vec3 Right; // Right dir vector
-	glm::vec3 WorldUp; // WorldUp vector
-	// Euler Angles
-	float Yaw; // yaw
-	float Pitch; // pitch
-	float Roll; // roll
 	// Camera options
 	float MovementSpeed; // speed for translation
 
 	// Constructor with vectors
-	Camera(glm::vec3 position = glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3 up = glm::vec3(0.0f, 1.0f, 0.0f), float yaw = YAW, float pitch = PITCH, float roll = ROLL) : Front(glm::vec3(0.0f, 0.0f, -1.0f)), MovementSpeed(SPEED)
+	Camera(glm::vec3 position = glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3 up = glm::vec3(0.0f, 1.0f, 0.0f), float yaw = YAW, float pitch = PITCH, float roll = ROLL) : MovementSpeed(SPEED), Fovy(FOVY), Aspect(1.0f), NearPlane(NEAR_PLANE), FarPlane(FAR_PLANE),
+		vectorsDirty(true), viewDirty(true), projectionDirty(true), viewProjectionDirty(true)
 	{
 		Position = position; // Set position based on input
-		WorldUp = up; // Set up reference based on input
-		Yaw = yaw; // Set yaw based on input
-		Pitch = pitch; // Set pitch based on input
-		Roll = roll; // Set roll based on input
-		updateCameraVectors(); // Call class method to set front, right, and up vectors
+		Orientation = orientationFromEuler(up, yaw, pitch, roll); // Set rotation based on input
 	}
 	// Constructor with scalar values
-	Camera(float posX, float posY, float posZ, float upX, float upY, float upZ, float yaw, float pitch, float roll) : Front(glm::vec3(0.0f, 0.0f, -1.0f)), MovementSpeed(SPEED)
+	Camera(float posX, float posY, float posZ, float upX, float upY, float upZ, float yaw, float pitch, float roll) : MovementSpeed(SPEED), Fovy(FOVY), Aspect(1.0f), NearPlane(NEAR_PLANE), FarPlane(FAR_PLANE),
+		vectorsDirty(true), viewDirty(true), projectionDirty(true), viewProjectionDirty(true)
 	{
 		Position = glm::vec3(posX, posY, posZ); // Set position elements manually from input
-		WorldUp = glm::vec3(upX, upY, upZ); // Set WorldUp elements manually from input
-		Yaw = yaw; // Set yaw based on input
-		Pitch = pitch; // Set pitch based on input
-		Roll = roll; // Set roll based on input
-		updateCameraVectors(); // Call class method to set front, right, and up vectors
+		Orientation = orientationFromEuler(glm::vec3(upX, upY, upZ), yaw, pitch, roll); // Set rotation manually from input
+	}
+
+	// Sets the projection; the cached matrices are only rebuilt if a value differs
+	void SetPerspective(float fovy, float aspect, float nearPlane, float farPlane)
+	{
+		if (fovy == Fovy && aspect == Aspect && nearPlane == NearPlane && farPlane == FarPlane) // If unchanged
+			return;
+		Fovy = fovy; // Set field of view
+		Aspect = aspect; // Set width over height
+		NearPlane = nearPlane; // Set near plane
+		FarPlane = farPlane; // Set far plane
+		projectionDirty = true; // Rebuild on next use
+	}
+
+	// Makes this camera the blend of a previous camera state and a current one, alpha = 0 being previous. Used to
+	// draw a camera that only moves on fixed simulation ticks smoothly at any frame rate. When the blend lands on
+	// the state this camera already holds, its cached matrices stay valid. Returns true if the camera moved or turned.
+	bool Blend(const Camera& previous, const Camera& current, float alpha)
+	{
+		glm::vec3 position = current.Position; // Blended position
+		glm::quat orientation = current.Orientation; // Blended rotation
+		if (alpha < 1.0f && previous.Position != current.Position) // If moving between ticks
+			position = glm::mix(previous.Position, current.Position, alpha); // Blend position
+		if (alpha < 1.0f && previous.Orientation != current.Orientation) // If turning between ticks
+			orientation = glm::slerp(previous.Orientation, current.Orientation, alpha); // Blend rotation along the shortest arc
+		bool moved = position != Position || orientation != Orientation; // Whether the view changes
+		setPosition(position); // Set position, dirty only if it differs
+		setOrientation(orientation); // Set rotation, dirty only if it differs
+		SetPerspective(current.Fovy, current.Aspect, current.NearPlane, current.FarPlane); // Same projection as the current state
+		return moved; // Returns whether it moved
 	}
 
-	// Returns the view matrix calculated using Euler Angles and the LookAt Matrix
-	glm::mat4 GetViewMatrix()
+	// Places the camera, for example at a pose played back from a recorded path. Returns true if it moved or turned.
+	bool SetPose(const glm::vec3& position, const glm::quat& orientation)
 	{
-		return glm::lookAt(Position, Position + Front, Up); // Returns lookAt output using Posiiton, Position + Front, and Up
+		bool moved = position != Position || orientation != Orientation; // Whether the view changes
+		setPosition(position); // Set position, dirty only if it differs
+		setOrientation(orientation); // Set rotation, dirty only if it differs
+		return moved; // Returns whether it moved
+	}
+
+	// Position in world space
+	const glm::vec3& GetPosition() const
+	{
+		return Position; // Returns position
+	}
+
+	// Rotation from camera space [looking down -z with y up] to world space
+	const glm::quat& GetOrientation() const
+	{
+		return Orientation; // Returns rotation
+	}
+
+	// Direction the camera looks in
+	const glm::vec3& GetFront() const
+	{
+		updateCameraVectors(); // Derive if stale
+		return Front; // Returns front
+	}
+
+	// Camera's right
+	const glm::vec3& GetRight() const
+	{
+		updateCameraVectors(); // Derive if stale
+		return Right; // Returns right
+	}
+
+	// Camera's up
+	const glm::vec3& GetUp() const
+	{
+		updateCameraVectors(); // Derive if stale
+		return Up; // Returns up
+	}
+
+	// Distance to the near plane
+	float GetNearPlane() const
+	{
+		return NearPlane; // Returns near plane
+	}
+
+	// Distance to the far plane
+	float GetFarPlane() const
+	{
+		return FarPlane; // Returns far plane
+	}
+
+	// Returns the view matrix, rebuilt from the rotation and position only when either changed
+	const glm::mat4& GetViewMatrix() const
+	{
+		if (viewDirty) { // If moved or turned
+			View = glm::mat4_cast(glm::conjugate(Orientation)); // Rotation from world to camera space
+			View[3] = View * glm::vec4(-Position, 1.0f); // Followed by moving the eye to the origin
+			viewDirty = false; // Cached
+			viewProjectionDirty = true; // Product is stale
+		}
+		return View; // Returns view
+	}
+
+	// Returns the projection matrix, rebuilt only when SetPerspective changed it
+	const glm::mat4& GetProjectionMatrix() const
+	{
+		if (projectionDirty) { // If the projection changed
+			Projection = glm::perspective(Fovy, Aspect, NearPlane, FarPlane); // Rebuild projection
+			projectionDirty = false; // Cached
+			viewProjectionDirty = true; // Product is stale
+		}
+		return Projection; // Returns projection
+	}
+
+	// Returns projection * view
+	const glm::mat4& GetViewProjectionMatrix() const
+	{
+		GetViewMatrix(); // Refresh view if stale
+		GetProjectionMatrix(); // Refresh projection if stale
+		if (viewProjectionDirty) { // If either changed
+			ViewProjection = Projection * View; // Rebuild product
+			ExtractFrustumPlanes(ViewProjection, Planes); // Planes follow the product
+			viewProjectionDirty = false; // Cached
+		}
+		return ViewProjection; // Returns view-projection
+	}
+
+	// Returns the six world-space frustum planes: left, right, bottom, top, near, far. A point p is inside
+	// plane n when dot(n, vec4(p, 1)) >= 0. The planes are not normalized.
+	const glm::vec4* GetFrustumPlanes() const
+	{
+		GetViewProjectionMatrix(); // Refresh planes if stale
+		return Planes; // Returns planes
+	}
+
+	// Writes the frustum planes of a view-projection matrix, from the sums and differences of its rows
+	static void ExtractFrustumPlanes(const glm::mat4& viewProjection, glm::vec4 planes[6])
+	{
+		glm::vec4 w(viewProjection[0][3], viewProjection[1][3], viewProjection[2][3], viewProjection[3][3]); // Row 3
+		for (int i = 0; i < 3; i++) { // Iterate over x, y, z
+			glm::vec4 row(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]); // Row i
+			planes[i * 2] = w + row; // -w <= clip
+			planes[i * 2 + 1] = w - row; // clip <= w
+		}
 	}
 
 	// Processes input received from any keyboard-like input system. Accepts input parameter in the form of camera defined ENUM (to abstract it from windowing systems)
 	void ProcessKeyboard(Camera_Movement direction, float deltaTime)
 	{
-		// Defines all directions
+		// Translations only move the position; rotations only turn the quaternion about one of the camera's axes
 		float velocity = MovementSpeed * deltaTime; // Calculate velocity using speed and time
-		if (direction == FORWARD) // If forward direction
-			Position += Front * velocity; // Add front * velocity to position
-		if (direction == BACKWARD) // If backward
-			Position -= Front * velocity; // Subtract front * velocity from position
-		if (direction == LEFT) // If left
-			Position -= Right * velocity; // Subtract Right * velocity from position
-		if (direction == RIGHT) // If right
-			Position += Right * velocity; // Add right * velocity to position
-		if (direction == UP) // If up
-			Position += Up * velocity; // Add up * velocity to position
-		if (direction == DOWN) // If down
-			Position -= Up * velocity; // Subtract up * velocity to position
-		if (direction == UPPITCH) // If up pitch
-			Pitch += 2.0f; // Increment pitch by 2 [degrees]
-			updateCameraVectors(); // Update rotation using callback
-		if (direction == DOWNPITCH) // If down pitch
-			Pitch -= 2.0f; // Decrement pitch by 2 [degrees]
-			updateCameraVectors(); // Update rotation using callback
-		if (direction == UPYAW) // If up yaw
-			Yaw += 2.0f; // Increment yaw by 2 [degrees]
-			updateCameraVectors(); // Update rotation using callback
-		if (direction == DOWNYAW) // If down yaw
-			Yaw -= 2.0f; // Decrement yaw by 2 [degrees]
-			updateCameraVectors(); // Update rotation using callback
-		if (direction == UPROLL) // If up roll
-			Roll += 2.0f; // Increment roll by 2 [degrees]
-			updateCameraVectors(); // Update rotation using callback
-		if (direction == DOWNROLL) // If down roll
-			Roll -= 2.0f; // Decrement roll by 2 [degrees]
-			updateCameraVectors(); // Update rotation using callback
-	}
-
-	// Resets camera position and rotation vectors
+		switch (direction) {
+		case FORWARD: // If forward direction
+			setPosition(Position + GetFront() * velocity); // Add front * velocity to position
+			break;
+		case BACKWARD: // If backward
+			setPosition(Position - GetFront() * velocity); // Subtract front * velocity from position
+			break;
+		case LEFT: // If left
+			setPosition(Position - GetRight() * velocity); // Subtract Right * velocity from position
+			break;
+		case RIGHT: // If right
+			setPosition(Position + GetRight() * velocity); // Add right * velocity to position
+			break;
+		case UP: // If up
+			setPosition(Position + GetUp() * velocity); // Add up * velocity to position
+			break;
+		case DOWN: // If down
+			setPosition(Position - GetUp() * velocity); // Subtract up * velocity to position
+			break;
+		case UPPITCH: // If up pitch
+			turn(TURN, glm::vec3(1.0f, 0.0f, 0.0f)); // Tilt front towards up
+			break;
+		case DOWNPITCH: // If down pitch
+			turn(-TURN, glm::vec3(1.0f, 0.0f, 0.0f)); // Tilt front towards down
+			break;
+		case UPYAW: // If up yaw
+			turn(-TURN, glm::vec3(0.0f, 1.0f, 0.0f)); // Swing front towards right
+			break;
+		case DOWNYAW: // If down yaw
+			turn(TURN, glm::vec3(0.0f, 1.0f, 0.0f)); // Swing front towards left
+			break;
+		case UPROLL: // If up roll
+			turn(TURN, glm::vec3(0.0f, 0.0f, -1.0f)); // Lean up towards right
+			break;
+		case DOWNROLL: // If down roll
+			turn(-TURN, glm::vec3(0.0f, 0.0f, -1.0f)); // Lean up towards left
+			break;
+		}
+	}
+
+	// Resets camera position and rotation
 	void ResetCamera() {
-		Position = glm::vec3(0.0f, 0.0f, 0.0f); // Resets position
-		WorldUp = glm::vec3(0.0f, 1.0f, 0.0f); // Resets worldup vector
-		Yaw = YAW; // Resets yaw
-		Pitch = PITCH; // Resets pitch
-		Roll = ROLL; // Resets roll
-		updateCameraVectors(); // Updates rotation with reset values using callback
+		setPosition(glm::vec3(0.0f, 0.0f, 0.0f)); // Resets position
+		setOrientation(orientationFromEuler(glm::vec3(0.0f, 1.0f, 0.0f), YAW, PITCH, ROLL)); // Resets rotation
 	}
 
 private:
-	// Calculates the front vector from the Camera's (updated) Euler Angles
-	void updateCameraVectors()
+	// Camera Attributes
+	glm::vec3 Position; // Position vector
+	glm::quat Orientation; // Unit rotation quaternion
+	float Fovy, Aspect, NearPlane, FarPlane; // Perspective projection
+	// Derived from the attributes on demand
+	mutable glm::vec3 Front; // Front dir vector
+	mutable glm::vec3 Up; // Up dir vector
+	mutable glm::vec3 Right; // Right dir vector
+	mutable glm::mat4 View, Projection, ViewProjection; // Matrices
+	mutable glm::vec4 Planes[6]; // Frustum planes of ViewProjection
+	mutable bool vectorsDirty, viewDirty, projectionDirty, viewProjectionDirty; // Stale derived values
+
+	// Moves the camera, invalidating the view if it moved
+	void setPosition(const glm::vec3& position)
+	{
+		if (position == Position) // If unchanged
+			return;
+		Position = position; // Set position
+		viewDirty = true; // Rebuild on next use
+	}
+
+	// Turns the camera, invalidating the vectors and view if it turned
+	void setOrientation(const glm::quat& orientation)
+	{
+		if (orientation == Orientation) // If unchanged
+			return;
+		Orientation = orientation; // Set rotation
+		vectorsDirty = viewDirty = true; // Rebuild on next use
+	}
+
+	// Rotates by degrees about an axis given in camera space
+	void turn(float degrees, const glm::vec3& axis)
+	{
+		setOrientation(glm::normalize(Orientation * glm::angleAxis(glm::radians(degrees), axis))); // Renormalize so error does not build up
+	}
+
+	// Recalculates the front, right and up vectors from the rotation if it changed
+	void updateCameraVectors() const
+	{
+		if (!vectorsDirty) // If current
+			return;
+		Front = Orientation * glm::vec3(0.0f, 0.0f, -1.0f); // Camera looks down -z
+		Right = Orientation * glm::vec3(1.0f, 0.0f, 0.0f); // Camera's x
+		Up = Orientation * glm::vec3(0.0f, 1.0f, 0.0f); // Camera's y
+		vectorsDirty = false; // Cached
+	}
+
+	// Rotation for Euler angles in degrees: yaw and pitch aim the front as before, with right level against
+	// worldUp, then roll turns the camera about its front
+	static glm::quat orientationFromEuler(const glm::vec3& worldUp, float yaw, float pitch, float roll)
 	{
-		// Calculate the new Front vector
 		glm::vec3 front; // Initialize front
-		front.x = cos(glm::radians(Yaw)) * cos(glm::radians(Pitch)); // Define x value for front using cos(Yaw) * cos(Pitch)
-		front.y = sin(glm::radians(Pitch));// Define y value for front using sin(pitch)
-		front.z = sin(glm::radians(Yaw)) * cos(glm::radians(Pitch)); // Define z value for front using sin(Yaw) * cos(Pitch)
-		Front = glm::normalize(front); // Normalize vector
-		// // Also re-calculate the Right and Up vector --> normalize right and up and cross product with Front
-		Right = glm::normalize(glm::cross(Front, WorldUp));  // Normalize the vectors, because their length gets closer to 0 the more you look up or down which results in slower movement.
-		Up = glm::normalize(glm::cross(Right, Front)); // Normalize the cross product of Right and Front
-		Up.x = sin(glm::radians(Roll)); // Set x of Up to sin(Roll)
-		Up.y = cos(glm::radians(Roll)); // Set y of Up to cos(Roll)
-		Up = glm::normalize(Up); // Normalize new Up
-		Right = glm::normalize(glm::cross(Front, Up)); // Reset Right to reflect new Up axis vector
+		front.x = cos(glm::radians(yaw)) * cos(glm::radians(pitch)); // Define x value for front using cos(Yaw) * cos(Pitch)
+		front.y = sin(glm::radians(pitch)); // Define y value for front using sin(pitch)
+		front.z = sin(glm::radians(yaw)) * cos(glm::radians(pitch)); // Define z value for front using sin(Yaw) * cos(Pitch)
+		front = glm::normalize(front); // Normalize vector
+		glm::vec3 right = glm::normalize(glm::cross(front, worldUp)); // Level right
+		glm::vec3 up = glm::cross(right, front); // Up completes the basis
+		glm::quat aim = glm::normalize(glm::quat_cast(glm::mat3(right, up, -front))); // Columns are the camera's axes in world space
+		return glm::normalize(aim * glm::angleAxis(glm::radians(roll), glm::vec3(0.0f, 0.0f, -1.0f))); // Roll about front
 	}
 };
 #endif
@@ -0,0 +1,164 @@
+// Camera Path
+
+#pragma once
+
+#include <cstdint> // Include fixed-width integers
+#include <cstring> // Include cstring for memcmp
+#include <fstream> // Include fstream
+#include <iostream> // Include iostream
+#include <iterator> // Include istreambuf_iterator
+#include <vector> // Include vector
+
+#include <glm/glm.hpp> // Include glm
+#include <glm/gtc/quaternion.hpp> // Include glm quaternions
+
+// Binary camera path, written by p9 --record and played back by p9 --benchmark. Time is counted in simulation
+// ticks, so playback can show tick n on frame n whatever the frame rate. A sample is only stored on ticks where
+// the camera moved; between samples it holds still. Fields are little-endian and 4-byte aligned. Bump
+// CAMERA_PATH_VERSION whenever a record changes.
+//
+//   CameraPathHeader
+//   CameraPathSample[sampleCount]    right after the header, ticks increasing
+
+const char CAMERA_PATH_MAGIC[4] = { 'P', '9', 'C', 'P' }; // First bytes of every camera path file
+const uint32_t CAMERA_PATH_VERSION = 1; // Current format version
+
+// Start of the file
+struct CameraPathHeader {
+    char magic[4]; // CAMERA_PATH_MAGIC
+    uint32_t version; // CAMERA_PATH_VERSION
+    uint32_t fileSize; // Bytes in the file
+    float tickSeconds; // Simulation step the path was recorded at, for reporting
+    uint32_t tickCount; // Ticks recorded, including trailing ones with no motion
+    uint32_t sampleCount; // Samples after the header
+};
+static_assert(sizeof(CameraPathHeader) == 24, "CameraPathHeader must have no padding"); // Check layout
+
+// Camera pose from one tick on
+struct CameraPathSample {
+    uint32_t tick; // Tick the pose was reached, timestamp tick * tickSeconds
+    float position[3]; // Position
+    float orientation[4]; // Rotation quaternion x, y, z, w
+};
+static_assert(sizeof(CameraPathSample) == 32, "CameraPathSample must have no padding"); // Check layout
+
+// Camera poses over time, recorded one tick at a time or loaded from a file
+class CameraPath {
+public:
+    // Creates an empty path for ticks of tickSeconds
+    CameraPath(float tickSeconds) : tickSeconds(tickSeconds), tickCount(0) {}
+
+    // Appends tick number tick, which must follow the last one. A sample is only stored if the pose changed.
+    void Record(uint32_t tick, const glm::vec3& position, const glm::quat& orientation) {
+        this->tickCount = tick + 1; // Path runs to this tick
+        if (!this->samples.empty()) { // If a pose is held
+            const CameraPathSample& last = this->samples.back(); // Held pose
+            if (last.position[0] == position.x && last.position[1] == position.y && last.position[2] == position.z &&
+                last.orientation[0] == orientation.x && last.orientation[1] == orientation.y && last.orientation[2] == orientation.z && last.orientation[3] == orientation.w) // If unchanged
+                return;
+        }
+        CameraPathSample sample = { tick, { position.x, position.y, position.z }, { orientation.x, orientation.y, orientation.z, orientation.w } }; // New pose
+        this->samples.push_back(sample); // Store
+    }
+
+    // Writes the path. Prints an error and returns false on failure.
+    bool Save(const char* path) const {
+        std::ofstream file(path, std::ios::binary); // Path file
+        CameraPathHeader header; // Header
+        memcpy(header.magic, CAMERA_PATH_MAGIC, 4); // Magic
+        header.version = CAMERA_PATH_VERSION; // Version
+        header.fileSize = (uint32_t)(sizeof(header) + this->samples.size() * sizeof(CameraPathSample)); // Size
+        header.tickSeconds = this->tickSeconds; // Step
+        header.tickCount = this->tickCount; // Length
+        header.sampleCount = (uint32_t)this->samples.size(); // Samples
+        file.write((const char*)&header, sizeof(header)); // Header
+        if (!this->samples.empty()) // If any samples
+            file.write((const char*)&this->samples[0], this->samples.size() * sizeof(CameraPathSample)); // Samples
+        if (!file) { // If anything failed
+            std::cout << "ERROR::CAMERA_PATH::FILE_NOT_WRITTEN " << path << std::endl; // Print error
+            return false;
+        }
+        return true;
+    }
+
+    // Reads a path, replacing this one. Prints an error and returns false, leaving the path empty, if the file
+    // is missing, damaged or holds no samples.
+    bool Load(const char* path) {
+        this->samples.clear(); // Drop any previous path
+        this->tickCount = 0;
+        std::ifstream file(path, std::ios::binary); // Path file
+        if (!file) { // If missing
+            std::cout << "ERROR::CAMERA_PATH::FILE_NOT_READ " << path << std::endl; // Print error
+            return false;
+        }
+        std::vector<char> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>()); // Whole file
+        if (bytes.size() < sizeof(CameraPathHeader) || memcmp(&bytes[0], CAMERA_PATH_MAGIC, 4) != 0) { // If not a path file
+            std::cout << "ERROR::CAMERA_PATH::NOT_A_CAMERA_PATH " << path << std::endl; // Print error
+            return false;
+        }
+        CameraPathHeader header; // Header
+        memcpy(&header, &bytes[0], sizeof(header)); // Copy, vector data is not promised 4-byte alignment
+        if (header.version != CAMERA_PATH_VERSION) { // If written by another p9
+            std::cout << "ERROR::CAMERA_PATH::VERSION " << header.version << " (expected " << CAMERA_PATH_VERSION << ") " << path << std::endl; // Print error
+            return false;
+        }
+        if (header.fileSize != bytes.size() || (uint64_t)header.sampleCount * sizeof(CameraPathSample) != bytes.size() - sizeof(header)) { // If samples are missing
+            std::cout << "ERROR::CAMERA_PATH::TRUNCATED " << path << std::endl; // Print error
+            return false;
+        }
+        std::vector<CameraPathSample> loaded(header.sampleCount); // Samples
+        if (header.sampleCount) // If any samples
+            memcpy(&loaded[0], &bytes[sizeof(header)], header.sampleCount * sizeof(CameraPathSample)); // Copy
+        for (size_t s = 0; s < loaded.size(); s++) { // Iterate over samples
+            if (loaded[s].tick >= header.tickCount || (s > 0 && loaded[s].tick <= loaded[s - 1].tick)) { // If out of order or past the end
+                std::cout << "ERROR::CAMERA_PATH::BAD_TICKS " << path << std::endl; // Print error
+                return false;
+            }
+        }
+        if (loaded.empty()) { // If nothing was recorded
+            std::cout << "ERROR::CAMERA_PATH::EMPTY " << path << std::endl; // Print error
+            return false;
+        }
+        this->samples.swap(loaded); // Take samples
+        this->tickCount = header.tickCount; // Length
+        this->tickSeconds = header.tickSeconds; // Step
+        return true;
+    }
+
+    // Pose held at a tick: the last sample at or before it, or the first sample before the path starts
+    void Pose(uint32_t tick, glm::vec3& position, glm::quat& orientation) const {
+        if (this->samples.empty()) // If nothing recorded
+            return;
+        size_t lo = 0, hi = this->samples.size(); // Search [lo, hi) for the first sample after tick
+        while (lo < hi) { // Binary search
+            size_t mid = (lo + hi) / 2; // Middle sample
+            if (this->samples[mid].tick <= tick) // If at or before tick
+                lo = mid + 1; // Look right
+            else
+                hi = mid; // Look left
+        }
+        const CameraPathSample& sample = this->samples[lo ? lo - 1 : 0]; // Pose in effect
+        position = glm::vec3(sample.position[0], sample.position[1], sample.position[2]); // Position
+        orientation = glm::quat(sample.orientation[3], sample.orientation[0], sample.orientation[1], sample.orientation[2]); // Rotation, glm takes w first
+    }
+
+    // Ticks in the path
+    uint32_t TickCount() const {
+        return this->tickCount; // Return length
+    }
+
+    // Stored samples
+    size_t SampleCount() const {
+        return this->samples.size(); // Return count
+    }
+
+    // Seconds per tick the path was recorded at
+    float TickSeconds() const {
+        return this->tickSeconds; // Return step
+    }
+
+private:
+    float tickSeconds; // Seconds per tick
+    uint32_t tickCount; // Ticks recorded
+    std::vector<CameraPathSample> samples; // Poses, ticks increasing
+};
@@ -0,0 +1,264 @@
+// Clustered Lights
+
+#pragma once
+
+#include <algorithm> // Include algorithm for min and max
+#include <cmath> // Include cmath for log
+#include <cstring> // Include cstring for memcpy
+#include <iostream> // Include iostream
+#include <vector> // Include vector
+
+#include <GL/glew.h> // Include glew
+#include <glm/glm.hpp> // Include glm
+
+#include "ObjectConstants.h" // Include FrameConstants and Lane4 helpers
+#include "RingBuffer.h" // Include per-frame ring buffer
+
+// One point light as the fragment stages read it (std430)
+struct PointLight {
+    glm::vec4 positionRadius; // World position, radius of influence in w
+    glm::vec4 color; // Color, w unused
+};
+static_assert(sizeof(PointLight) == 32, "PointLight must match the std430 struct"); // Check layout
+
+// Storage buffer binding points of the clustered lighting buffers. GL 4.3 only guarantees bindings 0-7, and 1 is
+// free in the storage namespace (FrameConstants uses uniform binding 1).
+const GLuint POINT_LIGHT_BINDING = 1; // Every light
+const GLuint LIGHT_CLUSTER_BINDING = 6; // Offset and count per cluster
+const GLuint LIGHT_INDEX_BINDING = 7; // Light indices, grouped by cluster
+
+// Clustered forward lighting. The view frustum is divided into a grid of froxels: screen tiles across and down,
+// and depth slices spaced exponentially so near slices are thin. Every frame each light's sphere is tested against
+// the view-space boxes of the clusters it could touch, four clusters per SSE pass, and the resulting per-cluster
+// light lists are written into the ring buffer. A fragment stage finds its cluster from gl_FragCoord and depth and
+// shades only the lights listed there, so its cost follows the lights near it rather than the total.
+class ClusteredLights {
+public:
+    static const GLuint MAX_LIGHTS = 1024; // Lights one frame can hold
+    static const GLuint MAX_INDICES_PER_CLUSTER = 32; // Average list length budgeted per cluster
+
+    // Constructor. The grid is tilesX by tilesY screen tiles and slices depth slices.
+    ClusteredLights(GLuint tilesX = 16, GLuint tilesY = 9, GLuint slices = 24) : tilesX(tilesX), tilesY(tilesY), slices(slices),
+        width(0), height(0), nearPlane(0.0f), farPlane(0.0f), projection(0.0f), overflowed(false) {
+        this->clusterCount = tilesX * tilesY * slices; // Froxels
+        this->rowStride = (tilesX + 3) & ~3u; // Tiles per row padded to whole SSE passes
+        for (int c = 0; c < 6; c++) // Iterate over box components
+            this->bounds[c].resize(this->rowStride * tilesY * slices, 0.0f); // Padded rows
+        this->counts.resize(this->clusterCount); // Lights per cluster
+        this->ranges.resize(this->clusterCount * 2); // Offset and count per cluster
+    }
+
+    // Removes every light
+    void Clear() {
+        this->lights.clear(); // No lights
+    }
+
+    // Adds a point light and returns its index. Lights past MAX_LIGHTS are ignored.
+    GLuint Add(const glm::vec3& position, float radius, const glm::vec3& color) {
+        if (this->lights.size() >= MAX_LIGHTS) // If full
+            return MAX_LIGHTS;
+        PointLight light = { glm::vec4(position, radius), glm::vec4(color, 0.0f) }; // Light
+        this->lights.push_back(light); // Store light
+        return (GLuint)this->lights.size() - 1; // Return index
+    }
+
+    // Moves a light
+    void SetPosition(GLuint index, const glm::vec3& position) {
+        this->lights[index].positionRadius = glm::vec4(position, this->lights[index].positionRadius.w); // Keep radius
+    }
+
+    // Number of lights
+    GLuint Count() const {
+        return (GLuint)this->lights.size(); // Return count
+    }
+
+    // Ring buffer bytes one Update can allocate
+    GLsizeiptr FrameBytes() const {
+        return MAX_LIGHTS * sizeof(PointLight) + this->clusterCount * 2 * sizeof(GLuint) +
+               this->clusterCount * MAX_INDICES_PER_CLUSTER * sizeof(GLuint) + 3 * 256; // Three tables plus alignment
+    }
+
+    // Assigns lights to clusters for this view, writes the tables into the ring buffer, binds them and fills the
+    // cluster fields of the frame constants. width and height are the render target size in pixels.
+    void Update(const glm::mat4& view, const glm::mat4& projection, GLuint width, GLuint height, float nearPlane, float farPlane,
+                RingBuffer& ring, FrameConstants& frame) {
+        if (width != this->width || height != this->height || nearPlane != this->nearPlane || farPlane != this->farPlane || projection != this->projection) { // If the frustum changed
+            this->width = width; // Remember size
+            this->height = height;
+            this->nearPlane = nearPlane; // Remember depth range
+            this->farPlane = farPlane;
+            this->projection = projection; // Remember projection
+            this->buildBounds(); // Recompute cluster boxes
+        }
+        float sliceScale = this->slices / std::log(farPlane / nearPlane); // Slices per unit of log depth
+        float sliceBias = this->slices * std::log(nearPlane) / std::log(farPlane / nearPlane); // Slice of depth 1 is -bias
+        this->assign(view, sliceScale, sliceBias); // Build light lists
+
+        frame.clusterGrid.x = this->tilesX; // Tiles across
+        frame.clusterGrid.y = this->tilesY; // Tiles down
+        frame.clusterGrid.z = this->slices; // Depth slices
+        frame.clusterGrid.w = (GLuint)this->lights.size(); // Lights
+        frame.clusterDepth = glm::vec4(nearPlane, farPlane, sliceScale, sliceBias); // Depth slicing
+        frame.clusterTile = glm::vec4((float)width / this->tilesX, (float)height / this->tilesY, 0.0f, 0.0f); // Tile size
+
+        // Empty tables still get a small binding so the shaders always see valid buffers
+        this->upload(ring, GL_SHADER_STORAGE_BUFFER, POINT_LIGHT_BINDING, this->lights.empty() ? NULL : &this->lights[0], this->lights.size() * sizeof(PointLight)); // Lights
+        this->upload(ring, GL_SHADER_STORAGE_BUFFER, LIGHT_CLUSTER_BINDING, &this->ranges[0], this->ranges.size() * sizeof(GLuint)); // Ranges
+        this->upload(ring, GL_SHADER_STORAGE_BUFFER, LIGHT_INDEX_BINDING, this->indices.empty() ? NULL : &this->indices[0], this->indices.size() * sizeof(GLuint)); // Indices
+    }
+
+    // Light indices written by the last Update, for reports
+    size_t IndexCount() const {
+        return this->indices.size(); // Return count
+    }
+
+private:
+    GLuint tilesX, tilesY, slices; // Grid size
+    GLuint clusterCount; // tilesX * tilesY * slices
+    GLuint rowStride; // Padded tiles per row in bounds
+    GLuint width, height; // Render target size of the cached boxes
+    float nearPlane, farPlane; // Depth range of the cached boxes
+    glm::mat4 projection; // Projection of the cached boxes
+    bool overflowed; // Index budget exceeded, reported once
+
+    std::vector<PointLight> lights; // Lights in world space
+    std::vector<float> bounds[6]; // View-space cluster boxes: min x, y, z, max x, y, z, rows padded to whole SSE passes
+    std::vector<GLuint> counts; // Lights per cluster while binning
+    std::vector<GLuint> ranges; // Offset and count per cluster
+    std::vector<GLuint> indices; // Light indices grouped by cluster
+    std::vector<GLuint> pairs; // Cluster and light of every hit, two entries each
+
+    // Computes the view-space box of every cluster from the projection
+    void buildBounds() {
+        float scaleX = this->projection[0][0], scaleY = this->projection[1][1]; // Focal lengths
+        for (GLuint z = 0; z < this->slices; z++) { // Iterate over slices
+            float d0 = this->nearPlane * std::pow(this->farPlane / this->nearPlane, (float)z / this->slices); // Slice near depth
+            float d1 = this->nearPlane * std::pow(this->farPlane / this->nearPlane, (float)(z + 1) / this->slices); // Slice far depth
+            for (GLuint y = 0; y < this->tilesY; y++) { // Iterate over rows
+                float ny0 = -1.0f + 2.0f * y / this->tilesY, ny1 = -1.0f + 2.0f * (y + 1) / this->tilesY; // Tile NDC y range
+                for (GLuint x = 0; x < this->tilesX; x++) { // Iterate over tiles
+                    float nx0 = -1.0f + 2.0f * x / this->tilesX, nx1 = -1.0f + 2.0f * (x + 1) / this->tilesX; // Tile NDC x range
+                    glm::vec3 lo(1e30f), hi(-1e30f); // Box
+                    for (int c = 0; c < 8; c++) { // Iterate over frustum corners
+                        float d = (c & 4) ? d1 : d0; // Depth
+                        glm::vec3 p(((c & 1) ? nx1 : nx0) * d / scaleX, ((c & 2) ? ny1 : ny0) * d / scaleY, -d); // View-space corner
+                        lo = glm::min(lo, p); // Grow minimum
+                        hi = glm::max(hi, p); // Grow maximum
+                    }
+                    size_t slot = (z * this->tilesY + y) * this->rowStride + x; // Padded index
+                    for (int c = 0; c < 3; c++) { // Iterate over axes
+                        this->bounds[c][slot] = lo[c]; // Minimum
+                        this->bounds[3 + c][slot] = hi[c]; // Maximum
+                    }
+                }
+            }
+        }
+    }
+
+    // Bins every light into the clusters its sphere touches and builds the grouped index list
+    void assign(const glm::mat4& view, float sliceScale, float sliceBias) {
+        this->pairs.clear(); // No hits yet
+        std::fill(this->counts.begin(), this->counts.end(), 0u); // No lights per cluster
+        float scaleX = this->projection[0][0], scaleY = this->projection[1][1]; // Focal lengths
+        for (GLuint l = 0; l < this->lights.size(); l++) { // Iterate over lights
+            const PointLight& light = this->lights[l]; // Light
+            glm::vec3 center = glm::vec3(view * glm::vec4(glm::vec3(light.positionRadius), 1.0f)); // View-space center
+            float radius = light.positionRadius.w; // Radius
+            float dNear = -center.z - radius, dFar = -center.z + radius; // Depth range
+            if (dFar < this->nearPlane || dNear > this->farPlane) // If outside the depth range
+                continue;
+
+            // Slice range from depth, tile range from the projected box; a sphere crossing the near plane covers every tile
+            GLuint z0 = this->sliceOf(std::max(dNear * 0.999f, this->nearPlane), sliceScale, sliceBias); // First slice, rounded outward
+            GLuint z1 = this->sliceOf(std::min(dFar * 1.001f, this->farPlane), sliceScale, sliceBias); // Last slice, rounded outward
+            GLuint x0 = 0, x1 = this->tilesX - 1, y0 = 0, y1 = this->tilesY - 1; // Tile range
+            if (dNear > this->nearPlane) { // If wholly in front of the camera
+                float xs[2] = { center.x - radius, center.x + radius }, ys[2] = { center.y - radius, center.y + radius }; // Box sides
+                float ds[2] = { dNear, dFar }; // Box depths
+                float minX = 1e30f, maxX = -1e30f, minY = 1e30f, maxY = -1e30f; // NDC extent
+                for (int c = 0; c < 4; c++) { // Iterate over side and depth combinations, the extremes of x/d and y/d
+                    float ndcX = xs[c & 1] * scaleX / ds[c >> 1], ndcY = ys[c & 1] * scaleY / ds[c >> 1]; // Projected
+                    minX = std::min(minX, ndcX); maxX = std::max(maxX, ndcX); // Grow x
+                    minY = std::min(minY, ndcY); maxY = std::max(maxY, ndcY); // Grow y
+                }
+                if (maxX < -1.0f || minX > 1.0f || maxY < -1.0f || minY > 1.0f) // If off screen
+                    continue;
+                x0 = this->tileOf(minX, this->tilesX); x1 = this->tileOf(maxX, this->tilesX); // Tile columns
+                y0 = this->tileOf(minY, this->tilesY); y1 = this->tileOf(maxY, this->tilesY); // Tile rows
+            }
+
+            // Exact sphere-box test, four tiles of a row at a time
+            Lane4 cx = laneSet(center.x), cy = laneSet(center.y), cz = laneSet(center.z), zero = laneSet(0.0f); // Center
+            float radius2 = radius * radius; // Squared radius
+            float lanes[4]; // Squared distances of four clusters
+            for (GLuint z = z0; z <= z1; z++) { // Iterate over slices
+                for (GLuint y = y0; y <= y1; y++) { // Iterate over rows
+                    size_t row = (z * this->tilesY + y) * this->rowStride; // Padded row start
+                    for (GLuint x = x0 & ~3u; x <= x1; x += 4) { // Iterate over tiles in SSE passes
+                        size_t slot = row + x; // Padded index
+                        Lane4 dx = laneAdd(laneMax(laneSub(laneLoad(&this->bounds[0][slot]), cx), zero), laneMax(laneSub(cx, laneLoad(&this->bounds[3][slot])), zero)); // Distance outside in x
+                        Lane4 dy = laneAdd(laneMax(laneSub(laneLoad(&this->bounds[1][slot]), cy), zero), laneMax(laneSub(cy, laneLoad(&this->bounds[4][slot])), zero)); // Distance outside in y
+                        Lane4 dz = laneAdd(laneMax(laneSub(laneLoad(&this->bounds[2][slot]), cz), zero), laneMax(laneSub(cz, laneLoad(&this->bounds[5][slot])), zero)); // Distance outside in z
+                        laneStore(lanes, laneAdd(laneAdd(laneMul(dx, dx), laneMul(dy, dy)), laneMul(dz, dz))); // Squared distance to each box
+                        for (GLuint o = 0; o < 4; o++) { // Iterate over lanes
+                            GLuint tile = x + o; // Tile column
+                            if (tile < x0 || tile > x1 || lanes[o] > radius2) // If outside the range or the sphere
+                                continue;
+                            GLuint cluster = tile + this->tilesX * (y + this->tilesY * z); // Cluster index
+                            this->pairs.push_back(cluster); // Hit cluster
+                            this->pairs.push_back(l); // Hit light
+                            this->counts[cluster]++; // Count
+                        }
+                    }
+                }
+            }
+        }
+
+        // Counting sort of the hits by cluster, dropping what does not fit the budget
+        GLuint budget = this->clusterCount * MAX_INDICES_PER_CLUSTER; // Index capacity
+        GLuint offset = 0; // Running total
+        for (GLuint c = 0; c < this->clusterCount; c++) { // Iterate over clusters
+            GLuint count = std::min(this->counts[c], budget - offset); // What still fits
+            this->ranges[c * 2] = offset; // First index
+            this->ranges[c * 2 + 1] = 0; // Filled below
+            this->counts[c] = count; // Room left for this cluster
+            offset += count; // Advance
+        }
+        if (offset < this->pairs.size() / 2 && !this->overflowed) { // If lights were dropped
+            std::cout << "ERROR::CLUSTERED_LIGHTS::INDEX_BUDGET_EXCEEDED" << std::endl; // Report once
+            this->overflowed = true;
+        }
+        this->indices.resize(offset); // Grouped list
+        for (size_t p = 0; p < this->pairs.size(); p += 2) { // Iterate over hits
+            GLuint cluster = this->pairs[p]; // Cluster
+            if (this->ranges[cluster * 2 + 1] < this->counts[cluster]) // If room
+                this->indices[this->ranges[cluster * 2] + this->ranges[cluster * 2 + 1]++] = this->pairs[p + 1]; // Place light
+        }
+    }
+
+    // Depth slice of a view depth
+    GLuint sliceOf(float depth, float sliceScale, float sliceBias) const {
+        float slice = std::log(depth) * sliceScale - sliceBias; // Exponential slicing
+        return (GLuint)std::min(std::max(slice, 0.0f), (float)(this->slices - 1)); // Clamp
+    }
+
+    // Tile of an NDC coordinate
+    static GLuint tileOf(float ndc, GLuint tiles) {
+        float tile = (ndc * 0.5f + 0.5f) * tiles; // Tile coordinate
+        return (GLuint)std::min(std::max(tile, 0.0f), (float)(tiles - 1)); // Clamp
+    }
+
+    // Copies a table into the ring buffer and binds it
+    static void upload(RingBuffer& ring, GLenum target, GLuint binding, const void* data, size_t size) {
+        GLintptr offset; // Offset in the ring buffer
+        size_t bytes = size ? size : 16; // Never bind an empty range
+        void* dst = ring.Allocate(bytes, offset); // Reserve space
+        if (!dst) // If the frame is out of space
+            return;
+        if (size) // If there is data
+            memcpy(dst, data, size); // Write table
+        else
+            memset(dst, 0, bytes); // Zero placeholder
+        ring.BindRange(target, binding, offset, bytes); // Bind to shader binding point
+    }
+};
@@ -0,0 +1,144 @@
+// Dynamic Resolution
+
+#pragma once
+
+#include <GL/glew.h> // Include glew
+#include <glm/glm.hpp> // Include glm
+
+#include "shader.h" // Include shader pipelines
+#include "GLState.h" // Include GL state cache
+#include "../dynres.h" // Include resolution scale controller
+
+// Renders the scene into an offscreen color and depth target the size of the window, using only its bottom-left
+// corner at the current resolution scale, then draws one triangle over the window that samples that corner with
+// bilinear filtering. Changing the scale only changes the viewport, so it can move every frame without
+// reallocating anything. The GPU time of each frame is measured with a GL_TIME_ELAPSED query, read back
+// DYNRES_SETTLE_FRAMES frames later when it has arrived, and fed to the DynRes controller.
+//
+// When the controller is disabled Begin and End do nothing and the scene renders straight to the window.
+class DynamicResolution {
+public:
+    // Constructor. Call with the context current; the framebuffer bound now is where End draws to.
+    DynamicResolution(GLuint width, GLuint height, const DynRes& controller) : controller(controller), width(width), height(height),
+        renderWidth(width), renderHeight(height), framebuffer(0), output(0), color(0), depth(0), emptyArray(0), frame(0), lastMs(0.0), upsample(NULL) {
+        if (!this->controller.enabled) // If rendering at full size
+            return;
+        GLint bound = 0; // Window or headless framebuffer
+        glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &bound); // Remember output
+        this->output = (GLuint)bound;
+
+        GLStateCache& state = GLStateCache::Get(); // State cache
+        glGenTextures(1, &this->color); // Color target
+        state.BindTexture(0, GL_TEXTURE_2D, this->color);
+        glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, width, height); // Full window, any scale fits
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR); // Bilinear upsample
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glGenRenderbuffers(1, &this->depth); // Depth target
+        glBindRenderbuffer(GL_RENDERBUFFER, this->depth);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+        glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+        glGenFramebuffers(1, &this->framebuffer); // Offscreen target
+        glBindFramebuffer(GL_FRAMEBUFFER, this->framebuffer);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, this->color, 0); // Attach color
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, this->depth); // Attach depth
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) { // If unusable
+            std::cout << "ERROR::DYNAMIC_RESOLUTION::FRAMEBUFFER_INCOMPLETE" << std::endl; // Error message
+            this->controller.enabled = false; // Render straight to the window instead
+        }
+        glBindFramebuffer(GL_FRAMEBUFFER, this->output); // Restore output
+
+        glGenVertexArrays(1, &this->emptyArray); // The upsample triangle has no vertex buffer
+        glGenQueries(DYNRES_SETTLE_FRAMES, this->queries); // Frame timers
+        this->upsample = new ShaderPipeline("upsample.vs", "upsample.frag"); // Upsample pipeline
+    }
+
+    // Destructor
+    ~DynamicResolution() {
+        delete this->upsample; // Pipeline
+    }
+
+    // Whether the scene renders into the scaled target
+    bool Enabled() const {
+        return this->controller.enabled; // Return flag
+    }
+
+    // Render target width this frame, in pixels
+    GLuint RenderWidth() const {
+        return this->renderWidth; // Return width
+    }
+
+    // Render target height this frame, in pixels
+    GLuint RenderHeight() const {
+        return this->renderHeight; // Return height
+    }
+
+    // Current fraction of the window's width and height
+    float Scale() const {
+        return dynResScale(this->controller); // Return scale
+    }
+
+    // GPU time of the last frame read back, 0 until one arrives
+    double LastMilliseconds() const {
+        return this->lastMs; // Return time
+    }
+
+    // Starts a frame: binds the offscreen target at this frame's scale and starts timing. Call before clearing.
+    void Begin() {
+        if (!this->controller.enabled) // If full size
+            return;
+        this->renderWidth = dynResSize(this->controller, this->width); // Scaled width
+        this->renderHeight = dynResSize(this->controller, this->height); // Scaled height
+        glBindFramebuffer(GL_FRAMEBUFFER, this->framebuffer); // Render offscreen
+        glViewport(0, 0, this->renderWidth, this->renderHeight); // Bottom-left corner only
+        glBeginQuery(GL_TIME_ELAPSED, this->queries[this->frame % DYNRES_SETTLE_FRAMES]); // Time the frame
+    }
+
+    // Ends a frame: upsamples to the output framebuffer, stops timing and updates the scale. Call before swapping.
+    void End() {
+        if (!this->controller.enabled) // If full size
+            return;
+        GLStateCache& state = GLStateCache::Get(); // State cache
+        glBindFramebuffer(GL_FRAMEBUFFER, this->output); // Draw to the window
+        glViewport(0, 0, this->width, this->height); // Whole window
+        state.Disable(GL_DEPTH_TEST); // Overwrite every pixel
+        state.BindVertexArray(this->emptyArray); // No attributes
+        state.BindTexture(0, GL_TEXTURE_2D, this->color); // Scene
+        state.BindSampler(0, 0); // Texture's own bilinear filtering
+        this->upsample->Use(); // Upsample pipeline
+        this->upsample->SetVec4("region", glm::vec4((float)this->renderWidth / this->width, (float)this->renderHeight / this->height,
+                                                   0.5f / this->width, 0.5f / this->height)); // Rendered corner
+        glDrawArrays(GL_TRIANGLES, 0, 3); // One triangle over the window
+        state.Enable(GL_DEPTH_TEST); // Restore depth testing
+        glEndQuery(GL_TIME_ELAPSED); // Frame timed
+
+        // Read back the oldest timer, which is reused next frame, only if it has arrived
+        this->frame++; // Next frame
+        if (this->frame < DYNRES_SETTLE_FRAMES) // If the ring is not full yet
+            return;
+        GLuint oldest = this->queries[this->frame % DYNRES_SETTLE_FRAMES]; // Oldest timer
+        GLint available = 0; // Result ready
+        glGetQueryObjectiv(oldest, GL_QUERY_RESULT_AVAILABLE, &available); // Poll
+        if (!available) // Never wait on the GPU
+            return;
+        GLuint64 elapsed = 0; // Nanoseconds
+        glGetQueryObjectui64v(oldest, GL_QUERY_RESULT, &elapsed); // Read result, already available
+        this->lastMs = elapsed / 1000000.0; // Nanoseconds to ms
+        dynResUpdate(this->controller, this->lastMs); // Move the scale
+    }
+
+private:
+    DynRes controller; // Resolution scale controller
+    GLuint width, height; // Window size
+    GLuint renderWidth, renderHeight; // Size rendered this frame
+    GLuint framebuffer; // Offscreen framebuffer
+    GLuint output; // Framebuffer End draws to
+    GLuint color, depth; // Offscreen color texture and depth renderbuffer
+    GLuint emptyArray; // VAO with no attributes for the upsample triangle
+    GLuint queries[DYNRES_SETTLE_FRAMES]; // Frame timers in flight
+    GLuint frame; // Frames timed so far
+    double lastMs; // Last GPU time read back
+    ShaderPipeline* upsample; // Upsample pipeline
+};
@@ -0,0 +1,217 @@
+// Entity Component System
+
+#pragma once
+
+#include <cstdlib> // Include cstdlib for abort
+#include <cstring> // Include cstring for memcpy
+#include <iostream> // Include iostream
+#include <map> // Include map
+#include <type_traits> // Include type_traits
+#include <vector> // Include vector
+
+#include <GL/glew.h> // Include glew
+
+// Entity handle, an index into the world's entity records
+typedef GLuint Entity;
+
+// Archetype-based entity component system. Every distinct set of component types is an archetype that stores
+// each component in its own contiguous array, one row per entity, so a query walks tight arrays of exactly the
+// components it asks for. Adding or removing a component moves the entity's row to another archetype, so
+// handles stay valid but component pointers do not.
+//
+// Components must be plain structs (trivially copyable); rows are moved with memcpy. Queries may run in parallel
+// with each other as long as nothing creates entities or adds or removes components meanwhile.
+class EntityWorld {
+public:
+    // Most component types a world supports, one bit each in an archetype's mask
+    static const GLuint MAX_COMPONENTS = 32;
+
+    // Constructor
+    EntityWorld() {}
+
+    // Creates an entity with no components
+    Entity Create() {
+        Entity entity = (Entity)this->records.size(); // Next handle
+        Record record = { this->archetype(0), 0 }; // Empty archetype
+        this->records.push_back(record); // Store record
+        Archetype& empty = this->archetypes[record.archetype]; // Empty archetype
+        this->records[entity].row = (GLuint)empty.entities.size(); // Last row
+        empty.entities.push_back(entity); // Append row
+        return entity; // Return handle
+    }
+
+    // Adds a component to an entity, or replaces it if the entity already has one
+    template <typename T>
+    void Add(Entity entity, const T& component) {
+        static_assert(std::is_trivially_copyable<T>::value, "components are moved with memcpy"); // Check component
+        GLuint id = registerComponent<T>(); // Component type id
+        if (!(this->archetypes[this->records[entity].archetype].mask & (1u << id))) // If new to the entity
+            this->move(entity, this->archetypes[this->records[entity].archetype].mask | (1u << id)); // Move to the wider archetype
+        *this->Get<T>(entity) = component; // Store component
+    }
+
+    // Removes a component from an entity
+    template <typename T>
+    void Remove(Entity entity) {
+        GLuint mask = this->archetypes[this->records[entity].archetype].mask; // Current components
+        if (mask & (1u << componentIdOf<T>())) // If present
+            this->move(entity, mask & ~(1u << componentIdOf<T>())); // Move to the narrower archetype
+    }
+
+    // Returns an entity's component, NULL if it has none
+    template <typename T>
+    T* Get(Entity entity) {
+        Record& record = this->records[entity]; // Where the entity lives
+        Archetype& archetype = this->archetypes[record.archetype]; // Its archetype
+        GLuint id = componentIdOf<T>(); // Component type id
+        if (!(archetype.mask & (1u << id))) // If absent
+            return NULL;
+        return (T*)&archetype.columns[id][record.row * sizeof(T)]; // Row in the column
+    }
+
+    // Calls f(entity, components...) for every entity that has all of the components, one archetype at a time
+    template <typename... C, typename F>
+    void Each(F f) {
+        GLuint mask = maskOf<C...>(); // Required components
+        for (size_t a = 0; a < this->archetypes.size(); a++) { // Iterate over archetypes
+            Archetype& archetype = this->archetypes[a]; // Archetype
+            if ((archetype.mask & mask) == mask) // If it has every component
+                eachRow<C...>(archetype, 0, archetype.entities.size(), f); // Walk its rows
+        }
+    }
+
+    // Number of entities that have all of the components
+    template <typename... C>
+    size_t Count() {
+        GLuint mask = maskOf<C...>(); // Required components
+        size_t count = 0; // Running total
+        for (size_t a = 0; a < this->archetypes.size(); a++) // Iterate over archetypes
+            if ((this->archetypes[a].mask & mask) == mask) // If it has every component
+                count += this->archetypes[a].entities.size(); // Add its rows
+        return count; // Return count
+    }
+
+    // Number of archetypes in use
+    size_t ArchetypeCount() const {
+        return this->archetypes.size(); // Return count
+    }
+
+private:
+    // Entities sharing one set of components
+    struct Archetype {
+        GLuint mask; // Component bits
+        std::vector<unsigned char> columns[MAX_COMPONENTS]; // One byte array per component, empty when absent
+        std::vector<Entity> entities; // Entity in each row
+    };
+
+    // Where an entity's components live
+    struct Record {
+        GLuint archetype; // Archetype index
+        GLuint row; // Row within it
+    };
+
+    std::vector<Archetype> archetypes; // Archetypes, index 0 is the empty one
+    std::map<GLuint, GLuint> archetypeByMask; // Lookup from component bits
+    std::vector<Record> records; // Record per entity
+    GLuint componentSizes[MAX_COMPONENTS]; // Bytes per component type
+
+    // Sequential id for a component type, shared by every world
+    static GLuint nextComponentId() {
+        static GLuint next = 0; // Ids handed out
+        return next++; // Return next id
+    }
+
+    // Id of component type T, remembering its row size. Only Add calls this, so queries never write.
+    template <typename T>
+    GLuint registerComponent() {
+        GLuint id = componentIdOf<T>(); // Shared id
+        if (id >= MAX_COMPONENTS) { // If past the mask's bits
+            std::cout << "ERROR::ECS::TOO_MANY_COMPONENT_TYPES: component type " << id << " exceeds MAX_COMPONENTS (" << MAX_COMPONENTS << ")" << std::endl; // Error message
+            std::abort(); // Masks cannot represent it
+        }
+        this->componentSizes[id] = sizeof(T); // Remember row size
+        return id; // Return id
+    }
+
+    // Mask of a set of component types
+    template <typename... C>
+    GLuint maskOf() {
+        GLuint ids[] = { componentIdOf<C>()... }; // Ids of every type
+        GLuint mask = 0; // Bits
+        for (size_t i = 0; i < sizeof...(C); i++) // Iterate over types
+            mask |= 1u << ids[i]; // Set bit
+        return mask; // Return mask
+    }
+
+    // Index of the archetype with a mask, created on first use
+    GLuint archetype(GLuint mask) {
+        std::map<GLuint, GLuint>::iterator it = this->archetypeByMask.find(mask); // Look up
+        if (it != this->archetypeByMask.end()) // If it exists
+            return it->second; // Return index
+        this->archetypes.push_back(Archetype()); // New archetype
+        this->archetypes.back().mask = mask; // Its components
+        GLuint index = (GLuint)this->archetypes.size() - 1; // Its index
+        this->archetypeByMask[mask] = index; // Remember
+        return index; // Return index
+    }
+
+    // Moves an entity's row to the archetype with mask, copying the components both share
+    void move(Entity entity, GLuint mask) {
+        GLuint to = this->archetype(mask); // Destination, may grow archetypes
+        Record record = this->records[entity]; // Source
+        Archetype& source = this->archetypes[record.archetype]; // Source archetype
+        Archetype& target = this->archetypes[to]; // Destination archetype
+        GLuint row = (GLuint)target.entities.size(); // New row
+        target.entities.push_back(entity); // Append row
+        for (GLuint id = 0; id < MAX_COMPONENTS; id++) { // Iterate over component types
+            if (!(mask & (1u << id))) // If the destination lacks it
+                continue;
+            GLuint size = this->componentSizes[id]; // Row size
+            target.columns[id].resize((row + 1) * size); // Grow column, new components zeroed
+            if (source.mask & (1u << id)) // If the source has it too
+                memcpy(&target.columns[id][row * size], &source.columns[id][record.row * size], size); // Copy component
+        }
+        this->removeRow(record.archetype, record.row); // Close the gap in the source
+        this->records[entity].archetype = to; // New archetype
+        this->records[entity].row = row; // New row
+    }
+
+    // Removes a row by moving the archetype's last row into it
+    void removeRow(GLuint index, GLuint row) {
+        Archetype& archetype = this->archetypes[index]; // Archetype
+        GLuint last = (GLuint)archetype.entities.size() - 1; // Last row
+        for (GLuint id = 0; id < MAX_COMPONENTS; id++) { // Iterate over component types
+            if (!(archetype.mask & (1u << id))) // If absent
+                continue;
+            GLuint size = this->componentSizes[id]; // Row size
+            if (row != last) // If not already last
+                memcpy(&archetype.columns[id][row * size], &archetype.columns[id][last * size], size); // Fill gap
+            archetype.columns[id].resize(last * size); // Drop last row
+        }
+        if (row != last) { // If a row moved
+            archetype.entities[row] = archetype.entities[last]; // Move handle
+            this->records[archetype.entities[row]].row = row; // Update its record
+        }
+        archetype.entities.pop_back(); // Drop last handle
+    }
+
+    // Calls f for rows [begin, end) of an archetype
+    template <typename... C, typename F>
+    static void eachRow(Archetype& archetype, size_t begin, size_t end, F f) {
+        for (size_t row = begin; row < end; row++) // Iterate over rows
+            f(archetype.entities[row], column<C>(archetype)[row]...); // Call with each component
+    }
+
+    // Column of component type T as a typed array
+    template <typename T>
+    static T* column(Archetype& archetype) {
+        return (T*)archetype.columns[componentIdOf<T>()].data(); // Typed column
+    }
+
+    // Id of component type T, the same in every world
+    template <typename T>
+    static GLuint componentIdOf() {
+        static const GLuint id = nextComponentId(); // Assigned on first use
+        return id; // Return id
+    }
+};
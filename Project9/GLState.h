@@ -0,0 +1,201 @@
+// GL State Cache
+
+#pragma once
+
+#include <map> // Include map
+
+#include <GL/glew.h> // Include glew
+
+// Thin state-tracking wrapper around the GL binding and capability calls used by the renderer.
+// Calls that would not change anything are dropped, and issued/elided counts are kept per frame.
+// State starts out unknown, so the first call of each kind is always issued.
+class GLStateCache {
+public:
+    // Counts for one frame
+    struct FrameStats {
+        unsigned int issued; // State changes sent to GL
+        unsigned int elided; // State changes dropped as redundant
+    };
+
+    // Returns the cache for the current context
+    static GLStateCache& Get() {
+        static GLStateCache cache; // Single context, single cache
+        return cache; // Return cache
+    }
+
+    // Binds a program
+    void UseProgram(GLuint program) {
+        if (track(this->program, program)) // If changed
+            glUseProgram(program); // Issue
+    }
+
+    // Binds a program pipeline
+    void BindProgramPipeline(GLuint pipeline) {
+        if (track(this->pipeline, pipeline)) // If changed
+            glBindProgramPipeline(pipeline); // Issue
+    }
+
+    // Binds a vertex array
+    void BindVertexArray(GLuint vao) {
+        if (track(this->vao, vao)) { // If changed
+            glBindVertexArray(vao); // Issue
+            this->buffers.erase(GL_ELEMENT_ARRAY_BUFFER); // Element buffer binding belongs to the VAO
+            this->vertexBuffers.clear(); // Vertex buffer bindings belong to the VAO
+        }
+    }
+
+    // Binds a buffer to a vertex buffer binding point of the current VAO
+    void BindVertexBuffer(GLuint binding, GLuint buffer, GLintptr offset, GLsizei stride) {
+        VertexBufferBinding value = { buffer, offset, stride }; // Requested binding
+        std::map<GLuint, VertexBufferBinding>::iterator it = this->vertexBuffers.find(binding); // Look up binding
+        if (it != this->vertexBuffers.end() && it->second.buffer == buffer && it->second.offset == offset && it->second.stride == stride) { // If redundant
+            this->stats.elided++; // Count elided call
+            return;
+        }
+        this->vertexBuffers[binding] = value; // Remember binding
+        this->stats.issued++; // Count issued call
+        glBindVertexBuffer(binding, buffer, offset, stride); // Issue
+    }
+
+    // Binds a buffer to a target
+    void BindBuffer(GLenum target, GLuint buffer) {
+        if (track(slot(this->buffers, target), buffer)) // If changed
+            glBindBuffer(target, buffer); // Issue
+    }
+
+    // Binds a texture to a texture unit
+    void BindTexture(GLuint unit, GLenum target, GLuint texture) {
+        if (unit >= MAX_UNITS) { // If unit is out of range
+            activeTexture(unit); // Select unit
+            glBindTexture(target, texture); // Issue untracked
+            this->stats.issued++; // Count it
+            return;
+        }
+        if (!track(slot(this->textures[unit], target), texture)) // If unchanged
+            return; // Nothing to do
+        activeTexture(unit); // Select unit
+        glBindTexture(target, texture); // Issue
+    }
+
+    // Binds a sampler object to a texture unit
+    void BindSampler(GLuint unit, GLuint sampler) {
+        if (unit >= MAX_UNITS || track(this->samplers[unit], sampler)) // If changed or untracked
+            glBindSampler(unit, sampler); // Issue
+    }
+
+    // Enables a capability such as GL_BLEND or GL_DEPTH_TEST
+    void Enable(GLenum cap) {
+        if (track(slot(this->caps, cap), GL_TRUE)) // If changed
+            glEnable(cap); // Issue
+    }
+
+    // Disables a capability
+    void Disable(GLenum cap) {
+        if (track(slot(this->caps, cap), GL_FALSE)) // If changed
+            glDisable(cap); // Issue
+    }
+
+    // Sets the blend function
+    void BlendFunc(GLenum sfactor, GLenum dfactor) {
+        GLuint packed = (sfactor & 0xFFFF) | ((dfactor & 0xFFFF) << 16); // Pack both factors
+        if (track(this->blendFunc, packed)) // If changed
+            glBlendFunc(sfactor, dfactor); // Issue
+    }
+
+    // Sets the depth comparison function
+    void DepthFunc(GLenum func) {
+        if (track(this->depthFunc, func)) // If changed
+            glDepthFunc(func); // Issue
+    }
+
+    // Enables or disables depth writes
+    void DepthMask(GLboolean flag) {
+        if (track(this->depthMask, flag)) // If changed
+            glDepthMask(flag); // Issue
+    }
+
+    // Enables or disables writes to all color channels
+    void ColorMask(GLboolean flag) {
+        if (track(this->colorMask, flag)) // If changed
+            glColorMask(flag, flag, flag, flag); // Issue
+    }
+
+    // Forgets all tracked state, for use after code that changed GL state directly
+    void Invalidate() {
+        this->program = UNKNOWN; // Reset program
+        this->pipeline = UNKNOWN; // Reset pipeline
+        this->vao = UNKNOWN; // Reset VAO
+        this->activeUnit = UNKNOWN; // Reset active unit
+        this->blendFunc = UNKNOWN; // Reset blend function
+        this->depthFunc = UNKNOWN; // Reset depth function
+        this->depthMask = UNKNOWN; // Reset depth mask
+        this->colorMask = UNKNOWN; // Reset color mask
+        this->buffers.clear(); // Reset buffers
+        this->vertexBuffers.clear(); // Reset vertex buffer bindings
+        this->caps.clear(); // Reset capabilities
+        for (GLuint i = 0; i < MAX_UNITS; i++) { // Iterate over units
+            this->textures[i].clear(); // Reset textures
+            this->samplers[i] = UNKNOWN; // Reset samplers
+        }
+    }
+
+    // Returns this frame's counts and starts a new frame
+    FrameStats EndFrame() {
+        FrameStats frame = this->stats; // Copy counts
+        this->stats.issued = 0; // Reset issued
+        this->stats.elided = 0; // Reset elided
+        return frame; // Return counts
+    }
+
+private:
+    static const GLuint UNKNOWN = 0xFFFFFFFFu; // Value that never matches real state
+    static const GLuint MAX_UNITS = 32; // Texture units tracked
+
+    // Buffer, offset and stride at one vertex buffer binding point
+    struct VertexBufferBinding {
+        GLuint buffer; // Bound buffer
+        GLintptr offset; // Offset of first vertex
+        GLsizei stride; // Bytes between vertices
+    };
+
+    GLuint program, pipeline, vao, activeUnit; // Bound objects
+    GLuint blendFunc, depthFunc, depthMask, colorMask; // Fixed-function state
+    std::map<GLenum, GLuint> buffers; // Buffer bound per target
+    std::map<GLuint, VertexBufferBinding> vertexBuffers; // Vertex buffer per binding point of the bound VAO
+    std::map<GLenum, GLuint> caps; // Enabled flag per capability
+    std::map<GLenum, GLuint> textures[MAX_UNITS]; // Texture bound per unit and target
+    GLuint samplers[MAX_UNITS]; // Sampler bound per unit
+    FrameStats stats; // Counts for the current frame
+
+    // Constructor
+    GLStateCache() {
+        this->stats.issued = 0; // Nothing issued yet
+        this->stats.elided = 0; // Nothing elided yet
+        this->Invalidate(); // Everything starts unknown
+    }
+
+    // Records a new value for a piece of state, returning true when GL must be called
+    bool track(GLuint& current, GLuint value) {
+        if (current == value) { // If redundant
+            this->stats.elided++; // Count elided call
+            return false;
+        }
+        current = value; // Remember new value
+        this->stats.issued++; // Count issued call
+        return true;
+    }
+
+    // Returns the tracked value for a key, inserting it as unknown the first time
+    static GLuint& slot(std::map<GLenum, GLuint>& state, GLenum key) {
+        std::map<GLenum, GLuint>::iterator it = state.find(key); // Look up key
+        if (it == state.end()) // If not tracked yet
+            it = state.insert(std::make_pair(key, (GLuint)UNKNOWN)).first; // Start as unknown
+        return it->second; // Return tracked value
+    }
+
+    // Selects the active texture unit
+    void activeTexture(GLuint unit) {
+        if (track(this->activeUnit, unit)) // If changed
+            glActiveTexture(GL_TEXTURE0 + unit); // Issue
+    }
+};
@@ -0,0 +1,238 @@
+// GPU Culling
+
+#pragma once
+
+#include <vector> // Include vector
+
+#include <GL/glew.h> // Include glew
+#include <glm/glm.hpp> // Include glm
+
+#include "shader.h" // Include shader stages and pipelines
+#include "GLState.h" // Include GL state cache
+#include "VertexLayout.h" // Include vertex layout descriptors
+#include "RenderQueue.h" // Include materials
+#include "Profiler.h" // Include frame profiler
+
+// One instance as the compute and vertex stages read it (std430)
+struct GpuInstance {
+    glm::mat4 model; // Object to world
+    glm::mat4 normalMatrix; // transpose(inverse(mat3(model))) in the upper 3x3, precomputed like ObjectConstants
+    glm::vec4 boundsMin; // Object-space bounding box minimum
+    glm::vec4 boundsMax; // Object-space bounding box maximum
+    GLuint batch; // Batch the instance is drawn with
+    GLuint slot; // Index within its batch
+    GLuint pad[2]; // Padding
+};
+static_assert(sizeof(GpuInstance) == 176, "GpuInstance must match the std430 Instance struct"); // Check layout
+
+// Draw parameters shared by every instance of a batch (std430)
+struct GpuBatch {
+    GLuint count; // Indices per draw
+    GLuint firstIndex; // First index
+    GLint baseVertex; // Added to every index
+    GLuint firstCommand; // First command slot of the batch
+};
+
+// Layout of one glMultiDrawElementsIndirect command
+struct DrawElementsIndirectCommand {
+    GLuint count; // Indices per draw
+    GLuint instanceCount; // Instances, 0 skips the draw
+    GLuint firstIndex; // First index
+    GLint baseVertex; // Added to every index
+    GLuint baseInstance; // First instance, offsets the instance stream
+};
+
+// Binding points of the culling buffers
+const GLuint INSTANCE_BUFFER_BINDING = 2; // Instances, read by cull.comp and indirect.vs
+const GLuint BATCH_BUFFER_BINDING = 3; // Batches, read by cull.comp
+const GLuint COMMAND_BUFFER_BINDING = 4; // Commands, written by cull.comp
+const GLuint DRAW_COUNT_BUFFER_BINDING = 5; // Per-batch command counts, written by cull.comp
+
+// Vertex stream that feeds indirect.vs its instance index. A per-instance attribute is offset by each
+// command's baseInstance, which works on any GL 4.3 driver without GL_ARB_shader_draw_parameters.
+const GLuint INSTANCE_STREAM_BINDING = 1; // Vertex buffer binding point
+const GLuint INSTANCE_STREAM_LOCATION = 3; // Attribute location
+
+// GPU-driven culling and submission. Instances live in a storage buffer uploaded once. Every frame a compute
+// pass frustum-culls all of them and appends a DrawElementsIndirectCommand per visible instance to its batch's
+// range, counting with atomics. Each batch (one geometry with one material) is then drawn with a single
+// glMultiDrawElementsIndirectCount that reads its count from the GPU, so the CPU work per frame depends on the
+// number of batches, not instances. Without GL_ARB_indirect_parameters every slot is written, culled ones with
+// instanceCount 0, and glMultiDrawElementsIndirect draws the whole range.
+class GpuCuller {
+public:
+    // Constructor
+    GpuCuller() : uploaded(false), instanceBuffer(0), batchBuffer(0), commandBuffer(0), drawCountBuffer(0), instanceStream(0) {
+        this->program = ShaderStage::Get(GL_COMPUTE_SHADER, "cull.comp"); // Culling compute stage
+        this->countFromGpu = GLEW_ARB_indirect_parameters != 0; // Draw counts read on the GPU
+    }
+
+    // Adds a batch: geometry with an index buffer, drawn with a material whose pipeline uses indirect.vs
+    GLuint AddBatch(const Material& material, const DrawGeometry& geometry) {
+        Batch batch = { material, geometry, 0 }; // Batch with no instances yet
+        this->batches.push_back(batch); // Store batch
+        return (GLuint)this->batches.size() - 1; // Return batch id
+    }
+
+    // Adds an instance of a batch with an object-space bounding box
+    GLuint AddInstance(GLuint batch, const glm::mat4& model, const glm::vec3& min, const glm::vec3& max) {
+        GpuInstance instance; // New instance
+        instance.model = model; // Model matrix
+        instance.normalMatrix = glm::mat4(glm::transpose(glm::inverse(glm::mat3(model)))); // Once here instead of per vertex
+        instance.boundsMin = glm::vec4(min, 1.0f); // Box minimum
+        instance.boundsMax = glm::vec4(max, 1.0f); // Box maximum
+        instance.batch = batch; // Batch
+        instance.slot = this->batches[batch].instances++; // Next slot in the batch
+        instance.pad[0] = instance.pad[1] = 0; // Clear padding
+        this->instances.push_back(instance); // Store instance
+        this->uploaded = false; // Buffers out of date
+        return (GLuint)this->instances.size() - 1; // Return instance id
+    }
+
+    // Moves an instance. Once uploaded, only its two matrices are rewritten in the instance buffer; its
+    // object-space bounds and batch stay as they are.
+    void UpdateInstance(GLuint id, const glm::mat4& model) {
+        GpuInstance& instance = this->instances[id]; // Instance
+        instance.model = model; // Model matrix
+        instance.normalMatrix = glm::mat4(glm::transpose(glm::inverse(glm::mat3(model)))); // Normal matrix
+        if (!this->uploaded) // If the next Cull uploads everything anyway
+            return;
+        GLStateCache::Get().BindBuffer(GL_COPY_WRITE_BUFFER, this->instanceBuffer); // Bind instances
+        glBufferSubData(GL_COPY_WRITE_BUFFER, id * sizeof(GpuInstance), 2 * sizeof(glm::mat4), &instance.model); // Model and normal matrices
+    }
+
+    // Number of instances
+    size_t InstanceCount() const {
+        return this->instances.size(); // Return count
+    }
+
+    // Number of batches, and so of draw calls per frame
+    size_t BatchCount() const {
+        return this->batches.size(); // Return count
+    }
+
+    // Culls every instance against the view frustum, given as the camera's six world-space planes, and writes
+    // this frame's draw commands
+    void Cull(const glm::vec4* frustumPlanes) {
+        if (this->instances.empty()) // If nothing to cull
+            return;
+        if (!this->uploaded) // If instances changed
+            this->upload(); // Rebuild buffers
+        GLStateCache& state = GLStateCache::Get(); // State cache
+
+        // Reset the per-batch counters
+        GLuint zero = 0; // Clear value
+        state.BindBuffer(GL_COPY_WRITE_BUFFER, this->drawCountBuffer); // Bind counters
+        glClearBufferData(GL_COPY_WRITE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, &zero); // Zero them
+
+        state.UseProgram(this->program); // Use compute stage
+        glProgramUniform1ui(this->program, glGetUniformLocation(this->program, "instanceTotal"), (GLuint)this->instances.size()); // Instance count
+        glProgramUniform4fv(this->program, glGetUniformLocation(this->program, "frustumPlanes"), 6, &frustumPlanes[0][0]); // Planes
+        glProgramUniform1i(this->program, glGetUniformLocation(this->program, "compact"), this->countFromGpu); // Packed or fixed slots
+        this->bindBuffers(); // Bind storage buffers
+        glDispatchCompute((GLuint)(this->instances.size() + 63) / 64, 1, 1); // One invocation per instance
+        glMemoryBarrier(GL_COMMAND_BARRIER_BIT); // Commands and counts are read by the draws
+    }
+
+    // Draws every batch with one indirect call each, using the commands written by Cull
+    void Draw(const glm::mat4& viewProjection) {
+        if (this->instances.empty()) // If nothing to draw
+            return;
+        GLStateCache& state = GLStateCache::Get(); // State cache
+        this->bindBuffers(); // Instances for indirect.vs
+        state.BindBuffer(GL_DRAW_INDIRECT_BUFFER, this->commandBuffer); // Commands
+        if (this->countFromGpu) // If counts come from the GPU
+            state.BindBuffer(GL_PARAMETER_BUFFER_ARB, this->drawCountBuffer); // Counts
+        for (size_t b = 0; b < this->batches.size(); b++) { // Iterate over batches
+            const Batch& batch = this->batches[b]; // Batch
+            if (batch.instances == 0) // If empty
+                continue;
+            batch.material.shader->Use(); // Use pipeline
+            batch.material.shader->SetMat4("viewProjection", viewProjection); // Shared view-projection
+            batch.material.shader->SetVec3("objectColor", batch.material.color); // Material color
+            BindDrawGeometry(batch.geometry); // Bind vertex and index buffers
+            state.BindVertexBuffer(INSTANCE_STREAM_BINDING, this->instanceStream, 0, sizeof(GLuint)); // Instance index stream
+            const void* commands = (const void*)(this->firstCommand(b) * sizeof(DrawElementsIndirectCommand)); // Batch's command range
+            if (batch.geometry.zone) // If its draws are timed, such as model meshes
+                Profiler::Get().Begin(batch.geometry.zone); // Open their zone
+            if (this->countFromGpu) // If counts come from the GPU
+                glMultiDrawElementsIndirectCountARB(GL_TRIANGLES, GL_UNSIGNED_INT, commands, (GLintptr)(b * sizeof(GLuint)), batch.instances, sizeof(DrawElementsIndirectCommand)); // Draw the visible commands
+            else
+                glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, commands, batch.instances, sizeof(DrawElementsIndirectCommand)); // Draw every slot, culled ones are empty
+            if (batch.geometry.zone) // If timed
+                Profiler::Get().End(); // Close zone
+        }
+    }
+
+private:
+    // Geometry and material shared by a run of commands
+    struct Batch {
+        Material material; // Material
+        DrawGeometry geometry; // Indexed geometry
+        GLuint instances; // Instances in the batch
+    };
+
+    GLuint program; // Culling compute stage
+    bool countFromGpu; // GL_ARB_indirect_parameters available
+    bool uploaded; // Buffers match instances
+    std::vector<Batch> batches; // Batches
+    std::vector<GpuInstance> instances; // Instances
+    GLuint instanceBuffer, batchBuffer, commandBuffer, drawCountBuffer; // Storage buffers
+    GLuint instanceStream; // 0, 1, 2, ... read per instance
+
+    // First command slot of a batch
+    GLuint firstCommand(size_t batch) const {
+        GLuint first = 0; // Running total
+        for (size_t b = 0; b < batch; b++) // Iterate over earlier batches
+            first += this->batches[b].instances; // Skip their slots
+        return first; // Return slot
+    }
+
+    // Binds the storage buffers to their binding points
+    void bindBuffers() {
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, INSTANCE_BUFFER_BINDING, this->instanceBuffer); // Instances
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, BATCH_BUFFER_BINDING, this->batchBuffer); // Batches
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, COMMAND_BUFFER_BINDING, this->commandBuffer); // Commands
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, DRAW_COUNT_BUFFER_BINDING, this->drawCountBuffer); // Counts
+    }
+
+    // Creates a buffer holding data
+    static void fill(GLuint& buffer, GLsizeiptr size, const void* data) {
+        if (!buffer) // If not created
+            glGenBuffers(1, &buffer); // Create buffer
+        GLStateCache::Get().BindBuffer(GL_COPY_WRITE_BUFFER, buffer); // Bind buffer
+        glBufferData(GL_COPY_WRITE_BUFFER, size, data, GL_STATIC_DRAW); // Upload
+    }
+
+    // Uploads instances and batches, sizes the command buffer and hooks the instance stream into each VAO
+    void upload() {
+        std::vector<GpuBatch> records(this->batches.size()); // Batch records
+        for (size_t b = 0; b < this->batches.size(); b++) { // Iterate over batches
+            records[b].count = (GLuint)this->batches[b].geometry.count; // Indices per draw
+            records[b].firstIndex = 0; // Whole index buffer
+            records[b].baseVertex = 0; // Indices are absolute
+            records[b].firstCommand = this->firstCommand(b); // Command range
+        }
+        std::vector<GLuint> indices(this->instances.size()); // Instance stream
+        for (size_t i = 0; i < indices.size(); i++) // Iterate over instances
+            indices[i] = (GLuint)i; // Identity
+        std::vector<DrawElementsIndirectCommand> empty(this->instances.size(), DrawElementsIndirectCommand()); // No draws until culled
+
+        fill(this->instanceBuffer, this->instances.size() * sizeof(GpuInstance), &this->instances[0]); // Instances
+        fill(this->batchBuffer, records.size() * sizeof(GpuBatch), &records[0]); // Batches
+        fill(this->commandBuffer, empty.size() * sizeof(DrawElementsIndirectCommand), &empty[0]); // Commands
+        fill(this->drawCountBuffer, this->batches.size() * sizeof(GLuint), NULL); // Counts
+        fill(this->instanceStream, indices.size() * sizeof(GLuint), &indices[0]); // Instance stream
+
+        GLStateCache& state = GLStateCache::Get(); // State cache
+        for (size_t b = 0; b < this->batches.size(); b++) { // Iterate over batches
+            state.BindVertexArray(this->batches[b].geometry.vao); // Batch's shared VAO
+            glVertexAttribIFormat(INSTANCE_STREAM_LOCATION, 1, GL_UNSIGNED_INT, 0); // One uint per instance
+            glVertexAttribBinding(INSTANCE_STREAM_LOCATION, INSTANCE_STREAM_BINDING); // Read from the instance binding
+            glVertexBindingDivisor(INSTANCE_STREAM_BINDING, 1); // Advance per instance
+            glEnableVertexAttribArray(INSTANCE_STREAM_LOCATION); // Enable attribute
+            state.BindVertexBuffer(INSTANCE_STREAM_BINDING, this->instanceStream, 0, sizeof(GLuint)); // Keep a buffer bound for ordinary draws too
+        }
+        this->uploaded = true; // Buffers match
+    }
+};
@@ -30,11 +30,36 @@ public:
 		this->loadModel(path); // Load model with callback and path
 	}
 	
-	// Draws the model, and thus all its meshes
-	void Draw(Shader shader)
+	// Number of meshes
+	GLuint MeshCount() const
 	{
+		return (GLuint)this->meshes.size(); // Return mesh count
+	}
+
+	// Buffers and index count of one mesh. Its draws are timed in a "model meshes" zone wherever they are issued.
+	DrawGeometry MeshGeometry(GLuint index) const
+	{
+		DrawGeometry geometry = this->meshes[index].Geometry(); // Mesh geometry
+		geometry.zone = "model meshes"; // Split model draws out of each material's time
+		return geometry; // Return geometry
+	}
+
+	// Object-space bounding box of every mesh's vertices
+	void Bounds(glm::vec3& min, glm::vec3& max) const
+	{
+		min = glm::vec3(0.0f); // Empty models get a point box
+		max = glm::vec3(0.0f); // Empty models get a point box
+		bool first = true; // No vertex seen yet
 		for(GLuint i = 0; i < this->meshes.size(); i++) // Iterate over mesh
-			this->meshes[i].Draw(shader); // Draw
+		{
+			const vector<Vertex>& vertices = this->meshes[i].vertices; // Mesh vertices
+			for(GLuint v = 0; v < vertices.size(); v++) // Iterate over vertices
+			{
+				min = first ? vertices[v].Position : glm::min(min, vertices[v].Position); // Grow minimum
+				max = first ? vertices[v].Position : glm::max(max, vertices[v].Position); // Grow maximum
+				first = false; // Box started
+			}
+		}
 	}
 	
 private:
@@ -180,7 +205,8 @@ GLint TextureFromFile(const char* path, string directory)
 	int width,height; // Initialize width and height
 	unsigned char* image = SOIL_load_image(filename.c_str(), &width, &height, 0, SOIL_LOAD_RGB); // Get SOIL image
 	// Assign texture to ID
-	glBindTexture(GL_TEXTURE_2D, textureID); // Bind texture
+	GLStateCache& state = GLStateCache::Get(); // State cache
+	state.BindTexture(0, GL_TEXTURE_2D, textureID); // Bind texture
 	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, image); // Bind image
 	glGenerateMipmap(GL_TEXTURE_2D); // Generate mip maps
 	
@@ -189,7 +215,7 @@ GLint TextureFromFile(const char* path, string directory)
 	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT ); // Set texture wrap t
 	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR ); // Set min filter
 	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR); // Set mag filter
-	glBindTexture(GL_TEXTURE_2D, 0); // Bind texture
+	state.BindTexture(0, GL_TEXTURE_2D, 0); // Bind texture
 	SOIL_free_image_data(image); // Use image
 	return textureID; // Return textureID
 }
@@ -0,0 +1,250 @@
+// Per-Object Constants
+
+#pragma once
+
+#include <cstring> // Include cstring for memcpy
+#include <vector> // Include vector
+
+#include <GL/glew.h> // Include glew
+#include <glm/glm.hpp> // Include glm
+#include <glm/gtc/type_ptr.hpp> // Include glm type_ptr
+
+#include "GLState.h" // Include GL state cache
+#include "RingBuffer.h" // Include per-frame ring buffer
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h> // Include SSE intrinsics
+// Four objects processed side by side, one per SSE lane
+typedef __m128 Lane4;
+inline Lane4 laneLoad(const float* p) { return _mm_loadu_ps(p); } // Load four lanes
+inline Lane4 laneSet(float s) { return _mm_set1_ps(s); } // Broadcast scalar
+inline Lane4 laneAdd(Lane4 a, Lane4 b) { return _mm_add_ps(a, b); } // Add lanes
+inline Lane4 laneSub(Lane4 a, Lane4 b) { return _mm_sub_ps(a, b); } // Subtract lanes
+inline Lane4 laneMul(Lane4 a, Lane4 b) { return _mm_mul_ps(a, b); } // Multiply lanes
+inline Lane4 laneDiv(Lane4 a, Lane4 b) { return _mm_div_ps(a, b); } // Divide lanes
+inline Lane4 laneMax(Lane4 a, Lane4 b) { return _mm_max_ps(a, b); } // Larger of each lane
+inline void laneStore(float* p, Lane4 a) { _mm_storeu_ps(p, a); } // Store four lanes
+#else
+// Portable fallback with the same interface
+struct Lane4 { float v[4]; };
+inline Lane4 laneLoad(const float* p) { Lane4 r; for (int i = 0; i < 4; i++) r.v[i] = p[i]; return r; } // Load four lanes
+inline Lane4 laneSet(float s) { Lane4 r; for (int i = 0; i < 4; i++) r.v[i] = s; return r; } // Broadcast scalar
+inline Lane4 laneAdd(Lane4 a, Lane4 b) { for (int i = 0; i < 4; i++) a.v[i] += b.v[i]; return a; } // Add lanes
+inline Lane4 laneSub(Lane4 a, Lane4 b) { for (int i = 0; i < 4; i++) a.v[i] -= b.v[i]; return a; } // Subtract lanes
+inline Lane4 laneMul(Lane4 a, Lane4 b) { for (int i = 0; i < 4; i++) a.v[i] *= b.v[i]; return a; } // Multiply lanes
+inline Lane4 laneDiv(Lane4 a, Lane4 b) { for (int i = 0; i < 4; i++) a.v[i] /= b.v[i]; return a; } // Divide lanes
+inline Lane4 laneMax(Lane4 a, Lane4 b) { for (int i = 0; i < 4; i++) a.v[i] = a.v[i] > b.v[i] ? a.v[i] : b.v[i]; return a; } // Larger of each lane
+inline void laneStore(float* p, Lane4 a) { for (int i = 0; i < 4; i++) p[i] = a.v[i]; } // Store four lanes
+#endif
+
+// Constants for one object, laid out for a std430 shader storage buffer
+struct ObjectConstants {
+    glm::mat4 mvp; // projection * view * model
+    glm::mat4 model; // model
+    glm::mat4 normalMatrix; // transpose(inverse(mat3(model))) in the upper 3x3
+};
+
+// Binding point the vertex shaders read ObjectBuffer from
+const GLuint OBJECT_CONSTANTS_BINDING = 0;
+
+// Constants shared by every object in a frame, laid out for a std140 uniform block
+struct FrameConstants {
+    glm::vec3 lightPos; float pad0; // Light position
+    glm::vec3 viewPos; float pad1; // Camera position
+    glm::vec3 lightColor; float pad2; // Light color
+    glm::uvec4 clusterGrid; // Tiles across, tiles down, depth slices, point light count
+    glm::vec4 clusterDepth; // Near plane, far plane, slice scale, slice bias
+    glm::vec4 clusterTile; // Pixels per tile across and down
+    glm::vec4 shadowParams; // Shadow near plane, far plane (0 when off), normal offset and filter radius per unit depth
+};
+static_assert(sizeof(FrameConstants) == 112, "FrameConstants must match the std140 block"); // Check layout
+
+// Binding point the fragment shaders read FrameConstants from
+const GLuint FRAME_CONSTANTS_BINDING = 1;
+
+// Computes MVP, model and normal matrices once per object per frame on the CPU, four objects at a time,
+// and writes them into the frame's ring buffer region. Vertex shaders index the buffer with the objectIndex uniform instead of
+// multiplying and inverting matrices for every vertex.
+class ObjectConstantsStage {
+public:
+    // Constructor
+    ObjectConstantsStage() : count(0), mapped(NULL), mappedOffset(0) {}
+
+    // Adds an object and returns its index
+    GLuint Add(const glm::mat4& model) {
+        GLuint index = this->count++; // Next index
+        if (this->count > this->capacity()) { // If out of room
+            this->grow(); // Grow storage
+        }
+        this->SetModel(index, model); // Store model
+        return index; // Return index
+    }
+
+    // Replaces an object's model matrix
+    void SetModel(GLuint index, const glm::mat4& model) {
+        const float* m = glm::value_ptr(model); // Column-major elements
+        size_t stride = this->capacity(); // Stride between element rows
+        for (int e = 0; e < 16; e++) // Iterate over elements
+            this->models[e * stride + index] = m[e]; // Store element e of this object
+    }
+
+    // Returns an object's model matrix
+    glm::mat4 GetModel(GLuint index) const {
+        glm::mat4 model; // Gathered matrix
+        float* m = glm::value_ptr(model); // Column-major elements
+        size_t stride = this->capacity(); // Stride between element rows
+        for (int e = 0; e < 16; e++) // Iterate over elements
+            m[e] = this->models[e * stride + index]; // Load element e of this object
+        return model; // Return model
+    }
+
+    // Number of objects
+    GLuint Count() const {
+        return this->count; // Return count
+    }
+
+    // Computes constants for every object, writes them into the ring buffer and binds them as ObjectBuffer
+    void Update(const glm::mat4& viewProjection, RingBuffer& ring) {
+        this->constants.resize(this->count); // One entry per object
+        const float* vp = glm::value_ptr(viewProjection); // Shared view-projection
+        size_t stride = this->capacity(); // Stride between element rows
+        for (GLuint base = 0; base < this->count; base += 4) { // Four objects per pass
+            Lane4 m[16]; // Model elements, one object per lane
+            for (int e = 0; e < 16; e++) // Iterate over elements
+                m[e] = laneLoad(&this->models[e * stride + base]); // Load element e of four objects
+
+            Lane4 mvp[16]; // MVP elements
+            multiply(vp, m, mvp); // MVP of four objects
+
+            // Normal matrix: cofactors of the upper 3x3 divided by its determinant
+            Lane4 a = m[0], b = m[4], c = m[8]; // Row 0
+            Lane4 d = m[1], e = m[5], f = m[9]; // Row 1
+            Lane4 g = m[2], h = m[6], i = m[10]; // Row 2
+            Lane4 A = laneSub(laneMul(e, i), laneMul(f, h)); // Cofactor (0,0)
+            Lane4 B = laneSub(laneMul(f, g), laneMul(d, i)); // Cofactor (0,1)
+            Lane4 C = laneSub(laneMul(d, h), laneMul(e, g)); // Cofactor (0,2)
+            Lane4 D = laneSub(laneMul(c, h), laneMul(b, i)); // Cofactor (1,0)
+            Lane4 E = laneSub(laneMul(a, i), laneMul(c, g)); // Cofactor (1,1)
+            Lane4 F = laneSub(laneMul(b, g), laneMul(a, h)); // Cofactor (1,2)
+            Lane4 G = laneSub(laneMul(b, f), laneMul(c, e)); // Cofactor (2,0)
+            Lane4 H = laneSub(laneMul(c, d), laneMul(a, f)); // Cofactor (2,1)
+            Lane4 I = laneSub(laneMul(a, e), laneMul(b, d)); // Cofactor (2,2)
+            Lane4 det = laneAdd(laneAdd(laneMul(a, A), laneMul(b, B)), laneMul(c, C)); // Determinant
+            // transpose(inverse(M)) is the cofactor matrix over the determinant
+            Lane4 normal[9] = { A, D, G, B, E, H, C, F, I }; // Cofactor matrix in column-major order
+            for (int n = 0; n < 9; n++) // Iterate over elements
+                normal[n] = laneDiv(normal[n], det); // Divide by determinant
+
+            // Scatter lanes back to one struct per object
+            float lanes[4]; // Scratch for one element of four objects
+            GLuint batch = (this->count - base < 4) ? this->count - base : 4; // Objects in this pass
+            for (int n = 0; n < 16; n++) { // Iterate over elements
+                laneStore(lanes, mvp[n]); // MVP element
+                for (GLuint o = 0; o < batch; o++) glm::value_ptr(this->constants[base + o].mvp)[n] = lanes[o]; // Scatter
+                laneStore(lanes, m[n]); // Model element
+                for (GLuint o = 0; o < batch; o++) glm::value_ptr(this->constants[base + o].model)[n] = lanes[o]; // Scatter
+            }
+            for (GLuint o = 0; o < batch; o++) // Iterate over objects
+                this->constants[base + o].normalMatrix = glm::mat4(1.0f); // Clear padding
+            for (int col = 0; col < 3; col++) { // Iterate over columns
+                for (int row = 0; row < 3; row++) { // Iterate over rows
+                    laneStore(lanes, normal[col * 3 + row]); // Normal element
+                    for (GLuint o = 0; o < batch; o++) this->constants[base + o].normalMatrix[col][row] = lanes[o]; // Scatter
+                }
+            }
+        }
+
+        // Write into this frame's region and bind for the vertex shaders
+        GLsizeiptr size = this->count * sizeof(ObjectConstants); // Bytes to write
+        GLintptr offset; // Offset in the ring buffer
+        void* dst = ring.Allocate(size, offset); // Reserve space
+        this->mapped = (ObjectConstants*)dst; // Kept for Latch
+        this->mappedOffset = offset;
+        if (!dst) // If the frame is out of space
+            return;
+        memcpy(dst, this->constants.data(), size); // Write constants
+        ring.BindRange(GL_SHADER_STORAGE_BUFFER, OBJECT_CONSTANTS_BINDING, offset, size); // Bind to shader binding point
+    }
+
+    // Recomputes every object's MVP for a newer view-projection and writes it over the one Update wrote into the
+    // frame's ring buffer region, then flushes the region so draws issued after this call see the new matrices
+    // whether or not the ring is persistently mapped. Draws already issued may not.
+    void Latch(const glm::mat4& viewProjection, RingBuffer& ring) {
+        if (!this->mapped) // If Update had no room this frame
+            return;
+        const float* vp = glm::value_ptr(viewProjection); // Shared view-projection
+        size_t stride = this->capacity(); // Stride between element rows
+        for (GLuint base = 0; base < this->count; base += 4) { // Four objects per pass
+            Lane4 m[16]; // Model elements, one object per lane
+            for (int e = 0; e < 16; e++) // Iterate over elements
+                m[e] = laneLoad(&this->models[e * stride + base]); // Load element e of four objects
+            Lane4 mvp[16]; // MVP elements
+            multiply(vp, m, mvp); // MVP of four objects
+            float lanes[4]; // Scratch for one element of four objects
+            GLuint batch = (this->count - base < 4) ? this->count - base : 4; // Objects in this pass
+            for (int n = 0; n < 16; n++) { // Iterate over elements
+                laneStore(lanes, mvp[n]); // MVP element
+                for (GLuint o = 0; o < batch; o++) glm::value_ptr(this->constants[base + o].mvp)[n] = lanes[o]; // Scatter
+            }
+            for (GLuint o = 0; o < batch; o++) // Iterate over objects
+                memcpy(&this->mapped[base + o].mvp, &this->constants[base + o].mvp, sizeof(glm::mat4)); // Whole matrix at once into mapped memory
+        }
+        ring.Flush(this->mappedOffset, this->count * sizeof(ObjectConstants)); // Upload again without a persistent mapping
+    }
+
+    // True when the buffer the vertex shaders read holds the MVPs of the last Update or Latch. Reads the
+    // region back from the GPU, so it stalls; meant to be called once to check that latching works.
+    bool Latched(RingBuffer& ring) const {
+        if (!this->mapped || !this->count) // If nothing was written
+            return true;
+        std::vector<ObjectConstants> gpu(this->count); // Buffer contents
+        ring.ReadBack(this->mappedOffset, this->count * sizeof(ObjectConstants), &gpu[0]); // Read region
+        for (GLuint o = 0; o < this->count; o++) // Iterate over objects
+            if (memcmp(&gpu[o].mvp, &this->constants[o].mvp, sizeof(glm::mat4)) != 0) // If the GPU has another matrix
+                return false;
+        return true;
+    }
+
+    // Returns the constants computed by the last Update()
+    const ObjectConstants& Get(GLuint index) const {
+        return this->constants[index]; // Return constants
+    }
+
+private:
+    GLuint count; // Objects in use
+    std::vector<float> models; // Model matrices stored element-major: 16 rows of capacity() floats
+
+    std::vector<ObjectConstants> constants; // Output of the last Update()
+    ObjectConstants* mapped; // Where the last Update wrote them in the ring buffer, NULL if it had no room
+    GLintptr mappedOffset; // Their offset in the ring buffer
+
+    // MVP elements of four objects: out[col][row] = sum over k of vp[k][row] * m[col][k]
+    static void multiply(const float* vp, const Lane4* m, Lane4* mvp) {
+        for (int col = 0; col < 4; col++) { // Iterate over columns
+            for (int row = 0; row < 4; row++) { // Iterate over rows
+                Lane4 sum = laneMul(laneSet(vp[row]), m[col * 4]); // k = 0
+                for (int k = 1; k < 4; k++) // Remaining terms
+                    sum = laneAdd(sum, laneMul(laneSet(vp[k * 4 + row]), m[col * 4 + k])); // Accumulate
+                mvp[col * 4 + row] = sum; // Store element
+            }
+        }
+    }
+
+    // Objects that fit before the element rows need to grow, always a multiple of 4
+    size_t capacity() const {
+        return this->models.size() / 16; // Row length
+    }
+
+    // Doubles the row length, keeping existing elements
+    void grow() {
+        size_t oldStride = this->capacity(); // Current row length
+        size_t newStride = oldStride ? oldStride * 2 : 4; // New row length
+        while (newStride < this->count) // Ensure it fits
+            newStride *= 2; // Double again
+        std::vector<float> grown(16 * newStride, 0.0f); // Zeroed storage; unused lanes stay harmless
+        for (int e = 0; e < 16; e++) // Iterate over elements
+            for (size_t o = 0; o < oldStride; o++) // Iterate over objects
+                grown[e * newStride + o] = this->models[e * oldStride + o]; // Copy element
+        this->models.swap(grown); // Use new storage
+    }
+};
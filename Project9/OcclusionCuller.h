@@ -0,0 +1,180 @@
+// Occlusion Culler
+
+#pragma once
+
+#include <vector> // Include vector
+
+#include <GL/glew.h> // Include glew
+#include <glm/glm.hpp> // Include glm
+
+#include "shader.h" // Include shader pipelines
+#include "GLState.h" // Include GL state cache
+#include "VertexLayout.h" // Include vertex layout descriptors
+
+// Hardware occlusion culling with temporal coherence. After each frame's draws, every object's bounding box is
+// drawn with color and depth writes off inside a GL_ANY_SAMPLES_PASSED_CONSERVATIVE query. The next frame
+// decides visibility from whichever results have arrived, never waiting for one:
+//   result arrived, samples passed  -> draw
+//   result arrived, no samples      -> skip
+//   still pending                   -> draw inside glBeginConditionalRender on the pending query, so the GPU
+//                                      skips it if the result lands in time
+// An object that comes out from behind an occluder appears one frame late, the usual price of not stalling.
+class OcclusionCuller {
+public:
+    // Decision for one object this frame
+    enum Visibility {
+        VISIBLE, // Draw
+        OCCLUDED, // Skip
+        PENDING // Draw conditionally on the returned query
+    };
+
+    // Counts for one frame
+    struct FrameStats {
+        unsigned int drawn; // Objects drawn unconditionally
+        unsigned int culled; // Objects skipped
+        unsigned int conditional; // Objects drawn on a pending query
+        unsigned int queries; // Proxy queries issued
+    };
+
+    // Constructor
+    OcclusionCuller() : shader("occlusion.vs", "occlusion.frag"), enabled(true) {
+        this->stats = FrameStats(); // Zero counts
+    }
+
+    // Turns culling on or off. When off every object is drawn and no queries are issued.
+    void Enable(bool on) {
+        this->enabled = on; // Set flag
+    }
+
+    // Vertex stage of the proxy pipeline, for layout validation
+    GLuint VertexProgram() const {
+        return this->shader.VertexProgram; // Return vertex stage
+    }
+
+    // Gives an object an object-space bounding box. Objects without one are always drawn.
+    void Add(GLuint objectIndex, const glm::vec3& min, const glm::vec3& max) {
+        if (objectIndex >= this->objects.size()) // If beyond known objects
+            this->objects.resize(objectIndex + 1); // Grow, new entries unregistered
+        Occludee& object = this->objects[objectIndex]; // Entry
+        glm::vec3 pad = (max - min) * 0.01f + glm::vec3(0.001f); // Keep the proxy off the object's own surface
+        object.min = min - pad; // Store minimum
+        object.max = max + pad; // Store maximum
+        object.registered = true; // Culled from now on
+        if (!object.query) // If no query yet
+            glGenQueries(1, &object.query); // Create query
+    }
+
+    // Collects every query result that has arrived, without waiting for the rest
+    void BeginFrame() {
+        this->stats = FrameStats(); // Zero counts
+        for (size_t i = 0; i < this->objects.size(); i++) { // Iterate over objects
+            Occludee& object = this->objects[i]; // Entry
+            object.skipQuery = false; // Re-evaluated by Test
+            if (!object.pending) // If no query in flight
+                continue;
+            GLuint available = 0; // Result ready
+            glGetQueryObjectuiv(object.query, GL_QUERY_RESULT_AVAILABLE, &available); // Poll
+            if (!available) // If the GPU has not got there yet
+                continue; // Keep last answer, stay pending
+            GLuint passed = 0; // Any samples passed
+            glGetQueryObjectuiv(object.query, GL_QUERY_RESULT, &passed); // Read result, already available
+            object.visible = passed != 0; // Visible if any sample passed
+            object.pending = false; // Query free for reuse
+        }
+    }
+
+    // Decides whether to draw an object this frame. model places its box in the world and eye is the camera
+    // position. condition receives the query to render on for PENDING, and 0 otherwise.
+    Visibility Test(GLuint objectIndex, const glm::mat4& model, const glm::vec3& eye, GLuint& condition) {
+        condition = 0; // No condition by default
+        if (!this->enabled || objectIndex >= this->objects.size() || !this->objects[objectIndex].registered) { // If not culled
+            this->stats.drawn++; // Count draw
+            return VISIBLE;
+        }
+        Occludee& object = this->objects[objectIndex]; // Entry
+        if (cameraInside(object, model, eye)) { // If the near plane may clip the proxy
+            object.visible = true; // A clipped proxy could pass no samples, so trust nothing but visible
+            object.skipQuery = true; // And do not ask
+            this->stats.drawn++; // Count draw
+            return VISIBLE;
+        }
+        if (object.pending) { // If last query has not come back
+            condition = object.query; // Let the GPU decide
+            this->stats.conditional++; // Count conditional draw
+            return PENDING;
+        }
+        if (!object.visible) { // If hidden last time
+            this->stats.culled++; // Count cull
+            return OCCLUDED;
+        }
+        this->stats.drawn++; // Count draw
+        return VISIBLE;
+    }
+
+    // Draws the bounding box proxies of every object without a query in flight, against the depth buffer the
+    // frame's draws just wrote. box is a unit cube centered on the origin. Call after the frame's draws, while
+    // the frame's object constants are still bound.
+    void IssueQueries(const DrawGeometry& box) {
+        if (!this->enabled) // If off
+            return;
+        GLStateCache& state = GLStateCache::Get(); // State cache
+        state.ColorMask(GL_FALSE); // Proxies are invisible
+        state.DepthMask(GL_FALSE); // And do not occlude each other
+        state.Enable(GL_DEPTH_TEST); // But are tested against the scene
+        state.DepthFunc(GL_LEQUAL); // Faces lying on a flat object's own surface still pass
+        this->shader.Use(); // Use proxy pipeline
+        BindDrawGeometry(box); // Bind unit cube
+        for (size_t i = 0; i < this->objects.size(); i++) { // Iterate over objects
+            Occludee& object = this->objects[i]; // Entry
+            if (!object.registered || object.pending || object.skipQuery) // If not culled, still in flight or inside
+                continue;
+            this->shader.SetUint("objectIndex", (GLuint)i); // Select object constants
+            this->shader.SetVec3("boundsMin", object.min); // Box minimum
+            this->shader.SetVec3("boundsMax", object.max); // Box maximum
+            glBeginQuery(GL_ANY_SAMPLES_PASSED_CONSERVATIVE, object.query); // Count samples
+            glDrawArrays(GL_TRIANGLES, 0, box.count); // Draw proxy
+            glEndQuery(GL_ANY_SAMPLES_PASSED_CONSERVATIVE); // Stop counting
+            object.pending = true; // Result arrives in a later frame
+            this->stats.queries++; // Count query
+        }
+        state.ColorMask(GL_TRUE); // Restore color writes
+        state.DepthMask(GL_TRUE); // Restore depth writes
+        state.DepthFunc(GL_LESS); // Restore depth function
+    }
+
+    // Returns this frame's counts
+    FrameStats Stats() const {
+        return this->stats; // Return counts
+    }
+
+private:
+    // Culling state for one object
+    struct Occludee {
+        glm::vec3 min, max; // Object-space bounding box
+        GLuint query; // Occlusion query, reused every time its result arrives
+        bool registered; // Has a bounding box
+        bool pending; // Query issued and result not read yet
+        bool visible; // Last known result
+        bool skipQuery; // Camera inside the box this frame
+        Occludee() : min(0.0f), max(0.0f), query(0), registered(false), pending(false), visible(true), skipQuery(false) {}
+    };
+
+    ShaderPipeline shader; // Proxy pipeline
+    bool enabled; // Culling on
+    std::vector<Occludee> objects; // Entry per object index
+    FrameStats stats; // Counts for the current frame
+
+    // True when the eye is within the object's world-space box grown by a margin for the near plane
+    static bool cameraInside(const Occludee& object, const glm::mat4& model, const glm::vec3& eye) {
+        glm::vec3 lo(1e30f), hi(-1e30f); // World-space box
+        for (int c = 0; c < 8; c++) { // Iterate over corners
+            glm::vec3 corner((c & 1) ? object.max.x : object.min.x, (c & 2) ? object.max.y : object.min.y, (c & 4) ? object.max.z : object.min.z); // Object-space corner
+            glm::vec3 world = glm::vec3(model * glm::vec4(corner, 1.0f)); // World-space corner
+            lo = glm::min(lo, world); // Grow minimum
+            hi = glm::max(hi, world); // Grow maximum
+        }
+        const float margin = 0.2f; // More than the 0.1 near plane distance
+        return eye.x > lo.x - margin && eye.y > lo.y - margin && eye.z > lo.z - margin &&
+               eye.x < hi.x + margin && eye.y < hi.y + margin && eye.z < hi.z + margin; // Inside grown box
+    }
+};
@@ -0,0 +1,246 @@
+// Frame Profiler
+
+#pragma once
+
+#include <algorithm> // Include algorithm for nth_element
+#include <chrono> // Include chrono
+#include <deque> // Include deque
+#include <fstream> // Include fstream
+#include <iomanip> // Include iomanip
+#include <iostream> // Include iostream
+#include <map> // Include map
+#include <string> // Include string
+#include <vector> // Include vector
+
+#include <GL/glew.h> // Include glew
+
+// Scoped CPU/GPU timing zones. Each zone records CPU time with a steady clock and GPU time with a pair of
+// GL_TIMESTAMP queries (glQueryCounter), which unlike GL_TIME_ELAPSED may nest. Query results are read
+// back LATENCY frames later and only if already available, so profiling never waits on the GPU.
+// Finished frames are written to CSV/JSON streams and kept in a rolling window for percentile stats.
+class Profiler {
+public:
+    static const int LATENCY = 4; // Frames between recording and reading back
+    static const int WINDOW = 240; // Frames kept for percentiles
+
+    // Returns the profiler
+    static Profiler& Get() {
+        static Profiler profiler; // Single profiler
+        return profiler; // Return profiler
+    }
+
+    // Turns recording on. Zones are free when it is off.
+    void Enable() {
+        this->enabled = true; // Enable
+    }
+
+    // Whether zones are recorded
+    bool Enabled() const {
+        return this->enabled; // Return flag
+    }
+
+    // Streams every finished frame as CSV rows: frame,zone,depth,cpu_ms,gpu_ms (gpu_ms is -1 if unavailable)
+    bool OpenCSV(const char* path) {
+        this->csv.open(path); // Open file
+        if (!this->csv) { // If failed
+            std::cout << "ERROR::PROFILER::CSV_NOT_OPENED " << path << std::endl; // Error message
+            return false;
+        }
+        this->csv << "frame,zone,depth,cpu_ms,gpu_ms" << std::endl; // Header
+        return true;
+    }
+
+    // Streams every finished frame as one JSON object per line
+    bool OpenJSON(const char* path) {
+        this->json.open(path); // Open file
+        if (!this->json) { // If failed
+            std::cout << "ERROR::PROFILER::JSON_NOT_OPENED " << path << std::endl; // Error message
+            return false;
+        }
+        return true;
+    }
+
+    // Starts a frame and retires the frame recorded LATENCY frames ago
+    void BeginFrame() {
+        if (!this->enabled) // If off
+            return;
+        this->slot = (int)(this->frame % SLOTS); // Slot for this frame
+        FrameRecord& old = this->frames[this->slot]; // Slot's previous frame
+        if (!old.zones.empty()) // If it holds a frame
+            this->retire(old); // Read back and report it
+        old.zones.clear(); // Reuse slot
+        old.frame = this->frame; // Frame number
+        old.queriesUsed = 0; // Reuse queries
+        this->open.clear(); // No zones open
+        this->recording = true; // Accept zones
+        this->Begin("frame"); // Whole-frame zone
+    }
+
+    // Ends the frame
+    void EndFrame() {
+        if (!this->enabled) // If off
+            return;
+        while (!this->open.empty()) // Close anything left open, including the frame zone
+            this->End(); // Close zone
+        this->recording = false; // Ignore zones until the next frame
+        this->frame++; // Next frame
+    }
+
+    // Opens a zone
+    void Begin(const char* name) {
+        if (!this->recording) // If off or between frames
+            return;
+        FrameRecord& record = this->frames[this->slot]; // Current frame
+        ZoneRecord zone; // New zone
+        zone.name = name; // Name
+        zone.depth = (int)this->open.size(); // Nesting depth
+        zone.cpuStart = now(); // CPU start
+        zone.cpuEnd = zone.cpuStart; // Until closed
+        zone.queryStart = this->query(record); // GPU start query
+        zone.queryEnd = this->query(record); // GPU end query
+        glQueryCounter(zone.queryStart, GL_TIMESTAMP); // Timestamp after prior commands
+        record.zones.push_back(zone); // Store zone
+        this->open.push_back(record.zones.size() - 1); // Track open zone
+    }
+
+    // Closes the innermost open zone
+    void End() {
+        if (!this->recording || this->open.empty()) // If off or nothing open
+            return;
+        ZoneRecord& zone = this->frames[this->slot].zones[this->open.back()]; // Innermost zone
+        glQueryCounter(zone.queryEnd, GL_TIMESTAMP); // Timestamp after the zone's commands
+        zone.cpuEnd = now(); // CPU end
+        this->open.pop_back(); // Close zone
+    }
+
+    // Adds a sample to a named measurement that is not a zone, such as a latency. Ignored when off.
+    void Record(const char* name, double ms) {
+        if (!this->enabled) // If off
+            return;
+        push(this->measures[name], ms); // Add sample
+    }
+
+    // Prints p50/p95/p99 of CPU and GPU time per zone, then of each measurement, over the rolling window
+    void PrintStats(std::ostream& out) {
+        if (!this->enabled) // If off
+            return;
+        out << std::fixed << std::setprecision(3); // Milliseconds with microsecond digits
+        out << "zone                 cpu p50/p95/p99 ms          gpu p50/p95/p99 ms" << std::endl; // Header
+        for (std::map<std::string, ZoneHistory>::iterator it = this->history.begin(); it != this->history.end(); ++it) { // Iterate over zones
+            out << std::left << std::setw(20) << it->first << std::right << " "; // Zone name
+            out << std::setw(7) << percentile(it->second.cpu, 0.50) << " " << std::setw(7) << percentile(it->second.cpu, 0.95) << " " << std::setw(7) << percentile(it->second.cpu, 0.99) << "     "; // CPU
+            out << std::setw(7) << percentile(it->second.gpu, 0.50) << " " << std::setw(7) << percentile(it->second.gpu, 0.95) << " " << std::setw(7) << percentile(it->second.gpu, 0.99) << std::endl; // GPU
+        }
+        for (std::map<std::string, std::deque<double> >::iterator it = this->measures.begin(); it != this->measures.end(); ++it) { // Iterate over measurements
+            out << std::left << std::setw(20) << it->first << std::right << " "; // Measurement name
+            out << std::setw(7) << percentile(it->second, 0.50) << " " << std::setw(7) << percentile(it->second, 0.95) << " " << std::setw(7) << percentile(it->second, 0.99) << std::endl; // Samples
+        }
+        out.unsetf(std::ios::floatfield); // Restore float format
+    }
+
+private:
+    static const int SLOTS = LATENCY + 1; // Frames in flight plus the one being recorded
+
+    // One zone instance
+    struct ZoneRecord {
+        const char* name; // Zone name
+        int depth; // Nesting depth
+        double cpuStart, cpuEnd; // CPU times in ms
+        GLuint queryStart, queryEnd; // Timestamp queries
+    };
+
+    // Zones recorded in one frame
+    struct FrameRecord {
+        unsigned long long frame; // Frame number
+        std::vector<ZoneRecord> zones; // Zones in open order
+        std::vector<GLuint> queries; // Query pool for this slot
+        size_t queriesUsed; // Queries handed out this frame
+    };
+
+    // Rolling per-frame totals for one zone name
+    struct ZoneHistory {
+        std::deque<double> cpu; // CPU ms per frame
+        std::deque<double> gpu; // GPU ms per frame
+    };
+
+    bool enabled; // Profiling on
+    bool recording; // Inside BeginFrame/EndFrame
+    unsigned long long frame; // Current frame number
+    int slot; // Slot being recorded
+    FrameRecord frames[SLOTS]; // Frames in flight
+    std::vector<size_t> open; // Open zone indices, innermost last
+    std::map<std::string, ZoneHistory> history; // Rolling stats per zone name
+    std::map<std::string, std::deque<double> > measures; // Rolling samples per measurement name
+    std::ofstream csv; // CSV stream
+    std::ofstream json; // JSON lines stream
+
+    // Constructor
+    Profiler() : enabled(false), recording(false), frame(0), slot(0) {}
+
+    // Milliseconds on a steady clock
+    static double now() {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count(); // Current time
+    }
+
+    // Hands out a query from a slot's pool, creating more as needed
+    static GLuint query(FrameRecord& record) {
+        if (record.queriesUsed == record.queries.size()) { // If pool exhausted
+            GLuint q; // New query
+            glGenQueries(1, &q); // Create query
+            record.queries.push_back(q); // Add to pool
+        }
+        return record.queries[record.queriesUsed++]; // Next query
+    }
+
+    // Reads back a finished frame, writes it out and adds it to the rolling stats
+    void retire(FrameRecord& record) {
+        GLint available = 0; // Result ready
+        glGetQueryObjectiv(record.zones[0].queryEnd, GL_QUERY_RESULT_AVAILABLE, &available); // Frame zone ends last
+        std::map<std::string, std::pair<double, double> > totals; // Per-name totals this frame
+        if (this->json.is_open()) // If streaming JSON
+            this->json << "{\"frame\":" << record.frame << ",\"zones\":["; // Open frame object
+        for (size_t i = 0; i < record.zones.size(); i++) { // Iterate over zones
+            const ZoneRecord& zone = record.zones[i]; // Zone
+            double cpu = zone.cpuEnd - zone.cpuStart; // CPU ms
+            double gpu = -1.0; // GPU ms, unknown unless ready
+            if (available) { // If timestamps ready, never wait for them
+                GLuint64 start = 0, end = 0; // Timestamps in ns
+                glGetQueryObjectui64v(zone.queryStart, GL_QUERY_RESULT, &start); // Start time
+                glGetQueryObjectui64v(zone.queryEnd, GL_QUERY_RESULT, &end); // End time
+                gpu = (end - start) / 1000000.0; // Nanoseconds to ms
+            }
+            std::pair<double, double>& total = totals[zone.name]; // Total for this name
+            total.first += cpu; // Sum CPU
+            total.second = (gpu < 0.0 || total.second < 0.0) ? -1.0 : total.second + gpu; // Sum GPU unless unknown
+            if (this->csv.is_open()) // If streaming CSV
+                this->csv << record.frame << "," << zone.name << "," << zone.depth << "," << cpu << "," << gpu << "\n"; // Row
+            if (this->json.is_open()) // If streaming JSON
+                this->json << (i ? "," : "") << "{\"name\":\"" << zone.name << "\",\"depth\":" << zone.depth << ",\"cpu_ms\":" << cpu << ",\"gpu_ms\":" << gpu << "}"; // Zone object
+        }
+        if (this->json.is_open()) // If streaming JSON
+            this->json << "]}\n"; // Close frame object
+        for (std::map<std::string, std::pair<double, double> >::iterator it = totals.begin(); it != totals.end(); ++it) { // Iterate over names
+            ZoneHistory& zoneHistory = this->history[it->first]; // History for name
+            push(zoneHistory.cpu, it->second.first); // Add CPU sample
+            if (it->second.second >= 0.0) // If GPU time known
+                push(zoneHistory.gpu, it->second.second); // Add GPU sample
+        }
+    }
+
+    // Appends a sample, keeping WINDOW samples
+    static void push(std::deque<double>& samples, double value) {
+        samples.push_back(value); // Add sample
+        if (samples.size() > WINDOW) // If window full
+            samples.pop_front(); // Drop oldest
+    }
+
+    // Returns the p-th percentile of samples, or -1 when there are none
+    static double percentile(const std::deque<double>& samples, double p) {
+        if (samples.empty()) // If no samples
+            return -1.0;
+        std::vector<double> sorted(samples.begin(), samples.end()); // Copy
+        size_t k = (size_t)(p * (sorted.size() - 1) + 0.5); // Nearest rank
+        std::nth_element(sorted.begin(), sorted.begin() + k, sorted.end()); // Partial sort
+        return sorted[k]; // Return percentile
+    }
+};
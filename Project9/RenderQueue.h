@@ -0,0 +1,264 @@
+// Render Queue
+
+#pragma once
+
+#include <cstring> // Include cstring for memcpy
+#include <map> // Include map
+#include <vector> // Include vector
+
+#include <GL/glew.h> // Include glew
+#include <glm/glm.hpp> // Include glm
+
+#include "shader.h" // Include shader pipelines
+#include "GLState.h" // Include GL state cache
+#include "VertexLayout.h" // Include vertex layout descriptors
+#include "Profiler.h" // Include frame profiler
+
+// Surface shared by many draws: the pipeline, its color uniform and how it blends
+struct Material {
+    const char* name; // Name for profiling zones
+    ShaderPipeline* shader; // Pipeline to draw with
+    glm::vec3 color; // Color passed to the fragment stage's objectColor
+    bool blended; // Drawn after opaque draws, back to front, with blending on and depth writes off
+};
+
+// Collects draw packets for a frame, sorts them by a 64-bit key and issues them with as few state changes
+// as possible. Opaque draws are grouped by program, vertex array and material and go front to back inside
+// each group for early depth rejection; blended draws go strictly back to front after all opaque draws.
+//
+// Key layout, most significant bit first:
+//   opaque:  0 | program:8 | vao:8 | material:12 | depth:24 | unused:11
+//   blended: 1 | ~depth:24 | program:8 | vao:8 | material:12 | unused:11
+//
+// With the depth pre-pass on, opaque draws are issued twice. The first pass writes depth only, from each
+// mesh's position stream with a one-stage pipeline. The color pass then tests with GL_EQUAL and writes no
+// depth, so every pixel runs the expensive fragment stage once, for the surface that ends up visible.
+// Occlusion conditions only apply to the pre-pass: anything it skipped left no matching depth, so the
+// color pass cannot draw it either, even if the query result lands between the two passes.
+class RenderQueue {
+public:
+    RenderQueue() : depthShader(NULL), depthPrepass(false) {} // Constructor
+
+    // Sets the pipeline for the depth pre-pass. Its vertex stage must give the same gl_Position as every
+    // material's (declare it invariant in both).
+    void SetDepthPipeline(ShaderPipeline* shader) {
+        this->depthShader = shader; // Store pipeline
+    }
+
+    // Turns the depth pre-pass on or off. Has no effect until a depth pipeline is set.
+    void EnableDepthPrepass(bool on) {
+        this->depthPrepass = on; // Set flag
+    }
+
+    // Whether Flush runs the depth pre-pass
+    bool DepthPrepass() const {
+        return this->depthPrepass && this->depthShader; // Return flag
+    }
+
+    // Registers a material and returns its id
+    GLuint AddMaterial(const Material& material) {
+        std::map<ShaderPipeline*, GLuint>::iterator it = this->programIds.find(material.shader); // Look up program id
+        if (it == this->programIds.end()) // If first material using this pipeline
+            it = this->programIds.insert(std::make_pair(material.shader, (GLuint)this->programIds.size())).first; // Next program id
+        this->materials.push_back(material); // Store material
+        this->materialPrograms.push_back(it->second); // Remember its program id
+        return (GLuint)this->materials.size() - 1; // Return material id
+    }
+
+    // Starts a new frame
+    void Begin() {
+        this->packets.clear(); // Drop last frame's packets
+        this->keys.clear(); // Drop last frame's keys
+    }
+
+    // Queues one draw. viewDepth is the distance in front of the camera, used to order draws. A non-zero
+    // condition is an occlusion query the draw is conditionally rendered on.
+    void Submit(GLuint material, const DrawGeometry& geometry, GLuint objectIndex, float viewDepth, GLuint condition = 0) {
+        DrawPacket packet = { material, geometry, objectIndex, condition }; // Packet
+        this->packets.push_back(packet); // Store packet
+        this->keys.push_back(this->makeKey(material, geometry.vao, viewDepth)); // Store sort key
+    }
+
+    // Sorts the queued draws and issues them
+    void Flush() {
+        this->sort(); // Radix sort keys
+        GLStateCache& state = GLStateCache::Get(); // State cache
+        Profiler& profiler = Profiler::Get(); // Frame profiler
+        bool prepass = this->DepthPrepass(); // Lay down depth first
+        if (prepass) { // If pre-pass on
+            profiler.Begin("depth prepass"); // Time the depth-only draws
+            state.ColorMask(GL_FALSE); // Depth only
+            state.DepthMask(GL_TRUE); // Write depth
+            state.DepthFunc(GL_LESS); // Nearest surface wins
+            this->depthShader->Use(); // Depth pipeline
+            const char* zone = NULL; // Geometry zone open inside the pre-pass
+            for (size_t k = 0; k < this->order.size(); k++) { // Iterate over sorted packets
+                const DrawPacket& packet = this->packets[this->order[k]]; // Packet
+                if (this->materials[packet.material].blended) // If blended, every later draw is too
+                    break; // Blended draws do not occlude
+                switchZone(zone, packet.geometry.zone); // Time model meshes apart
+                this->depthShader->SetUint("objectIndex", packet.objectIndex); // Select object constants
+                BindDepthGeometry(packet.geometry); // Bind position stream
+                draw(packet, true); // Draw depth
+            }
+            switchZone(zone, NULL); // Close any geometry zone
+            state.ColorMask(GL_TRUE); // Restore color writes
+            state.DepthMask(GL_FALSE); // Depth is final
+            state.DepthFunc(GL_EQUAL); // Shade only the visible surface
+            profiler.End(); // End depth prepass
+        }
+        ShaderPipeline* lastShader = NULL; // Pipeline in use
+        GLuint lastMaterial = 0xFFFFFFFFu; // Material whose uniforms are set
+        const char* zone = NULL; // Geometry zone open inside the material's
+        bool blending = false; // Blended pass started
+        for (size_t k = 0; k < this->order.size(); k++) { // Iterate over sorted packets
+            const DrawPacket& packet = this->packets[this->order[k]]; // Packet
+            const Material& material = this->materials[packet.material]; // Its material
+            if (material.blended && !blending) { // If first blended draw
+                state.Enable(GL_BLEND); // Enable blending
+                state.BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA); // Standard alpha blending
+                state.DepthMask(GL_FALSE); // Test against opaque depth without writing
+                state.DepthFunc(GL_LESS); // Blended surfaces are not in the pre-pass depth
+                blending = true; // Blended pass started
+            }
+            if (material.shader != lastShader) { // If pipeline changed
+                material.shader->Use(); // Use pipeline
+                lastShader = material.shader; // Remember pipeline
+            }
+            if (packet.material != lastMaterial) { // If material changed
+                switchZone(zone, NULL); // Geometry zones nest inside the material's
+                if (lastMaterial != 0xFFFFFFFFu) // If a material zone is open
+                    profiler.End(); // Close it
+                profiler.Begin(material.name); // Time this material's draws
+                material.shader->SetVec3("objectColor", material.color); // Set material color
+                lastMaterial = packet.material; // Remember material
+            }
+            switchZone(zone, packet.geometry.zone); // Time model meshes apart
+            material.shader->SetUint("objectIndex", packet.objectIndex); // Select object constants
+            BindDrawGeometry(packet.geometry); // Bind vertex and index buffers
+            draw(packet, !prepass || material.blended); // Pre-pass already applied the condition to opaque draws
+        }
+        switchZone(zone, NULL); // Close any geometry zone
+        if (lastMaterial != 0xFFFFFFFFu) // If a material zone is open
+            profiler.End(); // Close it
+        if (blending) // If blended pass ran
+            state.Disable(GL_BLEND); // Restore blending
+        if (blending || prepass) { // If depth state changed
+            state.DepthMask(GL_TRUE); // Restore depth writes
+            state.DepthFunc(GL_LESS); // Restore depth function
+        }
+    }
+
+    // Number of draws queued this frame
+    size_t Size() const {
+        return this->packets.size(); // Return packet count
+    }
+
+    // Distance in front of the camera of a model's origin
+    static float ViewDepth(const glm::mat4& view, const glm::mat4& model) {
+        glm::vec4 center = view * model[3]; // Origin in view space
+        return -center.z; // Camera looks down -z
+    }
+
+private:
+    // One queued draw
+    struct DrawPacket {
+        GLuint material; // Material id
+        DrawGeometry geometry; // Buffers and vertex count
+        GLuint objectIndex; // Index into the object constants buffer
+        GLuint condition; // Occlusion query to render on, or 0
+    };
+
+    std::vector<Material> materials; // Registered materials
+    std::vector<GLuint> materialPrograms; // Program id per material
+    std::map<ShaderPipeline*, GLuint> programIds; // Small id per pipeline for the key
+    std::map<GLuint, GLuint> vaoIds; // Small id per vertex array for the key
+    std::vector<DrawPacket> packets; // This frame's packets
+    std::vector<unsigned long long> keys; // Sort key per packet
+    std::vector<unsigned long long> scratchKeys; // Radix sort scratch keys
+    std::vector<GLuint> order; // Packet indices in draw order
+    std::vector<GLuint> scratchOrder; // Radix sort scratch indices
+    ShaderPipeline* depthShader; // Depth pre-pass pipeline, or NULL
+    bool depthPrepass; // Pre-pass requested
+
+    // Closes the open geometry zone and opens next if they differ. Runs of packets sharing a zone get one.
+    static void switchZone(const char*& open, const char* next) {
+        if (open == next) // If unchanged
+            return;
+        Profiler& profiler = Profiler::Get(); // Frame profiler
+        if (open) // If a zone is open
+            profiler.End(); // Close it
+        if (next) // If the next draws are timed
+            profiler.Begin(next); // Open their zone
+        open = next; // Remember zone
+    }
+
+    // Issues a packet's draw with its geometry already bound, on its occlusion query if conditional
+    static void draw(const DrawPacket& packet, bool conditional) {
+        conditional = conditional && packet.condition != 0; // Only if visibility is still being decided by a query
+        if (conditional) // If conditional
+            glBeginConditionalRender(packet.condition, GL_QUERY_NO_WAIT); // GPU skips the draw if the query finished with no samples
+        if (packet.geometry.ebo != 0) // If indexed
+            glDrawElements(GL_TRIANGLES, packet.geometry.count, GL_UNSIGNED_INT, 0); // Draw elements
+        else
+            glDrawArrays(GL_TRIANGLES, 0, packet.geometry.count); // Draw arrays
+        if (conditional) // If conditional
+            glEndConditionalRender(); // End condition
+    }
+
+    // Builds the sort key for a draw
+    unsigned long long makeKey(GLuint material, GLuint vao, float viewDepth) {
+        std::map<GLuint, GLuint>::iterator it = this->vaoIds.find(vao); // Look up vao id
+        if (it == this->vaoIds.end()) // If first draw with this vertex array
+            it = this->vaoIds.insert(std::make_pair(vao, (GLuint)this->vaoIds.size())).first; // Next vao id
+        unsigned long long program = this->materialPrograms[material] & 0xFF; // 8-bit program id
+        unsigned long long array = it->second & 0xFF; // 8-bit vao id
+        unsigned long long mat = material & 0xFFF; // 12-bit material id
+        unsigned long long depth = depthBits(viewDepth); // 24-bit depth
+        if (this->materials[material].blended) // If blended
+            return (1ULL << 63) | ((0xFFFFFFULL - depth) << 39) | (program << 31) | (array << 23) | (mat << 11); // Back to front
+        return (program << 55) | (array << 47) | (mat << 35) | (depth << 11); // Grouped by state, front to back
+    }
+
+    // Quantizes a depth to 24 bits. A positive float's bit pattern sorts like its value, so its top bits are
+    // used directly and no near/far range is needed.
+    static unsigned long long depthBits(float viewDepth) {
+        if (!(viewDepth > 0.0f)) // If behind the camera or NaN
+            return 0; // Sort first
+        GLuint bits; // Float bit pattern
+        memcpy(&bits, &viewDepth, sizeof(bits)); // Reinterpret
+        return (bits >> 7) & 0xFFFFFF; // Exponent and top mantissa bits
+    }
+
+    // LSD radix sort of the keys, one byte per pass, carrying packet indices along
+    void sort() {
+        size_t n = this->keys.size(); // Packet count
+        this->order.resize(n); // One index per packet
+        for (size_t i = 0; i < n; i++) // Iterate over packets
+            this->order[i] = (GLuint)i; // Submission order
+        if (n < 2) // If nothing to sort
+            return;
+        this->scratchKeys.resize(n); // Size scratch keys
+        this->scratchOrder.resize(n); // Size scratch indices
+        for (int shift = 0; shift < 64; shift += 8) { // Iterate over bytes
+            size_t counts[256] = { 0 }; // Histogram
+            for (size_t i = 0; i < n; i++) // Iterate over keys
+                counts[(this->keys[i] >> shift) & 0xFF]++; // Count byte
+            if (counts[(this->keys[0] >> shift) & 0xFF] == n) // If every key shares this byte
+                continue; // Pass would not move anything
+            size_t offset = 0; // Running total
+            for (int b = 0; b < 256; b++) { // Iterate over buckets
+                size_t count = counts[b]; // Bucket size
+                counts[b] = offset; // Bucket start
+                offset += count; // Advance
+            }
+            for (size_t i = 0; i < n; i++) { // Scatter in stable order
+                size_t dst = counts[(this->keys[i] >> shift) & 0xFF]++; // Destination
+                this->scratchKeys[dst] = this->keys[i]; // Move key
+                this->scratchOrder[dst] = this->order[i]; // Move index
+            }
+            this->keys.swap(this->scratchKeys); // Sorted keys become current
+            this->order.swap(this->scratchOrder); // Sorted indices become current
+        }
+    }
+};
@@ -0,0 +1,144 @@
+// Ring Buffer
+
+#pragma once
+
+#include <iostream> // Include iostream
+#include <vector> // Include vector
+
+#include <GL/glew.h> // Include glew
+
+#include "GLState.h" // Include GL state cache
+
+// Triple-buffered, persistently mapped buffer for data written every frame (uniform blocks, per-object
+// constants, dynamic vertices). Each frame bump-allocates from its own third of the buffer and the CPU
+// writes straight into mapped memory, so there is no glBufferData orphaning or glBufferSubData copy.
+// A fence placed at the end of each frame keeps the CPU from overwriting a third the GPU is still reading.
+// Without GL_ARB_buffer_storage, writes go to a CPU copy that is uploaded when a range is bound.
+class RingBuffer {
+public:
+    static const int FRAMES = 3; // Frames in flight
+
+    // Constructor. frameSize is the most bytes one frame can allocate.
+    RingBuffer(GLsizeiptr frameSize) : frame(0), head(0), mapped(NULL), stalls(0) {
+        GLint uniformAlign = 0, storageAlign = 0; // Offset alignment for each target
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniformAlign); // Uniform buffer alignment
+        glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &storageAlign); // Storage buffer alignment
+        this->alignment = uniformAlign > storageAlign ? uniformAlign : storageAlign; // Satisfy both
+        if (this->alignment < 16) // If unreported
+            this->alignment = 16; // Vec4 alignment
+        this->frameSize = this->align(frameSize); // Keep every frame's start aligned
+        GLsizeiptr total = this->frameSize * FRAMES; // Whole buffer
+
+        GLStateCache& state = GLStateCache::Get(); // State cache
+        glGenBuffers(1, &this->buffer); // Create buffer
+        state.BindBuffer(GL_COPY_WRITE_BUFFER, this->buffer); // Bind for allocation
+        this->persistent = false; // Until mapped
+        if (GLEW_ARB_buffer_storage) { // If persistent mapping available
+            GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT; // Mapped for the buffer's lifetime
+            glBufferStorage(GL_COPY_WRITE_BUFFER, total, NULL, flags); // Immutable storage
+            this->mapped = (char*)glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, total, flags); // Map once
+            this->persistent = this->mapped != NULL; // Mapped
+            if (!this->persistent) { // If mapping failed
+                std::cout << "ERROR::RING_BUFFER::MAP_FAILED" << std::endl; // Error message
+                glDeleteBuffers(1, &this->buffer); // Immutable storage cannot be respecified
+                glGenBuffers(1, &this->buffer); // Create a mutable buffer instead
+                state.Invalidate(); // Deleted buffer was bound
+                state.BindBuffer(GL_COPY_WRITE_BUFFER, this->buffer); // Bind for allocation
+            }
+        }
+        if (!this->persistent) { // If falling back
+            glBufferData(GL_COPY_WRITE_BUFFER, total, NULL, GL_STREAM_DRAW); // Mutable storage
+            this->shadow.resize(total); // CPU copy
+            this->mapped = &this->shadow[0]; // Write into the copy
+        }
+        for (int i = 0; i < FRAMES; i++) // Iterate over frames
+            this->fences[i] = 0; // Nothing in flight
+    }
+
+    // Moves to the next third of the buffer, waiting if the GPU has not finished with it
+    void BeginFrame() {
+        this->frame = (this->frame + 1) % FRAMES; // Next frame
+        GLsync fence = this->fences[this->frame]; // Fence from FRAMES frames ago
+        if (fence) { // If that frame was submitted
+            GLenum result = glClientWaitSync(fence, 0, 0); // Poll
+            if (result == GL_TIMEOUT_EXPIRED) { // If still in use
+                this->stalls++; // Count stall
+                do {
+                    result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000); // Wait up to 1 ms at a time
+                } while (result == GL_TIMEOUT_EXPIRED); // Until signaled
+            }
+            glDeleteSync(fence); // Done with fence
+            this->fences[this->frame] = 0; // Clear fence
+        }
+        this->head = this->frame * this->frameSize; // Start of this frame's region
+    }
+
+    // Reserves size bytes in this frame's region. Returns the write pointer and the buffer offset to bind,
+    // or NULL when the frame has run out of space.
+    void* Allocate(GLsizeiptr size, GLintptr& offset) {
+        GLintptr start = this->align(this->head); // Aligned start
+        if (start + size > (this->frame + 1) * this->frameSize) { // If past the end of this frame's region
+            std::cout << "ERROR::RING_BUFFER::OUT_OF_SPACE " << size << " bytes" << std::endl; // Error message
+            return NULL;
+        }
+        this->head = start + size; // Bump
+        offset = start; // Buffer offset
+        return this->mapped + start; // Write pointer
+    }
+
+    // Binds an allocation to an indexed uniform or storage buffer binding point
+    void BindRange(GLenum target, GLuint index, GLintptr offset, GLsizeiptr size) {
+        if (!this->persistent) { // If writes went to the CPU copy
+            GLStateCache::Get().BindBuffer(GL_COPY_WRITE_BUFFER, this->buffer); // Bind buffer
+            glBufferSubData(GL_COPY_WRITE_BUFFER, offset, size, this->mapped + offset); // Upload range
+        }
+        glBindBufferRange(target, index, this->buffer, offset, size); // Bind range
+    }
+
+    // Makes bytes rewritten after BindRange visible to commands issued from now on. A coherent persistent
+    // mapping already is; the fallback uploads the range from the CPU copy again.
+    void Flush(GLintptr offset, GLsizeiptr size) {
+        if (this->persistent) // If writes land in the buffer directly
+            return;
+        GLStateCache::Get().BindBuffer(GL_COPY_WRITE_BUFFER, this->buffer); // Bind buffer
+        glBufferSubData(GL_COPY_WRITE_BUFFER, offset, size, this->mapped + offset); // Upload range
+    }
+
+    // Copies bytes back from the buffer as the GPU reads them. Stalls until earlier commands finish; for checks only.
+    void ReadBack(GLintptr offset, GLsizeiptr size, void* data) {
+        GLStateCache::Get().BindBuffer(GL_COPY_READ_BUFFER, this->buffer); // Bind buffer
+        glGetBufferSubData(GL_COPY_READ_BUFFER, offset, size, data); // Read range
+    }
+
+    // Fences this frame's region once its draws have been submitted
+    void EndFrame() {
+        this->fences[this->frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0); // Signals when the GPU is done
+    }
+
+    // Buffer name, for binding as a vertex or index buffer
+    GLuint Buffer() const {
+        return this->buffer; // Return buffer
+    }
+
+    // Frames that had to wait for the GPU
+    unsigned int Stalls() const {
+        return this->stalls; // Return stall count
+    }
+
+private:
+    GLuint buffer; // Buffer object
+    GLsizeiptr frameSize; // Bytes per frame region
+    GLint alignment; // Allocation alignment
+    int frame; // Current frame region
+    GLintptr head; // Next free byte
+    char* mapped; // Persistent mapping or CPU copy
+    bool persistent; // Persistent mapping in use
+    std::vector<char> shadow; // CPU copy for the fallback
+    GLsync fences[FRAMES]; // Fence per frame region
+    unsigned int stalls; // Frames that waited on a fence
+
+    // Rounds up to the allocation alignment
+    GLintptr align(GLintptr value) const {
+        return (value + this->alignment - 1) / this->alignment * this->alignment; // Round up
+    }
+};
@@ -0,0 +1,36 @@
+// Scene Components
+
+#pragma once
+
+#include <GL/glew.h> // Include glew
+#include <glm/glm.hpp> // Include glm
+
+// Components of Project 9's scene entities. Each is a plain struct stored in EntityWorld columns.
+
+// Where an entity sits: its scene graph node and the object constants entry its world matrix is copied to
+struct Transform {
+    GLuint node; // SceneGraph node
+    GLuint object; // ObjectConstantsStage index
+};
+
+// What an entity draws: a run of entries in the scene's geometry table, one per mesh
+struct MeshHandle {
+    GLuint first; // First geometry
+    GLuint count; // Geometries, one per mesh
+};
+
+// How an entity is shaded: a RenderQueue material id
+struct MaterialHandle {
+    GLuint material; // RenderQueue material
+};
+
+// Object-space bounding box
+struct Bounds {
+    glm::vec3 min; // Minimum corner
+    glm::vec3 max; // Maximum corner
+};
+
+// Constant motion applied by the movement system every simulation tick
+struct Velocity {
+    glm::vec3 linear; // Units per second
+};
@@ -0,0 +1,234 @@
+// Scene File
+
+#pragma once
+
+#include <cstdint> // Include fixed-width integers
+#include <cstring> // Include cstring for memcmp
+#include <iostream> // Include iostream
+
+#ifdef _WIN32
+#include <windows.h> // Include file mapping
+#else
+#include <fcntl.h> // Include open
+#include <sys/mman.h> // Include mmap
+#include <sys/stat.h> // Include fstat
+#include <unistd.h> // Include close
+#endif
+
+// Binary scene format, written by scenec from a text .scene source and read in place through a memory map.
+// Every record is a fixed-size array of 4-byte fields at a 4-byte aligned offset, so the loader casts pointers
+// into the mapping instead of parsing anything; names are offsets into a table of NUL-terminated strings.
+// Fields are little-endian. Bump SCENE_FILE_VERSION whenever a record changes.
+//
+//   SceneFileHeader
+//   SceneFileMesh[meshCount]         at meshOffset
+//   SceneFileMaterial[materialCount] at materialOffset
+//   SceneFileObject[objectCount]     at objectOffset, parents before children
+//   char strings[stringsSize]        at stringsOffset
+
+const char SCENE_FILE_MAGIC[4] = { 'P', '9', 'S', 'C' }; // First bytes of every scene file
+const uint32_t SCENE_FILE_VERSION = 3; // Current format version
+const uint32_t SCENE_FILE_NONE = 0xFFFFFFFFu; // No parent, no mesh
+
+// Start of the file
+struct SceneFileHeader {
+    char magic[4]; // SCENE_FILE_MAGIC
+    uint32_t version; // SCENE_FILE_VERSION
+    uint32_t fileSize; // Bytes in the file
+    float lightPos[3]; // Light position
+    uint32_t meshCount, meshOffset; // Mesh table
+    uint32_t materialCount, materialOffset; // Material table
+    uint32_t objectCount, objectOffset; // Object table
+    uint32_t stringsSize, stringsOffset; // String table
+};
+static_assert(sizeof(SceneFileHeader) == 56, "SceneFileHeader must have no padding"); // Check layout
+
+// A mesh source: "cube" for the built-in unit cube, otherwise a model file path
+struct SceneFileMesh {
+    uint32_t path; // String offset
+};
+
+// A material: shader family and color
+struct SceneFileMaterial {
+    uint32_t name; // String offset, used for profiling zones
+    uint32_t shader; // String offset: checkerboard, cube, sphere or cylinder
+    float color[3]; // Color
+    uint32_t blended; // Nonzero for blended materials
+};
+static_assert(sizeof(SceneFileMaterial) == 24, "SceneFileMaterial must have no padding"); // Check layout
+
+// A scene graph node, drawn when it has a mesh
+struct SceneFileObject {
+    uint32_t parent; // Earlier object index, SCENE_FILE_NONE for a root
+    uint32_t mesh; // Mesh index, SCENE_FILE_NONE for a group node
+    uint32_t material; // Material index, ignored for group nodes
+    float position[3]; // Local position
+    float rotation[4]; // Local rotation quaternion x, y, z, w
+    float scale[3]; // Local scale
+    float velocity[3]; // Constant motion in units per second, zero for a static object
+};
+static_assert(sizeof(SceneFileObject) == 64, "SceneFileObject must have no padding"); // Check layout
+
+// Read-only view of a mapped scene file. Only the header and table bounds are checked on open, so opening costs
+// the same for any scene size; records are touched, and paged in, as the caller reads them.
+class SceneFile {
+public:
+    // Constructor
+    SceneFile() : data(NULL), size(0) {
+#ifdef _WIN32
+        this->file = INVALID_HANDLE_VALUE; // No file
+        this->mapping = NULL; // No mapping
+#endif
+    }
+
+    // Destructor
+    ~SceneFile() {
+        this->Close(); // Unmap
+    }
+
+    // Maps a scene file and checks its header. Prints an error and returns false on failure.
+    bool Open(const char* path) {
+        this->Close(); // Drop any previous file
+        if (!this->map(path)) { // If the file cannot be mapped
+            std::cout << "ERROR::SCENE::FILE_NOT_READ " << path << std::endl; // Print error
+            return false;
+        }
+        if (this->size < sizeof(SceneFileHeader) || memcmp(this->data, SCENE_FILE_MAGIC, 4) != 0) { // If not a scene file
+            std::cout << "ERROR::SCENE::NOT_A_SCENE_FILE " << path << std::endl; // Print error
+            this->Close();
+            return false;
+        }
+        const SceneFileHeader& header = this->Header(); // Header, known to fit
+        if (header.version != SCENE_FILE_VERSION) { // If written by another scenec
+            std::cout << "ERROR::SCENE::VERSION " << header.version << " (expected " << SCENE_FILE_VERSION << ") " << path << std::endl; // Print error
+            this->Close();
+            return false;
+        }
+        if (header.fileSize != this->size ||
+            !this->fits(header.meshOffset, header.meshCount, sizeof(SceneFileMesh)) ||
+            !this->fits(header.materialOffset, header.materialCount, sizeof(SceneFileMaterial)) ||
+            !this->fits(header.objectOffset, header.objectCount, sizeof(SceneFileObject)) ||
+            !this->fits(header.stringsOffset, header.stringsSize, 1) ||
+            header.stringsSize == 0 || this->data[header.stringsOffset + header.stringsSize - 1] != '\0') { // If a table runs off the end
+            std::cout << "ERROR::SCENE::TRUNCATED " << path << std::endl; // Print error
+            this->Close();
+            return false;
+        }
+        return true;
+    }
+
+    // Unmaps the file
+    void Close() {
+        if (!this->data) // If nothing mapped
+            return;
+#ifdef _WIN32
+        UnmapViewOfFile(this->data); // Unmap view
+        CloseHandle(this->mapping); // Close mapping
+        CloseHandle(this->file); // Close file
+        this->file = INVALID_HANDLE_VALUE; // No file
+        this->mapping = NULL; // No mapping
+#else
+        munmap((void*)this->data, this->size); // Unmap
+#endif
+        this->data = NULL; // Nothing mapped
+        this->size = 0; // No bytes
+    }
+
+    // Mapped bytes of the whole file, NULL when closed
+    const char* Data() const {
+        return this->data; // Return mapping
+    }
+
+    // Length of the mapped file
+    size_t Size() const {
+        return this->size; // Return length
+    }
+
+    // File header
+    const SceneFileHeader& Header() const {
+        return *(const SceneFileHeader*)this->data; // Header at offset 0
+    }
+
+    // Mesh table
+    const SceneFileMesh* Meshes() const {
+        return (const SceneFileMesh*)(this->data + this->Header().meshOffset); // Table in place
+    }
+
+    // Material table
+    const SceneFileMaterial* Materials() const {
+        return (const SceneFileMaterial*)(this->data + this->Header().materialOffset); // Table in place
+    }
+
+    // Object table
+    const SceneFileObject* Objects() const {
+        return (const SceneFileObject*)(this->data + this->Header().objectOffset); // Table in place
+    }
+
+    // String at an offset in the string table, "" if out of range. Valid until Close.
+    const char* String(uint32_t offset) const {
+        if (offset >= this->Header().stringsSize) // If out of range
+            return ""; // Empty string
+        return this->data + this->Header().stringsOffset + offset; // String in place, table ends with NUL
+    }
+
+private:
+    const char* data; // Mapped bytes
+    size_t size; // Mapped length
+#ifdef _WIN32
+    HANDLE file; // File handle
+    HANDLE mapping; // Mapping handle
+#endif
+
+    // True when count records of recordSize bytes at offset lie inside the file, 4-byte aligned
+    bool fits(uint32_t offset, uint32_t count, size_t recordSize) const {
+        return offset % 4 == 0 && offset <= this->size && (uint64_t)count * recordSize <= this->size - offset; // In bounds
+    }
+
+    // Maps a whole file read-only
+    bool map(const char* path) {
+#ifdef _WIN32
+        this->file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL); // Open file
+        if (this->file == INVALID_HANDLE_VALUE) // If missing
+            return false;
+        LARGE_INTEGER length; // File size
+        if (!GetFileSizeEx(this->file, &length) || length.QuadPart == 0) { // If unreadable or empty
+            CloseHandle(this->file);
+            this->file = INVALID_HANDLE_VALUE;
+            return false;
+        }
+        this->mapping = CreateFileMappingA(this->file, NULL, PAGE_READONLY, 0, 0, NULL); // Create mapping
+        if (!this->mapping) { // If mapping failed
+            CloseHandle(this->file);
+            this->file = INVALID_HANDLE_VALUE;
+            return false;
+        }
+        this->data = (const char*)MapViewOfFile(this->mapping, FILE_MAP_READ, 0, 0, 0); // Map whole file
+        this->size = (size_t)length.QuadPart; // Mapped length
+        if (!this->data) { // If the view failed
+            CloseHandle(this->mapping);
+            CloseHandle(this->file);
+            this->mapping = NULL;
+            this->file = INVALID_HANDLE_VALUE;
+            this->size = 0;
+            return false;
+        }
+        return true;
+#else
+        int fd = open(path, O_RDONLY); // Open file
+        if (fd < 0) // If missing
+            return false;
+        struct stat info; // File status
+        if (fstat(fd, &info) != 0 || info.st_size == 0) { // If unreadable or empty
+            close(fd);
+            return false;
+        }
+        void* mapped = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0); // Map whole file
+        close(fd); // The mapping keeps the file open
+        if (mapped == MAP_FAILED) // If mapping failed
+            return false;
+        this->data = (const char*)mapped; // Mapped bytes
+        this->size = (size_t)info.st_size; // Mapped length
+        return true;
+#endif
+    }
+};
@@ -0,0 +1,216 @@
+// Scene Graph
+
+#pragma once
+
+#include <algorithm> // Include algorithm for min and sort
+#include <functional> // Include functional for cref
+#include <thread> // Include thread
+#include <vector> // Include vector
+
+#include <GL/glew.h> // Include glew
+#include <glm/glm.hpp> // Include glm
+#include <glm/gtc/quaternion.hpp> // Include glm quaternions
+
+#include "ObjectConstants.h" // Include Lane4 helpers
+
+// Transform hierarchy stored as structure of arrays. Every local transform component and every world matrix
+// element lives in its own array indexed by node, so an update streams through memory four nodes per SSE pass.
+// A parent is always created before its children, so node order is already a topological order.
+//
+// Changing a local transform only marks the node dirty. Update() then recomputes the world matrices of the dirty
+// nodes and their descendants, one depth level at a time because nodes on the same level never depend on each
+// other; large levels are split across threads. Nodes that never change cost nothing after the first update.
+class SceneGraph {
+public:
+    // Node index meaning "no node"
+    enum : GLuint { NONE = 0xFFFFFFFFu };
+
+    // Constructor
+    SceneGraph() {}
+
+    // Adds a node under parent (NONE for a root) with a local transform and returns its index. objectIndex links
+    // it to an ObjectConstantsStage entry, NONE for grouping nodes that are never drawn.
+    GLuint Add(GLuint parent, const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale, GLuint objectIndex = NONE) {
+        GLuint node = (GLuint)this->parents.size(); // Next index
+        this->parents.push_back(parent); // Parent
+        this->depths.push_back(parent == NONE ? 0 : this->depths[parent] + 1); // One below the parent
+        this->firstChildren.push_back(NONE); // No children yet
+        this->nextSiblings.push_back(parent == NONE ? NONE : this->firstChildren[parent]); // Prepend to parent's children
+        if (parent != NONE) // If not a root
+            this->firstChildren[parent] = node; // Node is the parent's first child now
+        this->objects.push_back(objectIndex); // Linked object
+        for (int c = 0; c < 3; c++) this->position[c].push_back(position[c]); // Position components
+        this->rotation[0].push_back(rotation.x); // Rotation x
+        this->rotation[1].push_back(rotation.y); // Rotation y
+        this->rotation[2].push_back(rotation.z); // Rotation z
+        this->rotation[3].push_back(rotation.w); // Rotation w
+        for (int c = 0; c < 3; c++) this->scale[c].push_back(scale[c]); // Scale components
+        for (int e = 0; e < 16; e++) this->world[e].push_back((e % 5 == 0) ? 1.0f : 0.0f); // Identity until updated
+        this->queued.push_back(0); // Not queued
+        this->dirty.push_back(node); // World matrix needs computing
+        return node; // Return index
+    }
+
+    // Replaces a node's local transform and marks it dirty
+    void SetLocal(GLuint node, const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale) {
+        for (int c = 0; c < 3; c++) this->position[c][node] = position[c]; // Position components
+        this->rotation[0][node] = rotation.x; // Rotation x
+        this->rotation[1][node] = rotation.y; // Rotation y
+        this->rotation[2][node] = rotation.z; // Rotation z
+        this->rotation[3][node] = rotation.w; // Rotation w
+        for (int c = 0; c < 3; c++) this->scale[c][node] = scale[c]; // Scale components
+        this->dirty.push_back(node); // Recompute on next update
+    }
+
+    // Replaces a node's local position only and marks it dirty
+    void SetPosition(GLuint node, const glm::vec3& position) {
+        for (int c = 0; c < 3; c++) this->position[c][node] = position[c]; // Position components
+        this->dirty.push_back(node); // Recompute on next update
+    }
+
+    // Local position of a node
+    glm::vec3 Position(GLuint node) const {
+        return glm::vec3(this->position[0][node], this->position[1][node], this->position[2][node]); // Gather components
+    }
+
+    // Number of nodes
+    GLuint Count() const {
+        return (GLuint)this->parents.size(); // Return count
+    }
+
+    // Object linked to a node, NONE if none
+    GLuint Object(GLuint node) const {
+        return this->objects[node]; // Return object index
+    }
+
+    // World matrix computed by the last Update()
+    glm::mat4 World(GLuint node) const {
+        glm::mat4 m; // Gathered matrix
+        for (int e = 0; e < 16; e++) // Iterate over elements
+            m[e / 4][e % 4] = this->world[e][node]; // Element e of this node
+        return m; // Return matrix
+    }
+
+    // Recomputes the world matrices of every dirty node and its descendants. Returns the nodes that changed, in
+    // topological order; the list is empty, and the call nearly free, when nothing was touched.
+    const std::vector<GLuint>& Update() {
+        this->updated.clear(); // Nothing changed yet
+        if (this->dirty.empty()) // If nothing touched
+            return this->updated;
+
+        // Collect the dirty nodes and everything below them, each once
+        std::vector<GLuint> stack(this->dirty.begin(), this->dirty.end()); // Nodes to visit
+        this->dirty.clear(); // Handled below
+        while (!stack.empty()) { // Until every descendant is visited
+            GLuint node = stack.back(); // Next node
+            stack.pop_back();
+            if (this->queued[node]) // If already collected
+                continue;
+            this->queued[node] = 1; // Collect once
+            this->updated.push_back(node); // Changes this update
+            for (GLuint child = this->firstChildren[node]; child != NONE; child = this->nextSiblings[child]) // Iterate over children
+                stack.push_back(child); // Inherits the change
+        }
+
+        // Bucket by depth so each level only reads finished parents
+        GLuint maxDepth = 0; // Deepest changed level
+        for (size_t n = 0; n < this->updated.size(); n++) // Iterate over changed nodes
+            maxDepth = std::max(maxDepth, this->depths[this->updated[n]]); // Track deepest
+        this->levels.resize(maxDepth + 1); // One bucket per level
+        for (size_t d = 0; d < this->levels.size(); d++) // Iterate over levels
+            this->levels[d].clear(); // Empty bucket
+        for (size_t n = 0; n < this->updated.size(); n++) { // Iterate over changed nodes
+            GLuint node = this->updated[n]; // Node
+            this->levels[this->depths[node]].push_back(node); // File under its depth
+            this->queued[node] = 0; // Ready for the next update
+        }
+
+        // Sweep the levels top down, each level split into independent chunks
+        for (size_t d = 0; d < this->levels.size(); d++) { // Iterate over levels
+            const std::vector<GLuint>& level = this->levels[d]; // Nodes on this level
+            size_t workers = std::min(level.size() / PARALLEL_CHUNK, (size_t)std::max(1u, std::thread::hardware_concurrency())); // Threads worth starting
+            if (workers <= 1) { // If small
+                this->updateRange(level, 0, level.size()); // Update on this thread
+                continue;
+            }
+            size_t chunk = ((level.size() + workers - 1) / workers + 3) & ~(size_t)3; // Nodes per worker, whole SSE passes
+            std::vector<std::thread> threads; // Helpers
+            for (size_t w = 1; w < workers; w++) // Iterate over helper chunks
+                if (w * chunk < level.size()) // If the chunk has nodes
+                    threads.push_back(std::thread(&SceneGraph::updateRange, this, std::cref(level), w * chunk, std::min(level.size(), (w + 1) * chunk))); // Update chunk
+            this->updateRange(level, 0, std::min(level.size(), chunk)); // First chunk on this thread
+            for (size_t t = 0; t < threads.size(); t++) // Iterate over helpers
+                threads[t].join(); // Wait for chunk
+        }
+        std::sort(this->updated.begin(), this->updated.end()); // Report in node order
+        return this->updated; // Return changed nodes
+    }
+
+private:
+    static const size_t PARALLEL_CHUNK = 16384; // Smallest level share worth a thread
+
+    std::vector<GLuint> parents; // Parent per node, NONE for roots
+    std::vector<GLuint> depths; // Distance from the root per node
+    std::vector<GLuint> firstChildren; // First child per node
+    std::vector<GLuint> nextSiblings; // Next child of the same parent per node
+    std::vector<GLuint> objects; // Linked object per node
+    std::vector<float> position[3]; // Local position, one array per component
+    std::vector<float> rotation[4]; // Local rotation quaternion x, y, z, w
+    std::vector<float> scale[3]; // Local scale, one array per component
+    std::vector<float> world[16]; // World matrix, one array per column-major element
+    std::vector<unsigned char> queued; // Collected by the current update
+
+    std::vector<GLuint> dirty; // Nodes touched since the last update, may repeat
+    std::vector<GLuint> updated; // Nodes changed by the last update
+    std::vector<std::vector<GLuint> > levels; // Changed nodes by depth
+
+    // Computes world = parent world * translate * rotate * scale for level[begin, end), four nodes per pass
+    void updateRange(const std::vector<GLuint>& level, size_t begin, size_t end) {
+        for (size_t base = begin; base < end; base += 4) { // Four nodes per pass
+            size_t batch = std::min((size_t)4, end - base); // Nodes in this pass
+            float in[26][4]; // Gathered inputs: 10 local components and 16 parent elements per lane
+            for (size_t o = 0; o < 4; o++) { // Iterate over lanes
+                GLuint node = level[base + std::min(o, batch - 1)]; // Node, unused lanes repeat the last one
+                GLuint parent = this->parents[node]; // Parent
+                for (int c = 0; c < 3; c++) in[c][o] = this->position[c][node]; // Position
+                for (int c = 0; c < 4; c++) in[3 + c][o] = this->rotation[c][node]; // Rotation
+                for (int c = 0; c < 3; c++) in[7 + c][o] = this->scale[c][node]; // Scale
+                for (int e = 0; e < 16; e++) // Iterate over parent elements
+                    in[10 + e][o] = (parent == NONE) ? ((e % 5 == 0) ? 1.0f : 0.0f) : this->world[e][parent]; // Parent world or identity
+            }
+
+            // Local matrix from the quaternion, scaled per column, translation in the last column
+            Lane4 x = laneLoad(in[3]), y = laneLoad(in[4]), z = laneLoad(in[5]), w = laneLoad(in[6]); // Rotation
+            Lane4 two = laneSet(2.0f), one = laneSet(1.0f); // Constants
+            Lane4 xx = laneMul(x, x), yy = laneMul(y, y), zz = laneMul(z, z); // Squares
+            Lane4 xy = laneMul(x, y), xz = laneMul(x, z), yz = laneMul(y, z); // Products
+            Lane4 wx = laneMul(w, x), wy = laneMul(w, y), wz = laneMul(w, z); // Products with w
+            Lane4 sx = laneLoad(in[7]), sy = laneLoad(in[8]), sz = laneLoad(in[9]); // Scale
+            Lane4 local[16]; // Local elements, column-major
+            local[0] = laneMul(laneSub(one, laneMul(two, laneAdd(yy, zz))), sx); // Column 0
+            local[1] = laneMul(laneMul(two, laneAdd(xy, wz)), sx);
+            local[2] = laneMul(laneMul(two, laneSub(xz, wy)), sx);
+            local[4] = laneMul(laneMul(two, laneSub(xy, wz)), sy); // Column 1
+            local[5] = laneMul(laneSub(one, laneMul(two, laneAdd(xx, zz))), sy);
+            local[6] = laneMul(laneMul(two, laneAdd(yz, wx)), sy);
+            local[8] = laneMul(laneMul(two, laneAdd(xz, wy)), sz); // Column 2
+            local[9] = laneMul(laneMul(two, laneSub(yz, wx)), sz);
+            local[10] = laneMul(laneSub(one, laneMul(two, laneAdd(xx, yy))), sz);
+            local[12] = laneLoad(in[0]); local[13] = laneLoad(in[1]); local[14] = laneLoad(in[2]); // Column 3
+            local[3] = local[7] = local[11] = laneSet(0.0f); local[15] = one; // Bottom row
+
+            // World: out[col][row] = sum over k of parent[k][row] * local[col][k]
+            float lanes[4]; // Scratch for one element of four nodes
+            for (int col = 0; col < 4; col++) { // Iterate over columns
+                for (int row = 0; row < 4; row++) { // Iterate over rows
+                    Lane4 sum = laneMul(laneLoad(in[10 + row]), local[col * 4]); // k = 0
+                    for (int k = 1; k < 4; k++) // Remaining terms
+                        sum = laneAdd(sum, laneMul(laneLoad(in[10 + k * 4 + row]), local[col * 4 + k])); // Accumulate
+                    laneStore(lanes, sum); // World element of four nodes
+                    for (size_t o = 0; o < batch; o++) // Iterate over real lanes
+                        this->world[col * 4 + row][level[base + o]] = lanes[o]; // Scatter
+                }
+            }
+        }
+    }
+};
@@ -0,0 +1,53 @@
+// Triple Buffer
+
+#pragma once
+
+#include <atomic> // Include atomic
+
+// Hands the newest value from one writer thread to one reader thread without locks or waiting. There are three
+// slots: the writer fills its back slot and swaps it with the shared middle slot, the reader swaps the middle slot
+// with its front slot when a newer value is there. Neither side ever blocks the other; a fast writer overwrites
+// values the reader never saw and a fast reader keeps reading the last one.
+template <typename T>
+class TripleBuffer {
+public:
+    // Constructor. Every slot starts as a copy of initial, so the reader has something to read straight away.
+    TripleBuffer(const T& initial) : middle(1), back(0), front(2) {
+        for (int i = 0; i < 3; i++) // Iterate over slots
+            this->slots[i] = initial; // Copy initial value
+    }
+
+    // Writer: slot to fill with the next value. Only the writer touches it until Publish.
+    T& Back() {
+        return this->slots[this->back]; // Return back slot
+    }
+
+    // Writer: makes the back slot the newest value and takes the old middle slot as the next back slot
+    void Publish() {
+        unsigned previous = this->middle.exchange(this->back | FRESH, std::memory_order_acq_rel); // Swap back into middle, marked new
+        this->back = previous & INDEX; // Reuse whatever was in the middle
+    }
+
+    // Reader: moves to the newest value if one was published since the last call. Returns true if it did.
+    bool Acquire() {
+        if (!(this->middle.load(std::memory_order_relaxed) & FRESH)) // If nothing new
+            return false; // Keep front slot
+        unsigned previous = this->middle.exchange(this->front, std::memory_order_acq_rel); // Swap front into middle, marked old
+        this->front = previous & INDEX; // Newest value becomes front
+        return true;
+    }
+
+    // Reader: value taken by the last Acquire. Only the reader touches it until the next Acquire.
+    const T& Front() const {
+        return this->slots[this->front]; // Return front slot
+    }
+
+private:
+    static const unsigned INDEX = 3; // Slot index bits of middle
+    static const unsigned FRESH = 4; // Middle holds a value the reader has not taken
+
+    T slots[3]; // Values
+    std::atomic<unsigned> middle; // Shared slot index plus FRESH flag
+    unsigned back; // Writer's slot
+    unsigned front; // Reader's slot
+};
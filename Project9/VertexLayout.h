@@ -0,0 +1,211 @@
+// Vertex Layout Descriptors
+
+#pragma once
+
+#include <cstddef> // Include cstddef for offsetof
+#include <cstring> // Include cstring for memcpy
+#include <iostream> // Include iostream
+#include <type_traits> // Include type_traits
+#include <vector> // Include vector
+
+#include <GL/glew.h> // Include glew
+#include <glm/glm.hpp> // Include glm
+
+#include "GLState.h" // Include GL state cache
+
+// GL format for a vertex member type. Only the types specialized here can appear in a layout, so an
+// unsupported member is a compile error rather than a silently wrong glVertexAttribPointer.
+template <typename T> struct AttribFormat;
+template <> struct AttribFormat<GLfloat> { enum { size = 1, type = GL_FLOAT, normalized = GL_FALSE, integer = 0 }; };
+template <> struct AttribFormat<glm::vec2> { enum { size = 2, type = GL_FLOAT, normalized = GL_FALSE, integer = 0 }; };
+template <> struct AttribFormat<glm::vec3> { enum { size = 3, type = GL_FLOAT, normalized = GL_FALSE, integer = 0 }; };
+template <> struct AttribFormat<glm::vec4> { enum { size = 4, type = GL_FLOAT, normalized = GL_FALSE, integer = 0 }; };
+template <> struct AttribFormat<GLint> { enum { size = 1, type = GL_INT, normalized = GL_FALSE, integer = 1 }; };
+template <> struct AttribFormat<GLuint> { enum { size = 1, type = GL_UNSIGNED_INT, normalized = GL_FALSE, integer = 1 }; };
+
+// One attribute of a vertex struct
+struct VertexAttrib {
+    GLuint location; // Shader input location
+    GLint size; // Component count
+    GLenum type; // Component type
+    GLboolean normalized; // Normalize fixed-point data
+    bool integer; // Integer input (glVertexAttribIFormat)
+    GLuint offset; // Byte offset inside the vertex
+    const char* name; // Member name, for diagnostics
+};
+
+// Builds a VertexAttrib from a struct member. Format and offset come from the member's declared type.
+#define VERTEX_ATTRIB(VertexType, member, loc) \
+    VertexAttrib { loc, AttribFormat<decltype(VertexType::member)>::size, AttribFormat<decltype(VertexType::member)>::type, \
+                   (GLboolean)AttribFormat<decltype(VertexType::member)>::normalized, AttribFormat<decltype(VertexType::member)>::integer != 0, \
+                   (GLuint)offsetof(VertexType, member), #member }
+
+// Layout of a vertex struct. Specialize with VERTEX_LAYOUT; using a struct without one is a compile error.
+template <typename V> struct VertexLayout;
+
+// Declares the layout of a vertex struct from a list of VERTEX_ATTRIB entries
+#define VERTEX_LAYOUT(VertexType, ...) \
+    template <> struct VertexLayout<VertexType> { \
+        static_assert(std::is_standard_layout<VertexType>::value, #VertexType " must be standard layout for offsetof"); \
+        static const std::vector<VertexAttrib>& Attribs() { \
+            static const std::vector<VertexAttrib> attribs = { __VA_ARGS__ }; /* Attributes in declaration order */ \
+            return attribs; \
+        } \
+        static GLsizei Stride() { return (GLsizei)sizeof(VertexType); } /* Stride is the struct size */ \
+        static const char* Name() { return #VertexType; } /* Name for diagnostics */ \
+    };
+
+// Vertex binding index every layout uses for its interleaved buffer
+const GLuint VERTEX_BUFFER_BINDING = 0;
+
+// Returns the VAO for a layout. It holds only the attribute formats, so every mesh with the same vertex
+// struct shares it and just binds its own buffers with BindVertexBuffers.
+template <typename V>
+GLuint SharedVertexArray() {
+    static GLuint vao = 0; // One VAO per layout
+    if (vao != 0) // If already created
+        return vao; // Share it
+    GLStateCache& state = GLStateCache::Get(); // State cache
+    glGenVertexArrays(1, &vao); // Create VAO
+    state.BindVertexArray(vao); // Bind VAO
+    const std::vector<VertexAttrib>& attribs = VertexLayout<V>::Attribs(); // Layout attributes
+    for (size_t i = 0; i < attribs.size(); i++) { // Iterate over attributes
+        const VertexAttrib& a = attribs[i]; // Attribute
+        if (a.integer) // If integer input
+            glVertexAttribIFormat(a.location, a.size, a.type, a.offset); // Integer format
+        else
+            glVertexAttribFormat(a.location, a.size, a.type, a.normalized, a.offset); // Float format
+        glVertexAttribBinding(a.location, VERTEX_BUFFER_BINDING); // Read from binding 0
+        glEnableVertexAttribArray(a.location); // Enable attribute
+    }
+    return vao; // Return VAO
+}
+
+// Binds the shared VAO for a layout along with a mesh's vertex and (optional) index buffer
+template <typename V>
+void BindVertexBuffers(GLuint vbo, GLuint ebo = 0) {
+    GLStateCache& state = GLStateCache::Get(); // State cache
+    state.BindVertexArray(SharedVertexArray<V>()); // Bind shared VAO
+    state.BindVertexBuffer(VERTEX_BUFFER_BINDING, vbo, 0, VertexLayout<V>::Stride()); // Bind vertex data
+    if (ebo != 0) // If indexed
+        state.BindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo); // Bind index data
+}
+
+// Everything needed to issue one draw of a mesh: its layout's VAO, its buffers and how many vertices to draw
+struct DrawGeometry {
+    GLuint vao; // Shared VAO for the vertex layout
+    GLuint vbo; // Vertex buffer
+    GLuint ebo; // Index buffer, 0 for non-indexed draws
+    GLsizei stride; // Bytes between vertices
+    GLsizei count; // Index count, or vertex count when not indexed
+    GLuint positions; // Tightly packed copy of the positions for depth-only passes, 0 if none
+    const char* zone; // Profiling zone its draws are timed in, inside the material's, NULL for none
+};
+
+// Describes a mesh whose vertices use layout V. positions is an optional buffer from MakePositionBuffer.
+template <typename V>
+DrawGeometry MakeDrawGeometry(GLuint vbo, GLuint ebo, GLsizei count, GLuint positions = 0) {
+    DrawGeometry geometry = { SharedVertexArray<V>(), vbo, ebo, VertexLayout<V>::Stride(), count, positions, NULL }; // Geometry
+    return geometry; // Return geometry
+}
+
+// Copies the location 0 attribute of count vertices into a new buffer of bare vec3 positions. Depth-only
+// passes read it instead of the interleaved vertices, so they fetch 12 bytes per vertex and no more.
+// Returns 0 if location 0 of the layout is not a float vec3.
+template <typename V>
+GLuint MakePositionBuffer(const V* vertices, size_t count) {
+    const std::vector<VertexAttrib>& attribs = VertexLayout<V>::Attribs(); // Layout attributes
+    const VertexAttrib* position = NULL; // Attribute at location 0
+    for (size_t a = 0; a < attribs.size(); a++) // Iterate over layout
+        if (attribs[a].location == 0) // If position
+            position = &attribs[a]; // Found it
+    if (!position || position->size != 3 || position->type != GL_FLOAT) { // If not a plain vec3
+        std::cout << "ERROR::VERTEX_LAYOUT::" << VertexLayout<V>::Name() << ": location 0 is not a vec3, no position stream" << std::endl; // Error message
+        return 0;
+    }
+    std::vector<glm::vec3> positions(count); // Packed positions
+    for (size_t i = 0; i < count; i++) // Iterate over vertices
+        memcpy(&positions[i], (const char*)&vertices[i] + position->offset, sizeof(glm::vec3)); // Copy position
+    GLuint buffer = 0; // Position buffer
+    glGenBuffers(1, &buffer); // Create buffer
+    GLStateCache::Get().BindBuffer(GL_ARRAY_BUFFER, buffer); // Bind buffer
+    glBufferData(GL_ARRAY_BUFFER, count * sizeof(glm::vec3), count ? &positions[0] : NULL, GL_STATIC_DRAW); // Upload
+    return buffer; // Return buffer
+}
+
+// Returns the VAO for position streams: one vec3 at location 0, shared by every mesh's position buffer
+inline GLuint PositionVertexArray() {
+    static GLuint vao = 0; // One VAO for all position streams
+    if (vao != 0) // If already created
+        return vao; // Share it
+    glGenVertexArrays(1, &vao); // Create VAO
+    GLStateCache::Get().BindVertexArray(vao); // Bind VAO
+    glVertexAttribFormat(0, 3, GL_FLOAT, GL_FALSE, 0); // Bare vec3
+    glVertexAttribBinding(0, VERTEX_BUFFER_BINDING); // Read from binding 0
+    glEnableVertexAttribArray(0); // Enable attribute
+    return vao; // Return VAO
+}
+
+// Binds the VAO and buffers of a DrawGeometry
+inline void BindDrawGeometry(const DrawGeometry& geometry) {
+    GLStateCache& state = GLStateCache::Get(); // State cache
+    state.BindVertexArray(geometry.vao); // Bind shared VAO
+    state.BindVertexBuffer(VERTEX_BUFFER_BINDING, geometry.vbo, 0, geometry.stride); // Bind vertex data
+    if (geometry.ebo != 0) // If indexed
+        state.BindBuffer(GL_ELEMENT_ARRAY_BUFFER, geometry.ebo); // Bind index data
+}
+
+// Binds a DrawGeometry for a depth-only pass: its position stream if it has one, its full vertices otherwise.
+// Either way location 0 receives the same positions, so both give the same depth.
+inline void BindDepthGeometry(const DrawGeometry& geometry) {
+    if (geometry.positions == 0) { // If no position stream
+        BindDrawGeometry(geometry); // Use the interleaved vertices
+        return;
+    }
+    GLStateCache& state = GLStateCache::Get(); // State cache
+    state.BindVertexArray(PositionVertexArray()); // Bind position VAO
+    state.BindVertexBuffer(VERTEX_BUFFER_BINDING, geometry.positions, 0, (GLsizei)sizeof(glm::vec3)); // Bind positions
+    if (geometry.ebo != 0) // If indexed
+        state.BindBuffer(GL_ELEMENT_ARRAY_BUFFER, geometry.ebo); // Bind index data
+}
+
+// Checks a linked program's vertex inputs against a layout. Every active input must be fed by an
+// attribute at the same location with the same component count and float/integer kind.
+template <typename V>
+bool ValidateVertexLayout(GLuint program, const char* programName) {
+    const std::vector<VertexAttrib>& attribs = VertexLayout<V>::Attribs(); // Layout attributes
+    GLint count = 0; // Active attribute count
+    glGetProgramiv(program, GL_ACTIVE_ATTRIBUTES, &count); // Query active inputs
+    bool valid = true; // Result
+    for (GLint i = 0; i < count; i++) { // Iterate over inputs
+        GLchar name[64]; // Input name
+        GLint arraySize; // Array size
+        GLenum type; // Input type
+        glGetActiveAttrib(program, i, sizeof(name), NULL, &arraySize, &type, name); // Reflect input
+        if (name[0] == 'g' && name[1] == 'l' && name[2] == '_') // If built-in
+            continue; // Nothing to feed
+        GLint location = glGetAttribLocation(program, name); // Input location
+        GLint components = 0; // Components the shader reads
+        bool integer = false; // Integer input
+        switch (type) { // Map GLSL type
+            case GL_FLOAT: components = 1; break;
+            case GL_FLOAT_VEC2: components = 2; break;
+            case GL_FLOAT_VEC3: components = 3; break;
+            case GL_FLOAT_VEC4: components = 4; break;
+            case GL_INT: case GL_UNSIGNED_INT: components = 1; integer = true; break;
+            default: components = 0; break; // Matrices and others are not checked
+        }
+        const VertexAttrib* match = NULL; // Layout attribute at this location
+        for (size_t a = 0; a < attribs.size(); a++) // Iterate over layout
+            if ((GLint)attribs[a].location == location) // If same location
+                match = &attribs[a]; // Found it
+        if (!match) { // If nothing feeds the input
+            std::cout << "ERROR::VERTEX_LAYOUT::" << programName << ": input '" << name << "' at location " << location << " is not provided by " << VertexLayout<V>::Name() << std::endl; // Error message
+            valid = false; // Invalid
+        } else if (components != 0 && (match->integer != integer || match->size != components)) { // If format mismatch
+            std::cout << "ERROR::VERTEX_LAYOUT::" << programName << ": input '" << name << "' does not match " << VertexLayout<V>::Name() << "::" << match->name << std::endl; // Error message
+            valid = false; // Invalid
+        }
+    }
+    return valid; // Return result
+}
@@ -0,0 +1,21 @@
+#!/bin/bash
+# Clustered lighting benchmark for Project 9
+# Renders the default scene headless with 1, 2, 4 ... 1024 point lights and prints the frame times of each run
+#
+# Usage: ./benchmark_lights.sh [extra p9 arguments]
+#   e.g. ./benchmark_lights.sh --size 1920x1080 --frames 600
+#
+# Build p9 first. On machines without a GPU prefix with LIBGL_ALWAYS_SOFTWARE=1 (timings then measure llvmpipe).
+
+set -e # Stop on first failure
+
+cd "$(dirname "$0")" # Work relative to the script
+if [ ! -x ./p9 ]; then # If p9 has not been built
+    echo "benchmark_lights: build p9 first (see README.md)" >&2 # Error message
+    exit 1 # Fail
+fi
+
+for lights in 1 2 4 8 16 32 64 128 256 512 1024; do
+    result=$(./p9 --headless --frames 300 --uncapped --lights $lights "$@" | grep "frames in") # Frame time summary line
+    printf "%5d lights: %s\n" $lights "${result#Headless: }" # One line per light count
+done
@@ -1,17 +1,44 @@
-#version 330 core
+#version 430 core
 layout (location = 0) in vec3 aPos; // Receives aPos
-layout (location = 4) in vec3 aNormal; // Receives aNormal
+layout (location = 1) in vec3 aNormal; // Receives aNormal
+layout (location = 2) in vec2 aTexCoords; // Receives aTexCoords, used to find lightmap texels
 
 out vec3 FragPos; // Returns FragPos
 out vec3 Normal; // Returns Normal
+flat out vec4 BakedFace; // Lightmap face: texel corner in the atlas, texels across, kind of bake
+out vec2 BakedData; // Texel within the lightmap face, or the vertex's baked values
+out gl_PerVertex { vec4 gl_Position; }; // Redeclared for separable programs
+invariant gl_Position; // Same depth as the depth pre-pass, so GL_EQUAL matches
 
-uniform mat4 model; // Receives model uniform
-uniform mat4 view; // Receives view uniform
-uniform mat4 projection; // Receives projection uniform
+// Per-object constants computed once per frame on the CPU (ObjectConstants.h)
+struct ObjectConstants {
+    mat4 mvp; // projection * view * model
+    mat4 model; // model
+    mat4 normalMatrix; // transpose(inverse(model)) in the upper 3x3
+};
+layout (std430, binding = 0) readonly buffer ObjectBuffer {
+    ObjectConstants objects[]; // One entry per object
+};
+uniform uint objectIndex; // Receives index of the object being drawn
+
+// Baked lighting traced offline by lightbake [BakedLighting.h]
+layout (binding = 6) uniform usamplerBuffer bakedObjects; // Kind, placement and face size per object
+layout (binding = 7) uniform samplerBuffer bakedVertices; // Ambient occlusion and key light visibility per vertex
 
 void main()
 {
-    gl_Position = projection * view * vec4(aPos, 1.0f);  // Implements transformations - multiplies transformation vectors
-    FragPos = vec3(model * vec4(aPos, 1.0));  // Sets fragment position
-    Normal = mat3(transpose(inverse(model))) * aNormal;  // Normalizes
+    gl_Position = objects[objectIndex].mvp * vec4(aPos, 1.0f);  // Implements transformations with precomputed MVP
+    FragPos = vec3(objects[objectIndex].model * vec4(aPos, 1.0));  // Sets fragment position
+    Normal = mat3(objects[objectIndex].normalMatrix) * aNormal;  // Transforms normal with precomputed normal matrix
+    uvec4 baked = texelFetch(bakedObjects, int(objectIndex)); // This object's bake
+    BakedFace = vec4(0.0); // Not baked
+    BakedData = vec2(0.0);
+    if (baked.x == 1u) { // If lightmapped, the built-in cube with six vertices per face
+        uint face = uint(gl_VertexID) / 6u; // Face, tiles are 3x2 faces
+        BakedFace = vec4(float(baked.y + (face % 3u) * baked.w), float(baked.z + (face / 3u) * baked.w), float(baked.w), 1.0); // Face's corner texel
+        BakedData = aTexCoords * float(baked.w); // Position on the face in texels
+    } else if (baked.x == 2u) { // If baked per vertex
+        BakedFace.w = 2.0; // Values come with the vertex
+        BakedData = texelFetch(bakedVertices, int(baked.y) + gl_VertexID).rg; // Vertex values
+    }
 }
@@ -0,0 +1,6 @@
+#version 430 core
+// Depth-only passes (depth pre-pass, shadow maps) write depth and no color
+layout(early_fragment_tests) in; // Test depth before the (empty) shader runs
+
+void main() {
+}
@@ -0,0 +1,121 @@
+#!/bin/bash
+# Shader build step for Project 9
+# Validates every shader, embeds its source in shaders_embedded.h and optionally precompiles it to SPIR-V
+#
+# Usage: ./embed_shaders.sh [--spirv] [--no-validate]
+#   --spirv         Also compile each stage to OpenGL SPIR-V (needs glslangValidator) and embed the binary
+#   --no-validate   Embed without glslangValidator; broken shaders then only fail at runtime
+#
+# Run from the Project9 directory before compiling main.cpp. Any shader that fails to compile stops the
+# build here instead of at runtime. Without glslangValidator the build fails unless --no-validate is given.
+
+set -e # Stop on first failure
+
+cd "$(dirname "$0")" # Work relative to the script
+OUT=shaders_embedded.h # Generated header
+SPIRV=0 # SPIR-V disabled by default
+VALIDATE=1 # Validation required by default
+for arg in "$@"; do
+    case "$arg" in
+        --spirv) SPIRV=1 ;; # Enable SPIR-V
+        --no-validate) VALIDATE=0 ;; # Embed unchecked
+        *) echo "embed_shaders: unknown option $arg" >&2; exit 1 ;; # Error message
+    esac
+done
+
+VALIDATOR=$(command -v glslangValidator || true) # Locate validator if installed
+if [ -z "$VALIDATOR" ]; then # If validator missing
+    if [ $SPIRV -eq 1 ]; then # SPIR-V cannot be produced without it
+        echo "embed_shaders: --spirv needs glslangValidator" >&2 # Error message
+        exit 1 # Fail the build
+    fi
+    if [ $VALIDATE -eq 1 ]; then # Never skip validation silently
+        echo "embed_shaders: glslangValidator not found; install it, or pass --no-validate to embed unchecked shaders" >&2 # Error message
+        exit 1 # Fail the build
+    fi
+fi
+if [ $VALIDATE -eq 0 ]; then # If validation was turned off by hand
+    echo "embed_shaders: WARNING: --no-validate given, shaders are NOT checked and errors will only show at runtime" >&2 # Loud warning
+fi
+
+# Maps file extension to glslang stage name
+stage_of() {
+    case "$1" in
+        *.vs|*.vert) echo vert ;; # Vertex stage
+        *.frag|*.fs) echo frag ;; # Fragment stage
+        *.comp) echo comp ;; # Compute stage
+    esac
+}
+
+# Converts a file name into a C identifier
+ident_of() {
+    echo "$1" | tr -c 'A-Za-z0-9\n' '_' # Replace anything that is not alphanumeric
+}
+
+TMP=$(mktemp -d) # Scratch directory for SPIR-V output
+trap 'rm -rf "$TMP"' EXIT # Clean up on exit
+
+SHADERS=$(ls *.vs *.frag *.comp 2>/dev/null | sort) # Every shader in the project
+
+{
+    echo "// Generated by embed_shaders.sh - do not edit"
+    echo "#pragma once"
+    echo ""
+    echo "#include <cstddef> // Include cstddef"
+    echo "#include <cstring> // Include cstring"
+    echo ""
+    echo "#define EMBEDDED_SHADERS_HAVE_SPIRV $SPIRV // Non-zero when SPIR-V binaries are embedded"
+    echo ""
+} > "$OUT"
+
+for f in $SHADERS; do
+    stage=$(stage_of "$f") # Stage for this file
+    id=$(ident_of "$f") # Identifier for this file
+    if [ $VALIDATE -eq 1 ]; then # Validate unless turned off
+        "$VALIDATOR" -S "$stage" "$f" > "$TMP/log" || { cat "$TMP/log" >&2; echo "embed_shaders: $f failed to compile" >&2; exit 1; }
+    fi
+    {
+        echo "static const char ${id}_source[] = R\"glsl("
+        cat "$f"
+        echo ")glsl\";"
+    } >> "$OUT"
+    if [ $SPIRV -eq 1 ]; then # Precompile to SPIR-V
+        "$VALIDATOR" -G --aml -S "$stage" -o "$TMP/$id.spv" "$f" > "$TMP/log" || { cat "$TMP/log" >&2; exit 1; }
+        echo "static const unsigned char ${id}_spirv[] = {" >> "$OUT"
+        od -An -v -tx1 "$TMP/$id.spv" | sed 's/ \([0-9a-f][0-9a-f]\)/0x\1, /g' >> "$OUT" # Dump bytes as a C array
+        echo "};" >> "$OUT"
+    fi
+    echo "" >> "$OUT"
+done
+
+{
+    echo "// Embedded shader entry: file name, GLSL source and optional SPIR-V binary"
+    echo "struct EmbeddedShader {"
+    echo "    const char* name; // File name the shader was built from"
+    echo "    const char* source; // GLSL source"
+    echo "    const unsigned char* spirv; // SPIR-V binary or nullptr"
+    echo "    size_t spirvSize; // Size of SPIR-V binary in bytes"
+    echo "};"
+    echo ""
+    echo "static const EmbeddedShader embeddedShaders[] = {"
+    for f in $SHADERS; do
+        id=$(ident_of "$f")
+        if [ $SPIRV -eq 1 ]; then
+            echo "    { \"$f\", ${id}_source, ${id}_spirv, sizeof(${id}_spirv) },"
+        else
+            echo "    { \"$f\", ${id}_source, nullptr, 0 },"
+        fi
+    done
+    echo "};"
+    echo ""
+    echo "// Returns the embedded shader built from the given file name, or nullptr if it was not embedded"
+    echo "inline const EmbeddedShader* FindEmbeddedShader(const char* name) {"
+    echo "    for (size_t i = 0; i < sizeof(embeddedShaders) / sizeof(embeddedShaders[0]); i++) { // Iterate over table"
+    echo "        if (strcmp(embeddedShaders[i].name, name) == 0) // If names match"
+    echo "            return &embeddedShaders[i]; // Return entry"
+    echo "    }"
+    echo "    return nullptr; // Not embedded"
+    echo "}"
+} >> "$OUT"
+
+echo "embed_shaders: wrote $OUT ($(echo $SHADERS | wc -w) shaders, spirv=$SPIRV)"
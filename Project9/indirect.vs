@@ -0,0 +1,35 @@
+#version 430 core
+layout (location = 0) in vec3 aPos; // Receives aPos
+layout (location = 1) in vec3 aNormal; // Receives aNormal
+layout (location = 3) in uint aInstance; // Receives instance index from the instance stream [offset by baseInstance]
+
+out vec3 FragPos; // Returns FragPos
+out vec3 Normal; // Returns Normal
+flat out vec4 BakedFace; // Lightmap face: texel corner in the atlas, texels across, kind of bake
+out vec2 BakedData; // Texel within the lightmap face, or the vertex's baked values
+out gl_PerVertex { vec4 gl_Position; }; // Redeclared for separable programs
+
+// Instances written once by the CPU and culled on the GPU [GpuInstance in GpuCulling.h]
+struct Instance {
+    mat4 model; // Object to world
+    mat4 normalMatrix; // Normal matrix in the upper 3x3
+    vec4 boundsMin; // Object-space bounding box minimum
+    vec4 boundsMax; // Object-space bounding box maximum
+    uint batch; // Batch the instance is drawn with
+    uint slot; // Index within its batch
+    uint pad0; // Padding
+    uint pad1; // Padding
+};
+layout (std430, binding = 2) readonly buffer InstanceBuffer {
+    Instance instances[]; // Every instance
+};
+uniform mat4 viewProjection; // Receives projection * view
+
+void main() {
+    vec4 world = instances[aInstance].model * vec4(aPos, 1.0); // World position
+    gl_Position = viewProjection * world; // Implements transformations
+    FragPos = world.xyz; // Sets fragment position
+    Normal = mat3(instances[aInstance].normalMatrix) * aNormal; // Transforms normal with the instance's precomputed matrix
+    BakedFace = vec4(0.0); // Instances are never baked
+    BakedData = vec2(0.0);
+}
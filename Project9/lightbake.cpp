@@ -0,0 +1,548 @@
+// Light baker: traces ambient occlusion and key light visibility for a compiled scene, offline on the CPU
+//
+//   g++ -std=c++11 -O2 -pthread lightbake.cpp -o lightbake -lassimp
+//   ./lightbake default.p9scene default.p9bake
+//
+// Options:
+//   --samples N         ambient occlusion rays per value, rounded up to a multiple of 4 (default 64); a quarter
+//                       as many rays go to the key light
+//   --face-size N       lightmap texels across one cube face (default 16)
+//   --light-radius R    radius of the key light's sphere, which sets how soft its shadows are (default 0.15)
+//   --ao-distance D     how far away geometry still occludes ambient light (default 1.5)
+//   --threads N         worker threads (default: every core)
+//
+// Every object is treated as static. All triangles are moved to world space and put in one bounding volume
+// hierarchy. Each lightmap texel or model vertex then casts cosine-distributed rays over its hemisphere for
+// ambient occlusion and rays towards points on the key light's sphere for its visibility, four rays at a time
+// as an SSE packet that walks the hierarchy together. Values are shared out to the threads in small batches;
+// each value seeds its random shifts from its own index, so the output does not depend on the thread count.
+// The result is written in the format BakeFile.h describes, stamped with a hash of the scene file.
+
+#include <algorithm> // algorithm include
+#include <atomic> // atomic include
+#include <chrono> // chrono include
+#include <cmath> // cmath include
+#include <cstdlib> // cstdlib include
+#include <cstring> // cstring include
+#include <fstream> // fstream include
+#include <iostream> // iostream include
+#include <string> // string include
+#include <thread> // thread include
+#include <vector> // vector include
+
+#include <xmmintrin.h> // SSE intrinsics include
+
+#include <glm/glm.hpp> // glm include
+#include <glm/gtc/matrix_transform.hpp> // glm matrix math include
+#include <glm/gtc/quaternion.hpp> // glm quaternion include
+
+#include <assimp/Importer.hpp> // assimp importer include
+#include <assimp/scene.h> // assimp scene include
+#include <assimp/postprocess.h> // assimp postprocess include
+
+#include "SceneFile.h" // Include scene file format
+#include "BakeFile.h" // Include bake file format
+#include "CubeMesh.h" // Include built-in cube
+
+using namespace std; // Use namespace std
+
+// Tracing parameters from the command line
+struct BakeSettings {
+    uint32_t samples; // Ambient occlusion rays per value, multiple of 4
+    uint32_t lightSamples; // Key light rays per value, multiple of 4
+    uint32_t faceSize; // Texels across a cube face
+    float lightRadius; // Key light sphere radius
+    float aoDistance; // Ambient occlusion ray length
+    unsigned threads; // Worker threads
+    glm::vec3 lightPos; // Key light position
+};
+
+// Triangle stored for Moller-Trumbore: one corner and the two edges leaving it
+struct Triangle {
+    glm::vec3 v0, e1, e2; // Corner and edges
+};
+
+// Hierarchy node. Interior nodes have count 0, their left child right after them and their right child at
+// first; leaves hold count triangles starting at first.
+struct BvhNode {
+    float min[3]; // Box minimum
+    uint32_t first; // Right child or first triangle
+    float max[3]; // Box maximum
+    uint32_t count; // Triangles in a leaf, 0 for interior nodes
+};
+
+// Bounding volume hierarchy over every triangle in the scene
+struct Bvh {
+    vector<BvhNode> nodes; // Depth-first nodes, root first
+    vector<Triangle> triangles; // Triangles in leaf order
+};
+
+// Four rays traced together, one per SSE lane. Directions are scaled so hits only count for t in (0, 1).
+struct RayPacket {
+    __m128 ox, oy, oz; // Origins
+    __m128 dx, dy, dz; // Directions
+};
+
+// One value to bake: a surface point and where its two bytes go
+struct BakeSample {
+    glm::vec3 position; // World position
+    glm::vec3 normal; // World normal
+    size_t out; // Byte offset of the value in the output
+};
+
+// A model's meshes as Model.h loads them
+struct SourceMesh {
+    vector<glm::vec3> positions; // Vertex positions
+    vector<glm::vec3> normals; // Vertex normals
+    vector<uint32_t> indices; // Triangle list
+};
+
+// Small fast generator. Each value seeds its own, so results do not depend on which thread bakes it.
+struct Random {
+    uint32_t state; // Xorshift state, never 0
+
+    // Seeds from a value index
+    explicit Random(size_t index) {
+        this->state = (uint32_t)(index * 2654435761u) ^ 0x9E3779B9u; // Scrambled index
+        if (this->state == 0) // If the one bad seed
+            this->state = 1; // Any other
+    }
+
+    // Uniform float in [0, 1)
+    float Next() {
+        this->state ^= this->state << 13; // Xorshift32
+        this->state ^= this->state >> 17;
+        this->state ^= this->state << 5;
+        return (this->state >> 8) * (1.0f / 16777216.0f); // Top 24 bits
+    }
+};
+
+// Loads a model with the same post-processing and node order as Model.h, so vertex i here is vertex i there
+void processNode(const aiNode* node, const aiScene* scene, vector<SourceMesh>& meshes) {
+    for (unsigned i = 0; i < node->mNumMeshes; i++) { // Iterate over the node's meshes
+        const aiMesh* mesh = scene->mMeshes[node->mMeshes[i]]; // Mesh
+        SourceMesh source; // Copy
+        for (unsigned v = 0; v < mesh->mNumVertices; v++) { // Iterate over vertices
+            source.positions.push_back(glm::vec3(mesh->mVertices[v].x, mesh->mVertices[v].y, mesh->mVertices[v].z)); // Position
+            glm::vec3 normal(0.0f); // Missing normals stay zero and are not baked
+            if (mesh->mNormals) // If the mesh has normals
+                normal = glm::vec3(mesh->mNormals[v].x, mesh->mNormals[v].y, mesh->mNormals[v].z); // Normal
+            source.normals.push_back(normal); // Normal
+        }
+        for (unsigned f = 0; f < mesh->mNumFaces; f++) // Iterate over faces
+            if (mesh->mFaces[f].mNumIndices == 3) // Points and lines left by triangulation occlude nothing
+                for (unsigned j = 0; j < 3; j++) // Iterate over corners
+                    source.indices.push_back(mesh->mFaces[f].mIndices[j]); // Index
+        meshes.push_back(source); // Store
+    }
+    for (unsigned i = 0; i < node->mNumChildren; i++) // Iterate over children
+        processNode(node->mChildren[i], scene, meshes); // Recurse
+}
+
+// Loads every mesh of a model file, printing an error if it cannot be read
+bool loadModel(const string& path, vector<SourceMesh>& meshes) {
+    Assimp::Importer importer; // Importer
+    const aiScene* scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_FlipUVs); // Same flags as Model.h
+    if (!scene || scene->mFlags == AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) { // If unreadable
+        cout << "ERROR::LIGHTBAKE::MODEL " << path << " " << importer.GetErrorString() << endl; // Print error
+        return false;
+    }
+    processNode(scene->mRootNode, scene, meshes); // Walk nodes
+    return true;
+}
+
+// Adds a world-space triangle
+void addTriangle(vector<Triangle>& triangles, const glm::vec3& a, const glm::vec3& b, const glm::vec3& c) {
+    Triangle triangle = { a, b - a, c - a }; // Corner and edges
+    triangles.push_back(triangle); // Store
+}
+
+// Builds the hierarchy over triangles[order[begin, end)) and returns the node index. Splits at the median
+// centroid along the widest axis of the centroids' box, down to leaves of at most 4 triangles.
+uint32_t buildNode(Bvh& bvh, const vector<Triangle>& triangles, const vector<glm::vec3>& centroids, vector<uint32_t>& order, uint32_t begin, uint32_t end) {
+    uint32_t index = (uint32_t)bvh.nodes.size(); // This node
+    bvh.nodes.push_back(BvhNode()); // Reserve
+    glm::vec3 lo(1e30f), hi(-1e30f), clo(1e30f), chi(-1e30f); // Triangle and centroid boxes
+    for (uint32_t i = begin; i < end; i++) { // Iterate over triangles
+        const Triangle& t = triangles[order[i]]; // Triangle
+        glm::vec3 b = t.v0 + t.e1, c = t.v0 + t.e2; // Other corners
+        lo = glm::min(lo, glm::min(t.v0, glm::min(b, c))); // Grow box
+        hi = glm::max(hi, glm::max(t.v0, glm::max(b, c)));
+        clo = glm::min(clo, centroids[order[i]]); // Grow centroid box
+        chi = glm::max(chi, centroids[order[i]]);
+    }
+    for (int c = 0; c < 3; c++) { // Iterate over axes
+        bvh.nodes[index].min[c] = lo[c]; // Store box
+        bvh.nodes[index].max[c] = hi[c];
+    }
+    glm::vec3 extent = chi - clo; // Centroid spread
+    int axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2); // Widest axis
+    if (end - begin <= 4 || extent[axis] <= 0.0f) { // If small, or every centroid coincides
+        bvh.nodes[index].first = begin; // Leaf range
+        bvh.nodes[index].count = end - begin;
+        return index;
+    }
+    uint32_t middle = begin + (end - begin) / 2; // Median
+    nth_element(order.begin() + begin, order.begin() + middle, order.begin() + end, [&](uint32_t a, uint32_t b) {
+        return centroids[a][axis] < centroids[b][axis]; // Order along the axis
+    });
+    buildNode(bvh, triangles, centroids, order, begin, middle); // Left child follows this node
+    uint32_t right = buildNode(bvh, triangles, centroids, order, middle, end); // Right child
+    bvh.nodes[index].first = right; // Link
+    bvh.nodes[index].count = 0; // Interior
+    return index;
+}
+
+// Builds the hierarchy and stores the triangles in leaf order
+void buildBvh(Bvh& bvh, const vector<Triangle>& triangles) {
+    if (triangles.empty()) // If nothing can occlude
+        return;
+    vector<glm::vec3> centroids(triangles.size()); // Centroid per triangle
+    vector<uint32_t> order(triangles.size()); // Triangle per slot
+    for (size_t i = 0; i < triangles.size(); i++) { // Iterate over triangles
+        centroids[i] = triangles[i].v0 + (triangles[i].e1 + triangles[i].e2) / 3.0f; // Centroid
+        order[i] = (uint32_t)i; // Identity
+    }
+    buildNode(bvh, triangles, centroids, order, 0, (uint32_t)triangles.size()); // Build from the root
+    bvh.triangles.resize(triangles.size()); // Leaf order
+    for (size_t i = 0; i < order.size(); i++) // Iterate over slots
+        bvh.triangles[i] = triangles[order[i]]; // Reorder
+}
+
+// Lanes of a packet that hit a triangle, as a 4-bit mask
+int intersect(const Triangle& t, const RayPacket& ray) {
+    __m128 e1x = _mm_set1_ps(t.e1.x), e1y = _mm_set1_ps(t.e1.y), e1z = _mm_set1_ps(t.e1.z); // Edge 1
+    __m128 e2x = _mm_set1_ps(t.e2.x), e2y = _mm_set1_ps(t.e2.y), e2z = _mm_set1_ps(t.e2.z); // Edge 2
+    __m128 px = _mm_sub_ps(_mm_mul_ps(ray.dy, e2z), _mm_mul_ps(ray.dz, e2y)); // p = d x e2
+    __m128 py = _mm_sub_ps(_mm_mul_ps(ray.dz, e2x), _mm_mul_ps(ray.dx, e2z));
+    __m128 pz = _mm_sub_ps(_mm_mul_ps(ray.dx, e2y), _mm_mul_ps(ray.dy, e2x));
+    __m128 det = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e1x, px), _mm_mul_ps(e1y, py)), _mm_mul_ps(e1z, pz)); // e1 . p
+    __m128 inv = _mm_div_ps(_mm_set1_ps(1.0f), det); // 1 / det, inf for parallel rays
+    __m128 sx = _mm_sub_ps(ray.ox, _mm_set1_ps(t.v0.x)); // s = o - v0
+    __m128 sy = _mm_sub_ps(ray.oy, _mm_set1_ps(t.v0.y));
+    __m128 sz = _mm_sub_ps(ray.oz, _mm_set1_ps(t.v0.z));
+    __m128 u = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(sx, px), _mm_mul_ps(sy, py)), _mm_mul_ps(sz, pz)), inv); // Barycentric u
+    __m128 qx = _mm_sub_ps(_mm_mul_ps(sy, e1z), _mm_mul_ps(sz, e1y)); // q = s x e1
+    __m128 qy = _mm_sub_ps(_mm_mul_ps(sz, e1x), _mm_mul_ps(sx, e1z));
+    __m128 qz = _mm_sub_ps(_mm_mul_ps(sx, e1y), _mm_mul_ps(sy, e1x));
+    __m128 v = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(ray.dx, qx), _mm_mul_ps(ray.dy, qy)), _mm_mul_ps(ray.dz, qz)), inv); // Barycentric v
+    __m128 dist = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(e2x, qx), _mm_mul_ps(e2y, qy)), _mm_mul_ps(e2z, qz)), inv); // Hit distance
+    __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f); // Constants
+    __m128 hit = _mm_and_ps(_mm_cmpge_ps(u, zero), _mm_cmpge_ps(v, zero)); // Inside the first two edges
+    hit = _mm_and_ps(hit, _mm_cmple_ps(_mm_add_ps(u, v), one)); // Inside the third
+    hit = _mm_and_ps(hit, _mm_and_ps(_mm_cmpgt_ps(dist, _mm_set1_ps(1e-4f)), _mm_cmplt_ps(dist, one))); // Within the ray
+    return _mm_movemask_ps(hit); // NaN lanes from parallel rays compare false
+}
+
+// Lanes of a packet blocked by anything in the scene, as a 4-bit mask. The packet walks the hierarchy
+// together, entering a node if any lane still unblocked hits its box, and stops once every lane is blocked.
+int occluded(const Bvh& bvh, const RayPacket& ray) {
+    if (bvh.nodes.empty()) // If the scene is empty
+        return 0;
+    __m128 ix = _mm_div_ps(_mm_set1_ps(1.0f), ray.dx); // Inverse directions for slab tests
+    __m128 iy = _mm_div_ps(_mm_set1_ps(1.0f), ray.dy);
+    __m128 iz = _mm_div_ps(_mm_set1_ps(1.0f), ray.dz);
+    int blocked = 0; // Lanes known blocked
+    uint32_t stack[64]; // Nodes to visit, median splits keep this shallow
+    int top = 0; // Stack size
+    stack[top++] = 0; // Root
+    while (top > 0) { // Until every candidate node is visited
+        uint32_t index = stack[--top]; // Next node
+        const BvhNode& node = bvh.nodes[index]; // Node
+        __m128 ax = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.min[0]), ray.ox), ix); // Slab distances on x
+        __m128 bx = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.max[0]), ray.ox), ix);
+        __m128 ay = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.min[1]), ray.oy), iy); // On y
+        __m128 by = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.max[1]), ray.oy), iy);
+        __m128 az = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.min[2]), ray.oz), iz); // On z
+        __m128 bz = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.max[2]), ray.oz), iz);
+        __m128 enter = _mm_max_ps(_mm_max_ps(_mm_min_ps(ax, bx), _mm_min_ps(ay, by)), _mm_max_ps(_mm_min_ps(az, bz), _mm_setzero_ps())); // Latest entry
+        __m128 leave = _mm_min_ps(_mm_min_ps(_mm_max_ps(ax, bx), _mm_max_ps(ay, by)), _mm_min_ps(_mm_max_ps(az, bz), _mm_set1_ps(1.0f))); // Earliest exit
+        if ((_mm_movemask_ps(_mm_cmple_ps(enter, leave)) & ~blocked) == 0) // If no open lane hits the box
+            continue;
+        if (node.count == 0) { // If interior
+            stack[top++] = node.first; // Right child
+            stack[top++] = index + 1; // Left child, visited first
+            continue;
+        }
+        for (uint32_t i = 0; i < node.count; i++) { // Iterate over the leaf's triangles
+            blocked |= intersect(bvh.triangles[node.first + i], ray); // Any hit blocks
+            if (blocked == 15) // If every lane is blocked
+                return blocked;
+        }
+    }
+    return blocked;
+}
+
+// Number of set bits in a 4-bit lane mask
+int laneCount(int mask) {
+    return (mask & 1) + ((mask >> 1) & 1) + ((mask >> 2) & 1) + ((mask >> 3) & 1); // Sum bits
+}
+
+// Fills lane of a packet with a ray from origin along direction
+void setLane(RayPacket& ray, int lane, const glm::vec3& origin, const glm::vec3& direction) {
+    ((float*)&ray.ox)[lane] = origin.x; // Origin
+    ((float*)&ray.oy)[lane] = origin.y;
+    ((float*)&ray.oz)[lane] = origin.z;
+    ((float*)&ray.dx)[lane] = direction.x; // Direction
+    ((float*)&ray.dy)[lane] = direction.y;
+    ((float*)&ray.dz)[lane] = direction.z;
+}
+
+// Point k of an n-point Hammersley set in the unit square, shifted by (du, dv) and wrapped. Evenly spread
+// points give far less noise than independent random ones for the same ray count; the shift decorrelates
+// neighbouring values so what noise is left does not form a pattern.
+glm::vec2 hammersley(uint32_t k, uint32_t n, float du, float dv) {
+    uint32_t bits = k; // Radical inverse in base 2: reverse the bits
+    bits = (bits << 16) | (bits >> 16);
+    bits = ((bits & 0x55555555u) << 1) | ((bits & 0xAAAAAAAAu) >> 1);
+    bits = ((bits & 0x33333333u) << 2) | ((bits & 0xCCCCCCCCu) >> 2);
+    bits = ((bits & 0x0F0F0F0Fu) << 4) | ((bits & 0xF0F0F0F0u) >> 4);
+    bits = ((bits & 0x00FF00FFu) << 8) | ((bits & 0xFF00FF00u) >> 8);
+    float u = (k + 0.5f) / n + du, v = bits * (1.0f / 4294967296.0f) + dv; // Shifted point
+    return glm::vec2(u - floor(u), v - floor(v)); // Wrapped into [0, 1)
+}
+
+// Traces one value: ambient occlusion from cosine-distributed hemisphere rays and key light visibility from
+// rays to uniform points on the light's sphere, both spread with a randomly shifted Hammersley set
+void bakeSample(const Bvh& bvh, const BakeSettings& settings, const BakeSample& sample, size_t index, vector<uint8_t>& values) {
+    Random random(index); // This value's sequence
+    glm::vec2 aoShift(random.Next(), random.Next()), lightShift(random.Next(), random.Next()); // Shifts of the point sets
+    glm::vec3 n = sample.normal; // Normal
+    glm::vec3 helper = fabs(n.x) < 0.9f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f); // Any axis not along n
+    glm::vec3 t = glm::normalize(glm::cross(helper, n)); // Tangent
+    glm::vec3 b = glm::cross(n, t); // Bitangent
+    glm::vec3 origin = sample.position + n * 1e-3f; // Lifted off the surface so it does not hit itself
+    RayPacket ray; // Packet being filled
+    uint32_t open = 0; // Unblocked ambient rays
+    for (uint32_t s = 0; s < settings.samples; s += 4) { // Four rays per packet
+        for (int lane = 0; lane < 4; lane++) { // Iterate over lanes
+            glm::vec2 r = hammersley(s + lane, settings.samples, aoShift.x, aoShift.y); // Sample point
+            float phi = 6.2831853f * r.y, radius = sqrt(r.x); // Point on the unit disk
+            glm::vec3 direction = t * (radius * cos(phi)) + b * (radius * sin(phi)) + n * sqrt(1.0f - r.x); // Projected up onto the hemisphere
+            setLane(ray, lane, origin, direction * settings.aoDistance); // Occluders past aoDistance do not count
+        }
+        open += 4 - laneCount(occluded(bvh, ray)); // Count clear rays
+    }
+    uint32_t lit = 0; // Unblocked light rays
+    for (uint32_t s = 0; s < settings.lightSamples; s += 4) { // Four rays per packet
+        for (int lane = 0; lane < 4; lane++) { // Iterate over lanes
+            glm::vec2 r = hammersley(s + lane, settings.lightSamples, lightShift.x, lightShift.y); // Sample point
+            float z = 1.0f - 2.0f * r.x, phi = 6.2831853f * r.y; // Uniform direction
+            float ring = sqrt(max(0.0f, 1.0f - z * z)); // Radius at that height
+            glm::vec3 target = settings.lightPos + settings.lightRadius * glm::vec3(ring * cos(phi), ring * sin(phi), z); // Point on the light
+            setLane(ray, lane, origin, target - origin); // Ends at the light
+        }
+        lit += 4 - laneCount(occluded(bvh, ray)); // Count clear rays
+    }
+    values[sample.out] = (uint8_t)(255.0f * open / settings.samples + 0.5f); // Ambient occlusion
+    values[sample.out + 1] = (uint8_t)(255.0f * lit / settings.lightSamples + 0.5f); // Key light visibility
+}
+
+// Bakes every value on settings.threads threads, each taking batches of 64 from a shared counter
+void bakeAll(const Bvh& bvh, const BakeSettings& settings, const vector<BakeSample>& samples, vector<uint8_t>& values) {
+    atomic<size_t> next(0); // First value of the next batch
+    auto worker = [&]() {
+        for (;;) { // Until the values run out
+            size_t begin = next.fetch_add(64); // Claim a batch
+            if (begin >= samples.size()) // If none left
+                return;
+            size_t end = min(begin + 64, samples.size()); // Batch end
+            for (size_t i = begin; i < end; i++) // Iterate over the batch
+                bakeSample(bvh, settings, samples[i], i, values); // Trace
+        }
+    };
+    vector<thread> pool; // Extra threads
+    for (unsigned i = 1; i < settings.threads; i++) // This thread is the first worker
+        pool.push_back(thread(worker)); // Start worker
+    worker(); // Work here too
+    for (size_t i = 0; i < pool.size(); i++) // Iterate over threads
+        pool[i].join(); // Wait
+}
+
+// Rounds up to a multiple of 4
+uint32_t align4(uint32_t offset) {
+    return (offset + 3) & ~3u;
+}
+
+int main(int argc, char** argv) {
+    BakeSettings settings; // Defaults
+    settings.samples = 64; // Ambient rays
+    settings.faceSize = 16; // Texels per face edge
+    settings.lightRadius = 0.15f; // Soft-edged key light
+    settings.aoDistance = 1.5f; // Local occlusion only
+    settings.threads = max(1u, thread::hardware_concurrency()); // Every core
+    vector<const char*> paths; // Positional arguments
+    for (int a = 1; a < argc; a++) { // Iterate over arguments
+        string arg = argv[a]; // Argument
+        if (arg == "--samples" && a + 1 < argc) { // If sample count given
+            settings.samples = (uint32_t)max(1, atoi(argv[++a])); // Sample count
+        } else if (arg == "--face-size" && a + 1 < argc) { // If lightmap resolution given
+            settings.faceSize = (uint32_t)max(1, atoi(argv[++a])); // Texels per face edge
+        } else if (arg == "--light-radius" && a + 1 < argc) { // If light size given
+            settings.lightRadius = (float)atof(argv[++a]); // Light radius
+        } else if (arg == "--ao-distance" && a + 1 < argc) { // If occlusion range given
+            settings.aoDistance = (float)atof(argv[++a]); // Ray length
+        } else if (arg == "--threads" && a + 1 < argc) { // If thread count given
+            settings.threads = (unsigned)max(1, atoi(argv[++a])); // Thread count
+        } else {
+            paths.push_back(argv[a]); // Input or output
+        }
+    }
+    if (paths.size() != 2) { // If misused
+        cout << "usage: lightbake input.p9scene output.p9bake [--samples N] [--face-size N] [--light-radius R] [--ao-distance D] [--threads N]" << endl; // Print usage
+        return 1;
+    }
+    settings.samples = align4(settings.samples); // Whole packets
+    settings.lightSamples = align4(max(4u, settings.samples / 4)); // A quarter as many, whole packets
+
+    SceneFile scene; // Mapped scene
+    if (!scene.Open(paths[0])) // If missing or invalid
+        return 1;
+    const SceneFileHeader& sceneHeader = scene.Header(); // Tables
+    settings.lightPos = glm::vec3(sceneHeader.lightPos[0], sceneHeader.lightPos[1], sceneHeader.lightPos[2]); // Key light
+
+    // Meshes: the built-in cube, or every mesh of a model file
+    vector<vector<SourceMesh> > meshes(sceneHeader.meshCount); // Meshes per scene mesh
+    vector<bool> isCube(sceneHeader.meshCount, false); // Built-in cube per scene mesh
+    for (uint32_t m = 0; m < sceneHeader.meshCount; m++) { // Iterate over scene meshes
+        string path = scene.String(scene.Meshes()[m].path); // Mesh source
+        if (path == "cube") // If built in
+            isCube[m] = true; // Lightmapped
+        else
+            loadModel(path, meshes[m]); // Load, empty on failure
+    }
+
+    // World matrices, composed like SceneGraph: parent world * translate * rotate * scale
+    vector<glm::mat4> world(sceneHeader.objectCount); // World matrix per scene object
+    vector<bool> moves(sceneHeader.objectCount, false); // Whether an object or one of its parents has a velocity
+    vector<BakeFileObject> objects(sceneHeader.objectCount); // Output table
+    vector<Triangle> triangles; // Every triangle in world space
+    uint32_t tiles = 0, vertexCount = 0, vertexObjects = 0; // Atlas tiles and per-vertex values
+    for (uint32_t o = 0; o < sceneHeader.objectCount; o++) { // Iterate over scene objects
+        const SceneFileObject& record = scene.Objects()[o]; // Record in place
+        glm::quat rotation(record.rotation[3], record.rotation[0], record.rotation[1], record.rotation[2]); // Local rotation [w first]
+        glm::mat4 local = glm::translate(glm::mat4(1.0f), glm::vec3(record.position[0], record.position[1], record.position[2])) * glm::mat4_cast(rotation); // Translate and rotate
+        local = glm::scale(local, glm::vec3(record.scale[0], record.scale[1], record.scale[2])); // Scale
+        world[o] = record.parent < o ? world[record.parent] * local : local; // Forward parents are roots, as in main.cpp
+        moves[o] = (record.parent < o && moves[record.parent]) || record.velocity[0] != 0.0f || record.velocity[1] != 0.0f || record.velocity[2] != 0.0f; // Moving, or carried by a moving parent
+        BakeFileObject entry = { BAKE_NONE, 0, 0 }; // Not baked unless drawn
+        objects[o] = entry;
+        if (record.mesh >= sceneHeader.meshCount || record.material >= sceneHeader.materialCount) // If a group node
+            continue;
+        if (moves[o]) // If it leaves its place on the first tick
+            continue; // Neither baked nor an occluder, the shadow map handles it
+        if (isCube[record.mesh]) { // If the built-in cube
+            for (uint32_t v = 0; v < CUBE_MESH_VERTICES; v += 3) { // Iterate over triangles
+                glm::vec3 corner[3]; // World corners
+                for (int c = 0; c < 3; c++) // Iterate over corners
+                    corner[c] = glm::vec3(world[o] * glm::vec4(CUBE_MESH_DATA[(v + c) * CUBE_MESH_FLOATS], CUBE_MESH_DATA[(v + c) * CUBE_MESH_FLOATS + 1], CUBE_MESH_DATA[(v + c) * CUBE_MESH_FLOATS + 2], 1.0f)); // Transform
+                addTriangle(triangles, corner[0], corner[1], corner[2]); // Store
+            }
+            objects[o].kind = BAKE_LIGHTMAP; // Gets a tile
+            objects[o].first = tiles++; // Tile number for now, texel position once the atlas is sized
+            continue;
+        }
+        const vector<SourceMesh>& model = meshes[record.mesh]; // Model meshes
+        for (size_t m = 0; m < model.size(); m++) // Iterate over meshes
+            for (size_t i = 0; i + 2 < model[m].indices.size(); i += 3) // Iterate over triangles
+                addTriangle(triangles, glm::vec3(world[o] * glm::vec4(model[m].positions[model[m].indices[i]], 1.0f)), glm::vec3(world[o] * glm::vec4(model[m].positions[model[m].indices[i + 1]], 1.0f)), glm::vec3(world[o] * glm::vec4(model[m].positions[model[m].indices[i + 2]], 1.0f))); // Store
+        if (model.size() != 1) { // If per-vertex values could not be told apart per mesh at runtime
+            if (!model.empty())
+                cout << "lightbake: object " << o << " has " << model.size() << " meshes, only single-mesh models are baked" << endl; // Warn
+            continue;
+        }
+        objects[o].kind = BAKE_VERTEX; // Per-vertex values
+        objects[o].first = vertexCount; // First value
+        objects[o].second = (uint32_t)model[0].positions.size(); // Value count
+        vertexCount += objects[o].second; // Reserve
+        vertexObjects++; // Count
+    }
+
+    Bvh bvh; // Acceleration structure
+    buildBvh(bvh, triangles); // Build once, shared read-only by every thread
+
+    // Atlas: tiles of 3x2 faces in rows, close to square
+    uint32_t face = settings.faceSize; // Texels per face edge
+    uint32_t columns = tiles ? (uint32_t)ceil(sqrt(tiles * 2.0 / 3.0)) : 0; // Tiles per row
+    uint32_t atlasWidth = columns * 3 * face, atlasHeight = columns ? (tiles + columns - 1) / columns * 2 * face : 0; // Atlas size
+    size_t atlasBytes = (size_t)atlasWidth * atlasHeight * 2; // Two bytes per texel
+    vector<uint8_t> values(atlasBytes + (size_t)vertexCount * 2, 0); // Atlas then vertex values
+
+    // One sample per lightmap texel and per model vertex
+    vector<BakeSample> samples; // Values to bake
+    for (uint32_t o = 0; o < sceneHeader.objectCount; o++) { // Iterate over scene objects
+        BakeFileObject& entry = objects[o]; // Entry
+        glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(world[o]))); // Normals to world space
+        if (entry.kind == BAKE_LIGHTMAP) { // If a cube
+            entry.second = entry.first / columns * 2 * face; // Tile's bottom row
+            entry.first = entry.first % columns * 3 * face; // Tile's left column
+            for (uint32_t f = 0; f < 6; f++) { // Iterate over faces
+                const float* v = &CUBE_MESH_DATA[f * 6 * CUBE_MESH_FLOATS]; // Face's first triangle
+                glm::vec3 p0(v[0], v[1], v[2]), p1(v[8], v[9], v[10]), p2(v[16], v[17], v[18]); // Corners
+                glm::vec2 t0(v[3], v[4]), t1(v[11], v[12]), t2(v[19], v[20]); // Their texture coordinates
+                glm::vec2 a = t1 - t0, c = t2 - t0; // Edge texture coordinates
+                float det = a.x * c.y - c.x * a.y; // Their determinant, nonzero for a real face
+                glm::vec3 normal = glm::normalize(normalMatrix * glm::vec3(v[5], v[6], v[7])); // World normal
+                for (uint32_t j = 0; j < face; j++) { // Iterate over texel rows
+                    for (uint32_t i = 0; i < face; i++) { // Iterate over texel columns
+                        glm::vec2 d = glm::vec2((i + 0.5f) / face, (j + 0.5f) / face) - t0; // Texel center from the first corner
+                        glm::vec2 weights((d.x * c.y - c.x * d.y) / det, (a.x * d.y - d.x * a.y) / det); // Solve a * w.x + c * w.y = d
+                        glm::vec3 position = p0 + (p1 - p0) * weights.x + (p2 - p0) * weights.y; // Object-space point
+                        uint32_t x = entry.first + (f % 3) * face + i, y = entry.second + (f / 3) * face + j; // Atlas texel
+                        BakeSample sample = { glm::vec3(world[o] * glm::vec4(position, 1.0f)), normal, ((size_t)y * atlasWidth + x) * 2 }; // Sample
+                        samples.push_back(sample); // Store
+                    }
+                }
+            }
+        } else if (entry.kind == BAKE_VERTEX) { // If a single-mesh model
+            const SourceMesh& mesh = meshes[scene.Objects()[o].mesh][0]; // Its mesh
+            for (uint32_t v = 0; v < entry.second; v++) { // Iterate over vertices
+                glm::vec3 normal = normalMatrix * mesh.normals[v]; // World normal
+                size_t out = atlasBytes + (size_t)(entry.first + v) * 2; // Value offset
+                if (glm::dot(normal, normal) == 0.0f) { // If the model has no normal here
+                    values[out] = values[out + 1] = 255; // Unoccluded
+                    continue;
+                }
+                BakeSample sample = { glm::vec3(world[o] * glm::vec4(mesh.positions[v], 1.0f)), glm::normalize(normal), out }; // Sample
+                samples.push_back(sample); // Store
+            }
+        }
+    }
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now(); // Bake start
+    bakeAll(bvh, settings, samples, values); // Trace everything
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count(); // Bake time
+
+    // File: header, object table, atlas, vertex values
+    BakeFileHeader header; // Header
+    memset(&header, 0, sizeof(header)); // Clear
+    memcpy(header.magic, BAKE_FILE_MAGIC, 4); // Magic
+    header.version = BAKE_FILE_VERSION; // Version
+    header.sceneHash = BakeFileHash(scene.Data(), scene.Size()); // Ties the bake to this scene
+    header.objectCount = sceneHeader.objectCount; // Objects
+    header.objectOffset = sizeof(BakeFileHeader);
+    header.faceSize = face; // Face size
+    header.atlasWidth = atlasWidth; // Atlas
+    header.atlasHeight = atlasHeight;
+    header.atlasOffset = header.objectOffset + header.objectCount * sizeof(BakeFileObject);
+    header.vertexCount = vertexCount; // Vertex values
+    header.vertexOffset = align4(header.atlasOffset + (uint32_t)atlasBytes);
+    header.samples = settings.samples; // For reporting
+    header.fileSize = align4(header.vertexOffset + vertexCount * 2); // End of the vertex values
+
+    vector<char> bytes(header.fileSize, 0); // Whole file
+    memcpy(&bytes[0], &header, sizeof(header)); // Header
+    if (header.objectCount) memcpy(&bytes[header.objectOffset], &objects[0], header.objectCount * sizeof(BakeFileObject)); // Objects
+    if (atlasBytes) memcpy(&bytes[header.atlasOffset], &values[0], atlasBytes); // Atlas
+    if (vertexCount) memcpy(&bytes[header.vertexOffset], &values[atlasBytes], vertexCount * 2); // Vertex values
+    ofstream file(paths[1], ios::binary); // Output file
+    if (!file.write(&bytes[0], bytes.size())) {
+        cout << "ERROR::LIGHTBAKE::FILE_NOT_WRITTEN " << paths[1] << endl; // Print error
+        return 1;
+    }
+
+    double rays = (double)samples.size() * (settings.samples + settings.lightSamples); // Rays traced
+    cout << paths[1] << ": " << tiles << " lightmapped objects (" << atlasWidth << "x" << atlasHeight << " atlas), " << vertexObjects << " per-vertex objects (" << vertexCount << " vertices), " << triangles.size() << " triangles in " << bvh.nodes.size() << " nodes" << endl; // Report contents
+    cout << samples.size() << " values x " << settings.samples + settings.lightSamples << " rays in " << seconds << " s on " << settings.threads << " threads (" << rays / seconds / 1e6 << " Mrays/s)" << endl; // Report speed
+    return 0;
+}
@@ -0,0 +1,121 @@
+#version 430 core
+// Lit surface shared by every scene material: key light with shadows and baked lighting, plus clustered point
+// lights. Materials differ only in objectColor [Material::color in RenderQueue.h].
+out vec4 FragColor; // Returns FragColor
+
+in vec3 Normal; // Receives Normal
+in vec3 FragPos; // Receives FragPos
+
+// Per-frame constants written to the ring buffer once per frame [FrameConstants in ObjectConstants.h]
+layout(std140, binding = 1) uniform FrameConstants {
+    vec3 lightPos; // Light position
+    vec3 viewPos; // Camera position
+    vec3 lightColor; // Light color
+    uvec4 clusterGrid; // Tiles across, tiles down, depth slices, point light count
+    vec4 clusterDepth; // Near plane, far plane, slice scale, slice bias
+    vec4 clusterTile; // Pixels per tile across and down
+    vec4 shadowParams; // Shadow near plane, far plane (0 when off), normal offset and filter radius per unit depth
+};
+
+// Clustered point lights written to the ring buffer once per frame [ClusteredLights.h]
+struct PointLight {
+    vec4 positionRadius; // World position, radius in w
+    vec4 color; // Color
+};
+layout(std430, binding = 1) readonly buffer PointLights {
+    PointLight lights[]; // Every light
+};
+layout(std430, binding = 6) readonly buffer LightClusters {
+    uvec2 clusters[]; // First index and light count per cluster
+};
+layout(std430, binding = 7) readonly buffer LightIndices {
+    uint lightIndices[]; // Light indices grouped by cluster
+};
+
+// Key light's shadows, a depth cube map around lightPos compared in hardware [CachedShadowMap.h]
+layout(binding = 4) uniform samplerCubeShadow shadowMap;
+
+// Fraction of the key light reaching this fragment, averaged over eight filtered taps around its direction
+float keyLightVisibility(vec3 norm) {
+    if (shadowParams.y <= 0.0) // If shadows are off
+        return 1.0;
+    vec3 toFrag = FragPos - lightPos; // Light to fragment
+    float axis = max(abs(toFrag.x), max(abs(toFrag.y), abs(toFrag.z))); // Depth along the cube face's axis
+    toFrag += norm * shadowParams.z * axis; // Push off the surface by a few texels, which grow with depth
+    axis = max(abs(toFrag.x), max(abs(toFrag.y), abs(toFrag.z))); // Depth of the pushed point
+    float n = shadowParams.x, f = shadowParams.y; // Light's depth range
+    float depth = ((f + n) / (f - n) - 2.0 * f * n / ((f - n) * axis)) * 0.5 + 0.5; // Window depth the face would store
+    float radius = shadowParams.w * axis; // Filter radius, constant in texels
+    float visible = 0.0; // Lit taps
+    for (int i = 0; i < 8; i++) { // Iterate over the corners of a cube
+        vec3 offset = vec3(i & 1, (i >> 1) & 1, (i >> 2) & 1) * 2.0 - 1.0; // Corner direction
+        visible += texture(shadowMap, vec4(toFrag + offset * radius, depth)); // Compare
+    }
+    return visible / 8.0; // Average
+}
+
+// Ambient occlusion and key light visibility traced offline by lightbake [BakedLighting.h]
+layout(binding = 5) uniform sampler2D bakedAtlas; // Lightmap tiles
+flat in vec4 BakedFace; // Lightmap face: texel corner in the atlas, texels across, kind of bake
+in vec2 BakedData; // Texel within the lightmap face, or the vertex's baked values
+
+// Baked ambient occlusion and key light visibility, both 1 for objects that are not baked
+vec2 bakedLighting() {
+    if (BakedFace.w > 1.5) // If baked per vertex
+        return BakedData;
+    if (BakedFace.w > 0.5) { // If lightmapped
+        vec2 texel = BakedFace.xy + clamp(BakedData, vec2(0.5), vec2(BakedFace.z - 0.5)); // Filter inside the face so neighbouring faces never bleed in
+        return texture(bakedAtlas, texel / vec2(textureSize(bakedAtlas, 0))).rg; // Bilinear
+    }
+    return vec2(1.0); // Not baked
+}
+
+uniform vec3 objectColor; // Material color
+
+void main() {
+    // ambient
+    float ambientStrengh = 0.8; // Set ambient strength
+    vec3 ambient = ambientStrengh * lightColor; // Sets ambient
+    
+    // diffuse
+    vec3 norm = normalize(Normal); // Normalizes normal
+    vec3 lightDir = normalize(lightPos - FragPos); // Gets lightDir
+    float diff = max(dot(norm, lightDir), 0.0); // Gets diff
+    vec3 diffuse = diff * lightColor; // Sets diffuse
+
+    // specular
+    float specularStrength = 0.25f; // Sets specularStrength
+    vec3 viewDir = normalize(viewPos - FragPos); // Gets viewDir
+    vec3 reflectDir = reflect(-lightDir, norm); // Gets reflectDir
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), 8); // Gets spec
+    vec3 specular = specularStrength * spec * lightColor; // Sets specular
+
+    // shadow
+    vec2 baked = bakedLighting(); // Baked ambient occlusion and key light visibility
+    ambient *= baked.x; // Occluded ambient light
+    float shadow = min(keyLightVisibility(norm), baked.y); // Moving casters come from the shadow map, static ones are also baked
+
+    // point lights
+    vec3 points = vec3(0.0); // Sum of the point lights in this fragment's cluster
+    if (clusterGrid.w > 0u) { // If there are point lights
+        float zNdc = gl_FragCoord.z * 2.0 - 1.0; // NDC depth
+        float depth = 2.0 * clusterDepth.x * clusterDepth.y / (clusterDepth.y + clusterDepth.x - zNdc * (clusterDepth.y - clusterDepth.x)); // View depth
+        uint slice = uint(clamp(log(depth) * clusterDepth.z - clusterDepth.w, 0.0, float(clusterGrid.z - 1u))); // Depth slice
+        uvec2 tile = min(uvec2(gl_FragCoord.xy / clusterTile.xy), clusterGrid.xy - 1u); // Screen tile
+        uvec2 range = clusters[tile.x + clusterGrid.x * (tile.y + clusterGrid.y * slice)]; // Cluster's light list
+        for (uint i = 0u; i < range.y; i++) { // Iterate over listed lights
+            PointLight light = lights[lightIndices[range.x + i]]; // Light
+            vec3 toLight = light.positionRadius.xyz - FragPos; // Fragment to light
+            float dist = length(toLight); // Distance
+            if (dist >= light.positionRadius.w) // If out of reach
+                continue;
+            vec3 pointDir = toLight / dist; // Direction
+            float falloff = 1.0 - dist / light.positionRadius.w; // Linear falloff to zero at the radius
+            float pointSpec = pow(max(dot(viewDir, reflect(-pointDir, norm)), 0.0), 8); // Specular
+            points += falloff * falloff * (max(dot(norm, pointDir), 0.0) + specularStrength * pointSpec) * light.color.rgb; // Add light
+        }
+    }
+
+    vec3 result = (ambient + shadow * (diffuse + specular) + points) * objectColor; // Calculates result
+    FragColor = vec4(result, 1.0f); // Sets FragColor output
+}
@@ -1,4 +1,14 @@
 #include <iostream>  // iostream include
+#include <algorithm> // algorithm include
+#include <iomanip> // iomanip include
+#include <atomic> // atomic include
+#include <thread> // thread include
+#include <vector> // vector include
+#include <map> // map include
+#include <cmath> // cmath include
+#include <cstdlib> // cstdlib include
+#include <mutex> // mutex include
+#include <condition_variable> // condition_variable include
 
 // GLEW
 #define GLEW_STATIC // Define glew_static
@@ -19,289 +29,779 @@
 #include "shader.h" // Include shader class
 #include "Camera.h" // Include Camera class
 #include "Model.h" // Include Model class
+#include "GLState.h" // Include GL state cache
+#include "ObjectConstants.h" // Include per-object constants stage
+#include "VertexLayout.h" // Include vertex layout descriptors
+#include "RenderQueue.h" // Include render queue
+#include "RingBuffer.h" // Include per-frame ring buffer
+#include "Profiler.h" // Include frame profiler
+#include "../headless.h" // Include headless backend
+#include "../fixedstep.h" // Include fixed-timestep loop
+#include "TripleBuffer.h" // Include lock-free snapshot handoff
+#include "OcclusionCuller.h" // Include occlusion culling
+#include "GpuCulling.h" // Include GPU-driven culling
+#include "SceneGraph.h" // Include transform hierarchy
+#include "ECS.h" // Include entity component system
+#include "SceneComponents.h" // Include scene entity components
+#include "SceneFile.h" // Include binary scene format
+#include "ClusteredLights.h" // Include clustered point lights
+#include "DynamicResolution.h" // Include scaled rendering and upsample
+#include "CachedShadowMap.h" // Include cached key light shadows
+#include "CubeMesh.h" // Include built-in cube vertices
+#include "BakedLighting.h" // Include baked ambient occlusion and shadows
+#include "CameraPath.h" // Include recorded camera paths
 
 const GLuint WIDTH = 800, HEIGHT = 600; // Global variables for width and height of window
 
 // Function prototypes
 void key_callback(GLFWwindow* window, int key, int scancode, int action, int mode); // key_callback method
 void do_movement(); // Movement method
+void refresh_callback(GLFWwindow* window); // refresh_callback method
+bool keyHeld(); // Key state method
+bool cameraMoved(const Camera& before, const Camera& after); // Camera comparison method
+float blendAlpha(double now, double tickTime); // Interpolation factor method
+void benchmarkReport(const char* path, const std::vector<double>& frameTimes); // Benchmark statistics method
 
 Camera camera(glm::vec3(0.0f, 0.0f, 0.0f)); // Sets iniital camera pos (0, 0, 0)
 GLfloat lastX = WIDTH / 2.0; // Used for camera motion
 GLfloat lastY = HEIGHT / 2.0; // Used for camera motion
 bool keys[1024]; // Allowable number of key strokes
+bool windowDamaged = false; // Set when the window system needs the frame redrawn
+std::atomic<bool> depthPrepass(false); // Depth pre-pass before the color pass, toggled with Z
 
 glm::vec3 lightPos(1.0f, 1.0f, -2.0f); // Sets light position
 
-GLfloat deltaTime = 0.0f; // Initialize deltaTime for camera movement
-GLfloat lastFrame = 0.0f; // Initialize lastFrame for camera movement
-
-int main() {
-    // Init GLFW
-    glfwInit(); // Initialize GLFW
-    // Set all the required options for GLFW
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3); // Set major context version
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3); // Set minor context version
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE); // Set profiles
-    glfwWindowHint(GLFW_RESIZABLE, GL_FALSE); // Set resizable to false
-
-    // Create GLFWwindow
-    GLFWwindow* window = glfwCreateWindow(WIDTH, HEIGHT, "Project 9", nullptr, nullptr); // Create window
-    glfwMakeContextCurrent(window); // Make context method
+const double SIMULATION_STEP = 1.0 / 60.0; // Seconds per simulation tick
+GLfloat deltaTime = SIMULATION_STEP; // Time step for camera movement, always one tick
+GLfloat lastStatsReport = 0.0f; // Time of last state cache report
+const GLuint IDLE_AFTER_FRAMES = 3; // Frames drawn after the last change before idling, so occlusion results catch up
+
+// Vertex structure for the cube and checkerboard tiles
+struct CubeVertex {
+    glm::vec3 Position; // Vec3 position
+    glm::vec2 TexCoords; // Vec2 texture coordinates
+    glm::vec3 Normal; // Vec3 normal
+};
+
+// Cube vertex layout: formats, offsets and stride come from the struct members
+VERTEX_LAYOUT(CubeVertex,
+    VERTEX_ATTRIB(CubeVertex, Position, 0),
+    VERTEX_ATTRIB(CubeVertex, Normal, 1),
+    VERTEX_ATTRIB(CubeVertex, TexCoords, 2))
+
+// Simulation state for one tick, handed whole from the simulation thread to the render thread
+struct FrameSnapshot {
+    Camera previousCamera; // Camera at the tick before
+    Camera camera; // Camera at this tick
+    double tickTime; // Time this tick was due
+    double inputTime; // Time this tick read the keys
+    std::vector<glm::mat4> models; // Model matrix per object
+    std::vector<GLuint> dynamicObjects; // Objects that have ever moved, in the order they first did
+};
+
+// Camera of the last tick, handed to the render thread apart from the snapshot so it can be read again late in a frame
+struct CameraLatch {
+    Camera previousCamera; // Camera at the tick before
+    Camera camera; // Camera at this tick
+    double tickTime; // Time this tick was due
+    double inputTime; // Time this tick read the keys
+};
+
+int main(int argc, char** argv) {
+    // Profiling options: --profile prints zone percentiles, --profile-csv/--profile-json also stream every frame
+    Profiler& profiler = Profiler::Get(); // Frame profiler
+    bool occlusionCulling = true; // --no-occlusion draws everything, for comparison
+    bool gpuCulling = false; // --gpu-culling culls and submits the scene from a compute pass
+    GLuint fieldInstances = 0; // --instances N adds a field of N cubes, for stress testing GPU culling
+    const char* scenePath = "default.p9scene"; // --scene path.p9scene loads another compiled scene
+    bool continuous = false; // --continuous redraws every frame even when nothing moved
+    bool lateLatch = false; // --late-latch rewrites the camera just before the draws are issued
+    const char* recordFile = NULL; // --record path.bin saves the camera's moves for --benchmark
+    const char* benchmarkFile = NULL; // --benchmark path.bin plays a recorded path back, one tick per frame, and reports frame times
+    GLuint pointLights = 0; // --lights N scatters N point lights over the floor, shaded through clustered lighting
+    bool shadowsOn = true; // --no-shadows skips the key light's shadow map
+    const char* bakePath = "default.p9bake"; // --bake path.p9bake loads baked lighting from lightbake, --no-bake skips it
+    bool bakeRequested = false; // Only a bake named on the command line is an error when missing
+    for (int a = 1; a < argc; a++) { // Iterate over arguments
+        string arg = argv[a]; // Argument
+        if (arg == "--no-occlusion") { // If culling disabled
+            occlusionCulling = false; // Disable culling
+        } else if (arg == "--depth-prepass") { // If depth pre-pass requested
+            depthPrepass = true; // Start with the pre-pass on
+        } else if (arg == "--no-shadows") { // If shadows disabled
+            shadowsOn = false; // Disable shadows
+        } else if (arg == "--bake" && a + 1 < argc) { // If a bake was named
+            bakePath = argv[++a]; // Bake path
+            bakeRequested = true; // Must load
+        } else if (arg == "--no-bake") { // If baked lighting disabled
+            bakePath = NULL; // Skip it
+        } else if (arg == "--continuous") { // If render-on-demand disabled
+            continuous = true; // Draw every frame
+        } else if (arg == "--late-latch") { // If the camera is latched late
+            lateLatch = true; // Latch before the draws
+        } else if (arg == "--record" && a + 1 < argc) { // If recording a camera path
+            recordFile = argv[++a]; // Path to write on exit
+        } else if (arg == "--benchmark" && a + 1 < argc) { // If playing a camera path back
+            benchmarkFile = argv[++a]; // Path to play
+        } else if (arg == "--scene" && a + 1 < argc) { // If another scene requested
+            scenePath = argv[++a]; // Scene path
+        } else if (arg == "--gpu-culling") { // If GPU culling requested
+            gpuCulling = true; // Enable GPU culling
+        } else if (arg == "--instances" && a + 1 < argc) { // If instance field requested
+            gpuCulling = true; // Field only exists on the GPU path
+            fieldInstances = (GLuint)atoi(argv[++a]); // Field size
+        } else if (arg == "--lights" && a + 1 < argc) { // If point lights requested
+            pointLights = (GLuint)atoi(argv[++a]); // Light count
+        } else if (arg == "--profile") { // If stats requested
+            profiler.Enable(); // Enable profiler
+        } else if (arg == "--profile-csv" && a + 1 < argc) { // If CSV requested
+            profiler.Enable(); // Enable profiler
+            profiler.OpenCSV(argv[++a]); // Open CSV stream
+        } else if (arg == "--profile-json" && a + 1 < argc) { // If JSON requested
+            profiler.Enable(); // Enable profiler
+            profiler.OpenJSON(argv[++a]); // Open JSON stream
+        }
+    }
 
-    // Set required callback functions
-    glfwSetKeyCallback(window, key_callback); // Set key_callback method
+    // --headless renders a fixed number of frames into an offscreen framebuffer instead of a window
+    bool headless = headlessInit(argc, argv, WIDTH, HEIGHT, 4, 3, true); // Try headless EGL context [4.3 core]
+    GLuint width = headless ? headlessWidth() : WIDTH; // Framebuffer width
+    GLuint height = headless ? headlessHeight() : HEIGHT; // Framebuffer height
+    GLFWwindow* window = nullptr; // Window, none when headless
+    if (!headless) { // If rendering to a window
+        // Init GLFW
+        glfwInit(); // Initialize GLFW
+        // Set all the required options for GLFW
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4); // Set major context version
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3); // Set minor context version [4.3 for shader storage buffers]
+        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE); // Set profiles
+        glfwWindowHint(GLFW_RESIZABLE, GL_FALSE); // Set resizable to false
+
+        // Create GLFWwindow
+        window = glfwCreateWindow(WIDTH, HEIGHT, "Project 9", nullptr, nullptr); // Create window
+        glfwMakeContextCurrent(window); // Make context method
+
+        // Set required callback functions
+        glfwSetKeyCallback(window, key_callback); // Set key_callback method
+        glfwSetWindowRefreshCallback(window, refresh_callback); // Set refresh_callback method
+    }
 
     glewExperimental = GL_TRUE; // Set glew to experimental
 
-    glewInit(); // Initialize GLEW
+    glewInit(); // Initialize GLEW [headless, it reports no GLX display after loading the GL functions]
 
-    glViewport(0, 0, WIDTH, HEIGHT); // Define viewport dimensions
+    glViewport(0, 0, width, height); // Define viewport dimensions
 
-    glEnable(GL_DEPTH_TEST); // Set up OpenGL options
+    GLStateCache& state = GLStateCache::Get(); // State cache drops redundant binds and toggles
+    state.Enable(GL_DEPTH_TEST); // Set up OpenGL options
 
     // INSERT SHADERS HERE FOR PROJECT 10
-    Shader cubeShader("cube.vs", "cube.frag"); // Create shader for cube object
-    Shader cylinderShader("cylinder.vs", "cylinder.frag"); // Create shader for cylinder object
-    Shader sphereShader("sphere.vs", "sphere.frag"); // Create shader for sphere object
-    Shader checkerboardShader("checkerboard.vs", "checkerboard.frag"); // Create shader for checkerboard
-
-    // Models for Cylinder and Sphere
-    Model sphereModel("sphere.obj"); // Define model for sphere using obj
-    Model cylinderModel("cylinder.obj"); // Defines model for cylinder using obj
-
-    GLfloat vertices[] = {
-        // Coordinates: 3 Position, 3 Color, 2 Texture
-        // Back face of cube
-        -0.5f, -0.5f, -0.5f, 0.0f, 0.0f, 0.0f,  0.0f, -1.0f, // Bottom left
-        0.5f, -0.5f, -0.5f, 1.0f, 0.0f, 0.0f,  0.0f, -1.0f, // Bottom right
-        0.5f, 0.5f, -0.5f, 1.0f, 1.0f, 0.0f,  0.0f, -1.0f, // Upper right
-        0.5f, 0.5f, -0.5f, 1.0f, 1.0f, 0.0f,  0.0f, -1.0f, // Upper right
-        -0.5f, 0.5f, -0.5f, 0.0f, 1.0f, 0.0f,  0.0f, -1.0f, // Upper left
-        -0.5f, -0.5f, -0.5f, 0.0f, 0.0f, 0.0f,  0.0f, -1.0f, // Bottom left
-
-        // Front face of cube
-        -0.5f, -0.5f,  0.5f,  0.0f, 0.0f, 0.0f,  0.0f,  1.0f, // Bottom left
-        0.5f, -0.5f,  0.5f,  1.0f, 0.0f, 0.0f,  0.0f,  1.0f, // Bottom right
-        0.5f,  0.5f,  0.5f,  1.0f, 1.0f, 0.0f,  0.0f,  1.0f, // Upper right
-        0.5f,  0.5f,  0.5f,  1.0f, 1.0f, 0.0f,  0.0f,  1.0f, // Upper right
-        -0.5f,  0.5f,  0.5f,  0.0f, 1.0f, 0.0f,  0.0f,  1.0f, // Upper left
-        -0.5f, -0.5f,  0.5f,  0.0f, 0.0f, 0.0f,  0.0f,  1.0f, // Bottom left
-
-        // Left face
-        -0.5f,  0.5f,  0.5f,  1.0f, 0.0f, -1.0f,  0.0f,  0.0f, // Upper close
-        -0.5f,  0.5f, -0.5f,  1.0f, 1.0f, -1.0f,  0.0f,  0.0f, // Upper far
-        -0.5f, -0.5f, -0.5f,  0.0f, 1.0f, -1.0f,  0.0f,  0.0f, // Lower far
-        -0.5f, -0.5f, -0.5f,  0.0f, 1.0f, -1.0f,  0.0f,  0.0f, // Lower far
-        -0.5f, -0.5f,  0.5f,  0.0f, 0.0f, -1.0f,  0.0f,  0.0f, // Lower close
-        -0.5f,  0.5f,  0.5f,  1.0f, 0.0f, -1.0f,  0.0f,  0.0f, // Upper close
-
-        // Right face
-        0.5f,  0.5f,  0.5f,  1.0f, 0.0f, 1.0f,  0.0f,  0.0f, // Upper close
-        0.5f,  0.5f, -0.5f,  1.0f, 1.0f, 1.0f,  0.0f,  0.0f, // Upper far
-        0.5f, -0.5f, -0.5f,  0.0f, 1.0f, 1.0f,  0.0f,  0.0f, // Lower far
-        0.5f, -0.5f, -0.5f,  0.0f, 1.0f, 1.0f,  0.0f,  0.0f, // Lower far
-        0.5f, -0.5f,  0.5f,  0.0f, 0.0f, 1.0f,  0.0f,  0.0f, // Lower close
-        0.5f,  0.5f,  0.5f,  1.0f, 0.0f, 1.0f,  0.0f,  0.0f, // Upper close
-
-        // Bottom face
-        -0.5f, -0.5f, -0.5f,  0.0f, 1.0f,  0.0f, -1.0f,  0.0f, // Left far
-        0.5f, -0.5f, -0.5f,  1.0f, 1.0f,  0.0f, -1.0f,  0.0f, // Right far
-        0.5f, -0.5f,  0.5f,  1.0f, 0.0f,  0.0f, -1.0f,  0.0f, // Right close
-        0.5f, -0.5f,  0.5f,  1.0f, 0.0f,  0.0f, -1.0f,  0.0f, // Right close
-        -0.5f, -0.5f,  0.5f,  0.0f, 0.0f,  0.0f, -1.0f,  0.0f, // Left close
-        -0.5f, -0.5f, -0.5f,  0.0f, 1.0f,  0.0f, -1.0f,  0.0f, // Left far
-
-        // Top Face
-        -0.5f,  0.5f, -0.5f,  0.0f, 1.0f, 0.0f,  1.0f,  0.0f, // Left far
-         0.5f,  0.5f, -0.5f,  1.0f, 1.0f, 0.0f,  1.0f,  0.0f, // Right far
-         0.5f,  0.5f,  0.5f,  1.0f, 0.0f, 0.0f,  1.0f,  0.0f, // Right close
-         0.5f,  0.5f,  0.5f,  1.0f, 0.0f, 0.0f,  1.0f,  0.0f, // Right close
-        -0.5f,  0.5f,  0.5f,  0.0f, 0.0f, 0.0f,  1.0f,  0.0f, // Left close
-        -0.5f,  0.5f, -0.5f,  0.0f, 1.0f, 0.0f,  1.0f,  0.0f // Left far
-    };
-    GLuint VBO, VAO; // Initialize VBO, VAO
-    glGenVertexArrays(1, &VAO); // Generate VAO
+    // Pipelines share separable stages, so the identical cube/sphere/checkerboard vertex stages compile once
+    ShaderPipeline cubeShader("cube.vs", "lit.frag"); // Create shader for cube object
+    ShaderPipeline cylinderShader("cylinder.vs", "lit.frag"); // Create shader for cylinder object
+    ShaderPipeline sphereShader("sphere.vs", "lit.frag"); // Create shader for sphere object
+    ShaderPipeline checkerboardShader("checkerboard.vs", "lit.frag"); // Create shader for checkerboard
+    // Same fragment stage fed by indirect.vs, for --gpu-culling
+    ShaderPipeline litIndirect("indirect.vs", "lit.frag"); // Every material drawn indirectly
+    ShaderPipeline depthShader("depth.vs", "depth.frag"); // Depth pre-pass, positions only
+    cout << "Compiled " << ShaderStage::Count() << " unique shader stages" << endl; // Report stage count
+
+    // Check each vertex stage against the layout that will feed it; a mismatch would draw garbage, so stop here
+    bool layoutsMatch = ValidateVertexLayout<CubeVertex>(cubeShader.VertexProgram, "cube"); // Cube draws CubeVertex
+    layoutsMatch = ValidateVertexLayout<CubeVertex>(checkerboardShader.VertexProgram, "checkerboard") && layoutsMatch; // Tiles draw CubeVertex
+    layoutsMatch = ValidateVertexLayout<Vertex>(sphereShader.VertexProgram, "sphere") && layoutsMatch; // Sphere draws Mesh Vertex
+    layoutsMatch = ValidateVertexLayout<Vertex>(cylinderShader.VertexProgram, "cylinder") && layoutsMatch; // Cylinder draws Mesh Vertex
+    layoutsMatch = ValidateVertexLayout<CubeVertex>(depthShader.VertexProgram, "depth") && layoutsMatch; // Pre-pass reads only location 0, which every layout has
+
+    // Occlusion culling draws bounding box proxies with the cube's vertices
+    OcclusionCuller occlusion; // Occlusion culler
+    occlusion.Enable(occlusionCulling && !gpuCulling); // Apply --no-occlusion, GPU culling replaces it
+    layoutsMatch = ValidateVertexLayout<CubeVertex>(occlusion.VertexProgram(), "occlusion") && layoutsMatch; // Proxies draw CubeVertex
+    if (!layoutsMatch) // If any stage disagrees with its layout, every mismatch is printed above
+        return -1; // Fail startup
+
+    // Scene layout comes from a compiled scene file, mapped and read in place [see scenec.cpp]
+    SceneFile scene; // Mapped scene
+    if (!scene.Open(scenePath)) // If missing or invalid
+        return -1; // Nothing to draw
+    const SceneFileHeader& sceneHeader = scene.Header(); // Table counts and light
+    lightPos = glm::vec3(sceneHeader.lightPos[0], sceneHeader.lightPos[1], sceneHeader.lightPos[2]); // Scene light
+
+    static_assert(sizeof(CUBE_MESH_DATA) == CUBE_MESH_VERTICES * sizeof(CubeVertex), "cube data must be whole CubeVertex records"); // Check data matches layout
+    GLuint VBO; // Initialize VBO [the VAO is shared by every CubeVertex mesh]
     glGenBuffers(1, &VBO); // Generate VBO
 
-    glBindVertexArray(VAO);  // Bind VAO
+    state.BindBuffer(GL_ARRAY_BUFFER, VBO);  // Bind VBO
+    glBufferData(GL_ARRAY_BUFFER, sizeof(CUBE_MESH_DATA), CUBE_MESH_DATA, GL_STATIC_DRAW);  // Buffer Data [CubeMesh.h, shared with lightbake]
+    GLuint cubeIndices[CUBE_MESH_VERTICES]; // Cube indices [indirect draws need an index buffer]
+    for (GLuint i = 0; i < CUBE_MESH_VERTICES; i++) // Iterate over vertices
+        cubeIndices[i] = i; // Vertices are already in triangle order
+    GLuint EBO; // Initialize EBO
+    glGenBuffers(1, &EBO); // Generate EBO
+    state.BindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO); // Bind EBO
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(cubeIndices), cubeIndices, GL_STATIC_DRAW); // Buffer Data
+    GLuint cubePositions = MakePositionBuffer((const CubeVertex*)CUBE_MESH_DATA, CUBE_MESH_VERTICES); // Position stream for the depth pre-pass
 
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);  // Bind VBO
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);  // Buffer Data
+    // DEFINE TEXTURES HERE Project 10 --> NOTE FOR PROJECT 10
 
-    // Position attribute
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(GLfloat), (GLvoid*)0); // Set vertex attribute pointer for pos
-    glEnableVertexAttribArray(0); // Enable vertex attrib array with 0
-    // TexCoord attribute
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(GLfloat), (GLvoid*)(3 * sizeof(GLfloat))); // Set vertex attrib pointer for texcoord
-    glEnableVertexAttribArray(2); // Enable with 2
-    // Normalized Position Attribute
-    glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(GLfloat), (GLvoid*)0); // Set normalized pos vertex attrib
-    glEnableVertexAttribArray(4); // Enable with 4
+    // Materials for the render queue, one per scene material. Names point into the mapped file.
+    std::map<std::string, ShaderPipeline*> shaderFamilies; // Pipelines a scene can name
+    shaderFamilies["checkerboard"] = &checkerboardShader; // Tiles
+    shaderFamilies["cube"] = &cubeShader; // Cubes
+    shaderFamilies["sphere"] = &sphereShader; // Spheres
+    shaderFamilies["cylinder"] = &cylinderShader; // Cylinders
+    RenderQueue renderQueue; // Sorted render queue
+    renderQueue.SetDepthPipeline(&depthShader); // Used when the pre-pass is on
+    std::vector<Material> materials; // Every material, indexed by RenderQueue material id
+    GLuint fieldMaterial = SCENE_FILE_NONE; // Material for --instances cubes, the first cube material
+    for (GLuint m = 0; m < sceneHeader.materialCount; m++) { // Iterate over scene materials
+        const SceneFileMaterial& record = scene.Materials()[m]; // Record in place
+        std::map<std::string, ShaderPipeline*>::iterator family = shaderFamilies.find(scene.String(record.shader)); // Pipeline
+        if (family == shaderFamilies.end()) { // If the scene names an unknown shader
+            cout << "ERROR::SCENE::UNKNOWN_SHADER " << scene.String(record.shader) << endl; // Print error
+            family = shaderFamilies.find("cube"); // Draw with the cube pipeline
+        }
+        Material material = { scene.String(record.name), family->second, glm::vec3(record.color[0], record.color[1], record.color[2]), record.blended != 0 }; // Material
+        if (family->second == &cubeShader && fieldMaterial == SCENE_FILE_NONE) // If the first cube material
+            fieldMaterial = (GLuint)materials.size(); // Use it for the field
+        materials.push_back(material); // Keep a copy
+        renderQueue.AddMaterial(material); // Register, ids follow scene order
+    }
+    DrawGeometry cubeGeometry = MakeDrawGeometry<CubeVertex>(VBO, EBO, CUBE_MESH_VERTICES, cubePositions); // Cube vertices, also used for tiles
+
+    // Geometry table, one entry per mesh; entities refer to runs of it. "cube" is built in, other meshes are models.
+    std::vector<DrawGeometry> geometries; // Every mesh
+    Bounds unitBounds = { glm::vec3(-0.5f), glm::vec3(0.5f) }; // Cube vertices span the unit cube
+    MeshHandle cubeMesh = { (GLuint)geometries.size(), 1 }; // Built-in cube
+    geometries.push_back(cubeGeometry); // Cube geometry
+    std::vector<Model*> models; // Loaded models
+    std::vector<MeshHandle> meshes(sceneHeader.meshCount); // Handle per scene mesh
+    std::vector<Bounds> meshBounds(sceneHeader.meshCount); // Bounds per scene mesh
+    for (GLuint m = 0; m < sceneHeader.meshCount; m++) { // Iterate over scene meshes
+        std::string path = scene.String(scene.Meshes()[m].path); // Model path
+        if (path == "cube") { // If the built-in cube
+            meshes[m] = cubeMesh; // Shared cube
+            meshBounds[m] = unitBounds; // Unit box
+            continue;
+        }
+        models.push_back(new Model(&path[0])); // Load model
+        Model& model = *models.back(); // Loaded model
+        MeshHandle handle = { (GLuint)geometries.size(), model.MeshCount() }; // Model meshes
+        for (GLuint g = 0; g < model.MeshCount(); g++) // Iterate over model meshes
+            geometries.push_back(model.MeshGeometry(g)); // Mesh geometry
+        meshes[m] = handle; // Handle
+        model.Bounds(meshBounds[m].min, meshBounds[m].max); // Model bounds
+    }
 
-    glBindVertexArray(0); // Unbind VAO
+    // Per-object model matrices. MVP and normal matrices are computed from these once per frame.
+    ObjectConstantsStage objectConstants; // Per-object constants stage
+
+    // Object placement lives in the scene graph; model matrices are only recomputed for nodes that change
+    SceneGraph sceneGraph; // Transform hierarchy
+
+    // Every drawable object is an entity with a transform, mesh, material and bounding box
+    EntityWorld entities; // Scene entities
+    std::vector<GLuint> sceneNodes(sceneHeader.objectCount); // Scene graph node per scene object
+    std::vector<GLuint> sceneObjects(sceneHeader.objectCount, SCENE_FILE_NONE); // Object index per scene object, for the bake
+    for (GLuint o = 0; o < sceneHeader.objectCount; o++) { // Iterate over scene objects
+        const SceneFileObject& record = scene.Objects()[o]; // Record in place
+        GLuint parent = SceneGraph::NONE; // Root unless the parent is valid
+        if (record.parent < o) // If the parent came first
+            parent = sceneNodes[record.parent]; // Parent node
+        else if (record.parent != SCENE_FILE_NONE) // If it points forward
+            cout << "ERROR::SCENE::BAD_PARENT object " << o << endl; // Print error, treat as root
+        glm::vec3 position(record.position[0], record.position[1], record.position[2]); // Local position
+        glm::quat rotation(record.rotation[3], record.rotation[0], record.rotation[1], record.rotation[2]); // Local rotation [w first]
+        glm::vec3 scale(record.scale[0], record.scale[1], record.scale[2]); // Local scale
+        if (record.mesh >= sceneHeader.meshCount || record.material >= sceneHeader.materialCount) { // If a group node
+            sceneNodes[o] = sceneGraph.Add(parent, position, rotation, scale); // Grouping node, not drawn
+            continue;
+        }
+        Transform transform; // Placement
+        transform.object = objectConstants.Add(glm::mat4(1.0f)); // Register object, model filled in by the scene graph
+        transform.node = sceneGraph.Add(parent, position, rotation, scale, transform.object); // Scene graph node
+        sceneNodes[o] = transform.node; // Children attach here
+        sceneObjects[o] = transform.object; // Drawn as this object
+        MaterialHandle shading = { record.material }; // Material, ids follow scene order
+        Entity entity = entities.Create(); // New entity
+        entities.Add(entity, transform); // Transform component
+        entities.Add(entity, meshes[record.mesh]); // Mesh component
+        entities.Add(entity, shading); // Material component
+        entities.Add(entity, meshBounds[record.mesh]); // Bounds component
+        if (record.velocity[0] != 0.0f || record.velocity[1] != 0.0f || record.velocity[2] != 0.0f) { // If it moves
+            Velocity velocity = { glm::vec3(record.velocity[0], record.velocity[1], record.velocity[2]) }; // Constant motion
+            entities.Add(entity, velocity); // Velocity component, picked up by the movement system
+        }
+    }
+    const std::vector<GLuint>& placed = sceneGraph.Update(); // Compute every world matrix once
+    for (size_t n = 0; n < placed.size(); n++) // Iterate over nodes
+        if (sceneGraph.Object(placed[n]) != SceneGraph::NONE) // If drawn
+            objectConstants.SetModel(sceneGraph.Object(placed[n]), sceneGraph.World(placed[n])); // Store model matrix
+
+    // Object-space bounding boxes for occlusion culling
+    entities.Each<Transform, Bounds>([&](Entity, const Transform& transform, const Bounds& bounds) {
+        occlusion.Add(transform.object, bounds.min, bounds.max); // Object box
+    });
+
+    // Ambient occlusion and static shadows baked offline by lightbake for this exact scene file, if present
+    BakedLighting bakedLighting(objectConstants.Count()); // Empty until loaded
+    if (bakePath && (bakeRequested || std::ifstream(bakePath).good())) // If a bake was named or the default exists
+        bakedLighting.Load(bakePath, scene, sceneObjects); // Load, prints why if unusable
+
+    // Every mesh casts a shadow from the key light. Casters are cached until something moves; entities with a
+    // velocity move from the first tick, so they start out dynamic instead of costing a cache rebuild.
+    CachedShadowMap shadows; // Key light shadow map
+    shadows.Enable(shadowsOn); // Apply --no-shadows
+    std::vector<GLuint> dynamicObjects; // Objects drawn into the shadow map every frame
+    std::vector<bool> isDynamic(objectConstants.Count(), false); // Whether each object is in dynamicObjects
+    entities.Each<Transform, MeshHandle, Bounds>([&](Entity, const Transform& transform, const MeshHandle& mesh, const Bounds& bounds) {
+        for (GLuint m = 0; m < mesh.count; m++) // Iterate over meshes
+            shadows.AddCaster(transform.object, geometries[mesh.first + m], bounds.min, bounds.max); // Caster per mesh
+    });
+    entities.Each<Transform, Velocity>([&](Entity, const Transform& transform, const Velocity&) {
+        shadows.SetDynamic(transform.object); // Moves every tick
+        bakedLighting.Unbake(transform.object); // Its bake would move away from it
+        isDynamic[transform.object] = true; // Known dynamic
+        dynamicObjects.push_back(transform.object); // Tell the render thread
+    });
+
+    // With --gpu-culling the whole scene is culled by a compute pass and drawn with one indirect call per batch.
+    // The CPU path below then submits nothing and occlusion queries are off. Instances of objects that move are
+    // rewritten by the render thread whenever a snapshot brings new model matrices.
+    GpuCuller gpuCuller; // GPU culling and submission
+    std::vector<std::vector<GLuint> > objectInstances(objectConstants.Count()); // GPU instances per object, one per mesh
+    if (gpuCulling) { // If culling on the GPU
+        std::map<std::pair<GLuint, GLuint>, GLuint> batches; // Batch per material and geometry
+        auto batchFor = [&](GLuint material, GLuint geometry) {
+            std::pair<GLuint, GLuint> key(material, geometry); // Lookup key
+            if (batches.find(key) == batches.end()) { // If first use
+                Material indirect = materials[material]; // Same material
+                indirect.shader = &litIndirect; // Same fragment stage fed by indirect.vs
+                batches[key] = gpuCuller.AddBatch(indirect, geometries[geometry]); // New batch
+            }
+            return batches[key]; // Return batch
+        };
+        entities.Each<Transform, MeshHandle, MaterialHandle, Bounds>([&](Entity, const Transform& transform, const MeshHandle& mesh, const MaterialHandle& shading, const Bounds& bounds) {
+            for (GLuint m = 0; m < mesh.count; m++) // Iterate over meshes
+                objectInstances[transform.object].push_back(gpuCuller.AddInstance(batchFor(shading.material, mesh.first + m), objectConstants.GetModel(transform.object), bounds.min, bounds.max)); // Instance per mesh
+        });
+        if (fieldMaterial == SCENE_FILE_NONE) // If the scene has no cube material
+            fieldInstances = 0; // No field
+        GLuint fieldBatch = fieldInstances ? batchFor(fieldMaterial, cubeMesh.first) : 0; // Field shares the cube's batch
+        GLuint side = (GLuint)ceil(sqrt((double)fieldInstances)); // Field is a square grid
+        for (GLuint n = 0; n < fieldInstances; n++) { // Iterate over field cubes
+            glm::vec3 position(((n % side) - side / 2.0f) * 1.5f, 2.0f, -12.0f - (n / side) * 1.5f); // Grid above and behind the scene
+            glm::mat4 model = glm::scale(glm::translate(glm::mat4(1.0f), position), glm::vec3(0.5f)); // Half-size cube
+            gpuCuller.AddInstance(fieldBatch, model, unitBounds.min, unitBounds.max); // Field cube
+        }
+    }
 
-    // DEFINE TEXTURES HERE Project 10 --> NOTE FOR PROJECT 10
+    // Point lights sit in a grid just above the floor with a spread of colors; the scene's key light stays as is
+    ClusteredLights clusteredLights; // Light lists per view-space cluster
+    if (pointLights > ClusteredLights::MAX_LIGHTS) { // If more than the buffers hold
+        cout << "--lights " << pointLights << " is over the limit, using " << ClusteredLights::MAX_LIGHTS << endl; // Report clamp
+        pointLights = ClusteredLights::MAX_LIGHTS; // Clamp before sizing the grid, so the lights still cover the floor
+    }
+    GLuint lightSide = (GLuint)ceil(sqrt((double)pointLights)); // Lights are a square grid
+    for (GLuint n = 0; n < pointLights; n++) { // Iterate over lights
+        glm::vec3 position(-4.5f + 8.0f * ((n % lightSide) + 0.5f) / lightSide, 0.0f, -9.5f + 8.0f * ((n / lightSide) + 0.5f) / lightSide); // Cell center over the floor
+        glm::vec3 color(0.5f + 0.5f * sin(n * 2.1f), 0.5f + 0.5f * sin(n * 2.1f + 2.1f), 0.5f + 0.5f * sin(n * 2.1f + 4.2f)); // Hue cycles with index
+        clusteredLights.Add(position, 1.5f, color * 0.6f); // Add light
+    }
+
+    // Per-frame data goes through a persistently mapped ring buffer, one region per frame in flight
+    RingBuffer frameRing(objectConstants.Count() * sizeof(ObjectConstants) + sizeof(FrameConstants) + clusteredLights.FrameBytes() + 1024); // Room for one frame plus alignment
+
+    // --target-fps renders at a reduced scale when GPU frame time runs over budget, --resolution-scale fixes it
+    DynamicResolution resolution(width, height, dynResParse(argc, argv)); // Scaled target and upsample
+
+    // Simulation and input run on this thread at a fixed rate; a render thread owns the GL context and draws
+    // as fast as the swap interval allows. They share nothing but the snapshots in the triple buffer.
+    bool uncapped = fixedStepUncapped(argc, argv); // --uncapped disables vsync for benchmarking
+    FixedStep simulationClock = fixedStepInit(SIMULATION_STEP); // Simulation clock
+    camera.SetPerspective(FOVY, (GLfloat)width / (GLfloat)height, NEAR_PLANE, FAR_PLANE); // Projection for the window, copied into every snapshot
+
+    // --record keeps the camera's pose on every tick it moves; --benchmark shows tick n of a recorded path on
+    // frame n, ignoring input and wall time, so every run draws the same frames wherever it runs
+    CameraPath recordedPath((float)SIMULATION_STEP); // Path being recorded
+    CameraPath benchmarkPath((float)SIMULATION_STEP); // Path being played
+    if (benchmarkFile) { // If benchmarking
+        if (!benchmarkPath.Load(benchmarkFile)) // If missing or invalid
+            return -1; // Nothing to play
+        cout << "Benchmark: playing " << benchmarkFile << ", " << benchmarkPath.TickCount() << " frames" << endl; // Report
+        if (headless) // If offscreen
+            headlessState().frames = (int)benchmarkPath.TickCount(); // Run for exactly the path
+    }
+    Camera pathCamera = camera; // Pose played back, with the window's projection
+    std::vector<double> benchmarkTimes; // Milliseconds per frame while benchmarking
+    Camera previousCamera = camera; // Camera state at the previous tick
+    std::vector<glm::mat4> sceneModels(objectConstants.Count()); // Simulation's copy of every model matrix
+    for (GLuint i = 0; i < objectConstants.Count(); i++) // Iterate over objects
+        sceneModels[i] = objectConstants.GetModel(i); // Copy model matrix
+    FrameSnapshot initial = { camera, camera, 0.0, 0.0, sceneModels, dynamicObjects }; // State before the first tick
+    TripleBuffer<FrameSnapshot> snapshots(initial); // Simulation to render handoff
+    CameraLatch initialLatch = { camera, camera, 0.0, 0.0 }; // Camera before the first tick
+    TripleBuffer<CameraLatch> cameraLatch(initialLatch); // Newest camera, published every tick with --late-latch
+    std::atomic<bool> quit(false); // Set by the simulation thread when the window closes
+    std::atomic<bool> renderDone(false); // Set by the render thread when it stops
+
+    // Render on demand: in a window the render thread sleeps until the simulation publishes a change or the
+    // window needs repainting, and the simulation thread blocks on input while nothing moves. The last frame
+    // stays on screen meanwhile. Headless runs always draw every frame so benchmarks count them.
+    bool onDemand = !headless && !continuous && !benchmarkFile; // Skip frames when nothing changed
+    std::mutex redrawMutex; // Guards redrawRequested
+    std::condition_variable redrawWake; // Wakes the render thread
+    bool redrawRequested = true; // Something changed since the render thread last looked
+    auto requestRedraw = [&]() {
+        std::lock_guard<std::mutex> lock(redrawMutex); // Lock flag
+        redrawRequested = true; // Flag change
+        redrawWake.notify_one(); // Wake render thread
+    };
+
+    // --benchmark steps the scene once per drawn frame instead of by wall time: frame n waits for the snapshot
+    // taken after tick n, then asks for tick n + 1, which the simulation computes while frame n draws
+    std::mutex benchmarkMutex; // Guards the tick counters
+    std::condition_variable benchmarkWake; // Wakes either thread when a counter moves
+    uint32_t benchmarkWanted = 1; // Ticks the render thread has asked for
+    uint32_t benchmarkReady = 0; // Ticks simulated and published
+
+    // Release the context so the render thread can make it current
+    if (headless) // If offscreen
+        headlessMakeCurrent(false); // Release EGL context
+    else
+        glfwMakeContextCurrent(nullptr); // Release window context
+
+    std::thread renderThread([&]() {
+        if (headless) // If offscreen
+            headlessMakeCurrent(true); // Take EGL context
+        else {
+            glfwMakeContextCurrent(window); // Take window context
+            glfwSwapInterval(uncapped ? 0 : 1); // Vsync unless benchmarking
+        }
+
+        // Render Loop
+        GLuint framesLeft = 0; // Frames still to draw before idling
+        size_t dynamicSeen = 0; // Entries of the snapshot's dynamicObjects already handed to the shadow map
+        bool latchChecked = false; // Whether the first latch has been read back
+        Camera frameCamera; // Camera blended between the snapshot's ticks, keeps its matrices while it holds still
+        uint32_t benchmarkFrame = 0; // Frames drawn from the benchmark path, also the tick to show next
+        double lastSwap = headless ? headlessTime() : glfwGetTime(); // End of the previous frame
+        while (!quit.load() && (!headless || headlessRunning()) && (!benchmarkFile || benchmarkFrame < benchmarkPath.TickCount())) {
+            if (onDemand) { // If frames are skipped when nothing changed
+                std::unique_lock<std::mutex> lock(redrawMutex); // Lock flag
+                if (framesLeft == 0) // If the last change has been drawn out
+                    redrawWake.wait(lock, [&]() { return redrawRequested || quit.load(); }); // Sleep until something changes
+                if (redrawRequested) // If woken by a change
+                    framesLeft = IDLE_AFTER_FRAMES; // Draw it and let it settle
+                redrawRequested = false; // Seen
+                if (quit.load()) // If woken to stop
+                    break;
+            }
+            GLfloat currentFrame = headless ? headlessTime() : glfwGetTime(); // Get current time
+
+            profiler.BeginFrame(); // Start profiling this frame
+
+            // With --benchmark the snapshot for this frame's tick must be in before it is taken
+            if (benchmarkFile) { // If frames pull ticks
+                std::unique_lock<std::mutex> lock(benchmarkMutex); // Lock counters
+                benchmarkWake.wait(lock, [&]() { return benchmarkReady > benchmarkFrame || quit.load(); }); // Wait for tick benchmarkFrame
+                if (quit.load()) // If woken to stop
+                    break;
+                benchmarkWanted = benchmarkFrame + 2; // Simulate the next frame's tick meanwhile
+                benchmarkWake.notify_all(); // Wake the simulation
+            }
+
+            // Take the newest simulation state; model matrices only change when a new snapshot arrives
+            if (snapshots.Acquire()) { // If a new snapshot was published
+                const std::vector<glm::mat4>& models = snapshots.Front().models; // Its model matrices
+                for (GLuint i = 0; i < models.size(); i++) // Iterate over objects
+                    objectConstants.SetModel(i, models[i]); // Update model matrix
+                const std::vector<GLuint>& moving = snapshots.Front().dynamicObjects; // Objects that have moved, only ever grows
+                for (; dynamicSeen < moving.size(); dynamicSeen++) { // Iterate over objects new to the list
+                    shadows.SetDynamic(moving[dynamicSeen]); // Take it out of the cached shadow map
+                    bakedLighting.Unbake(moving[dynamicSeen]); // Light it at runtime from now on
+                }
+                if (gpuCulling) // If instances live on the GPU
+                    for (size_t d = 0; d < moving.size(); d++) // Iterate over objects that move
+                        for (size_t i = 0; i < objectInstances[moving[d]].size(); i++) // Iterate over their meshes
+                            gpuCuller.UpdateInstance(objectInstances[moving[d]][i], models[moving[d]]); // Follow the object
+            }
+            const FrameSnapshot& snapshot = snapshots.Front(); // Snapshot to draw
+            float alpha = blendAlpha(currentFrame, snapshot.tickTime); // Fraction of a tick since it was due
+            if (alpha < 1.0f) // If still blending towards the last tick
+                framesLeft = IDLE_AFTER_FRAMES; // Keep drawing
+
+            resolution.Begin(); // Render into the scaled target when dynamic resolution is on
+            glClearColor(0.0f, 0.0f, 0.0f, 0.0f); // Set background color
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT); // Clear buffers
+
+
+            // Initialize Camera; matrices are only rebuilt when the blended camera moved since the last frame
+            bool viewMoved; // Whether the drawn camera moved since the last frame
+            if (benchmarkFile) { // If playing a path, frame n shows tick n and input is ignored
+                glm::vec3 position; // Recorded position
+                glm::quat orientation; // Recorded rotation
+                benchmarkPath.Pose(benchmarkFrame, position, orientation); // Pose at this tick
+                pathCamera.SetPose(position, orientation); // Place the playback camera
+                viewMoved = frameCamera.Blend(pathCamera, pathCamera, 1.0f); // Draw from it
+            } else
+                viewMoved = frameCamera.Blend(snapshot.previousCamera, snapshot.camera, alpha); // Camera between the last two ticks
+            double drawnInput = snapshot.inputTime; // When the drawn camera's keys were read
+            float drawnAlpha = alpha; // How far the drawn camera is blended towards them
+            const glm::mat4& view = frameCamera.GetViewMatrix(); // Cached view
+            const glm::mat4& projection = frameCamera.GetProjectionMatrix(); // Cached projection
+            const glm::mat4& viewProjection = frameCamera.GetViewProjectionMatrix(); // Cached product
+            profiler.Begin("update"); // Time per-frame constants
+            frameRing.BeginFrame(); // Claim this frame's region of the ring buffer
+            objectConstants.Update(viewProjection, frameRing); // Compute MVP and normal matrices for every object
+
+            glm::vec3 eye = frameCamera.GetPosition(); // Interpolated camera position
+
+            // BIND TEXTURES HERE PROJECT 10
+            bakedLighting.Bind(); // Baked lighting table, values and atlas
+
+            // Per-frame constants, written once and read by every fragment stage
+            GLintptr frameOffset; // Offset in the ring buffer
+            FrameConstants* frameConstants = (FrameConstants*)frameRing.Allocate(sizeof(FrameConstants), frameOffset); // Reserve space
+            if (frameConstants) { // If allocated
+                frameConstants->lightPos = lightPos; // Pass light position
+                frameConstants->viewPos = eye; // Pass interpolated camera position
+                frameConstants->lightColor = glm::vec3(1.0f, 1.0f, 1.0f); // Pass white light color
+                profiler.Begin("light clusters"); // Time light binning
+                clusteredLights.Update(view, projection, resolution.RenderWidth(), resolution.RenderHeight(), frameCamera.GetNearPlane(), frameCamera.GetFarPlane(), frameRing, *frameConstants); // Bin point lights and bind their tables
+                profiler.End(); // End light clusters
+                profiler.Begin("shadows"); // Time shadow map updates
+                shadows.Update(lightPos, objectConstants, *frameConstants); // Rebuild the cache if stale and draw moving casters
+                profiler.End(); // End shadows
+                frameRing.BindRange(GL_UNIFORM_BUFFER, FRAME_CONSTANTS_BINDING, frameOffset, sizeof(FrameConstants)); // Bind to shader binding point
+            }
+            profiler.End(); // End update
+
+            // Queue every object that last frame's occlusion queries did not rule out; the queue decides the draw order
+            profiler.Begin("submit"); // Time queuing
+            renderQueue.Begin(); // Start frame
+            occlusion.BeginFrame(); // Collect occlusion results that have arrived
+            GLuint condition; // Pending occlusion query to render on
+
+            if (!gpuCulling) { // If the CPU submits the scene
+                entities.Each<Transform, MeshHandle, MaterialHandle>([&](Entity, const Transform& transform, const MeshHandle& mesh, const MaterialHandle& shading) {
+                    const glm::mat4& model = snapshot.models[transform.object]; // Model matrix from the snapshot
+                    if (occlusion.Test(transform.object, model, eye, condition) == OcclusionCuller::OCCLUDED) // If hidden
+                        return; // Skip entity
+                    float depth = RenderQueue::ViewDepth(view, model); // Distance to entity
+                    for (GLuint m = 0; m < mesh.count; m++) // Iterate over meshes
+                        renderQueue.Submit(shading.material, geometries[mesh.first + m], transform.object, depth, condition); // Queue mesh
+                });
+            }
+            profiler.End(); // End submit
+
+            // Late latch: everything above was recorded with the camera from the start of the frame. Just before the
+            // draws are issued, take the newest camera the simulation has published, blended for the time now, and
+            // write it over the MVPs and eye position already in this frame's mapped ring buffer region. Culling,
+            // sorting and light binning keep the earlier camera, which is at most a fraction of a tick away.
+            if (lateLatch && !benchmarkFile) { // If latching input
+                profiler.Begin("latch"); // Time the rewrite
+                cameraLatch.Acquire(); // Newest camera, if one arrived
+                const CameraLatch& latest = cameraLatch.Front(); // Its ticks
+                float latchAlpha = blendAlpha(headless ? headlessTime() : glfwGetTime(), latest.tickTime); // Fraction of a tick since it was due
+                if (frameCamera.Blend(latest.previousCamera, latest.camera, latchAlpha)) { // If it moved since the frame began
+                    objectConstants.Latch(frameCamera.GetViewProjectionMatrix(), frameRing); // Rewrite every MVP
+                    if (frameConstants) { // If the frame constants were written
+                        frameConstants->viewPos = frameCamera.GetPosition(); // Rewrite the eye
+                        frameRing.Flush(frameOffset, sizeof(FrameConstants)); // Upload again without a persistent mapping
+                    }
+                    viewMoved = true; // Measure this frame
+                    if (!latchChecked) { // If this is the first latch
+                        latchChecked = true; // Check once, the read back stalls
+                        if (!objectConstants.Latched(frameRing)) // If the draws would use the old matrices
+                            cout << "ERROR::LATCH::NOT_VISIBLE latched matrices did not reach the GPU" << endl; // Print error
+                        else
+                            cout << "Late latch: verified that the draws read the latched matrices" << endl; // Report
+                    }
+                }
+                drawnInput = latest.inputTime; // Keys behind the latched camera
+                drawnAlpha = latchAlpha;
+                profiler.End(); // End latch
+            }
 
-    // Game Loop
-    while (!glfwWindowShouldClose(window)) {
-        // Calculate deltaTime for camera movement
-        GLfloat currentFrame = glfwGetTime(); // Get current time
-        deltaTime = currentFrame - lastFrame; // Calculate change in time
-        lastFrame = currentFrame; // Set last frame to current frame
-
-        // Check for events
-        glfwPollEvents(); // Callback glfwPollEvents to check for events
-        do_movement(); // Callback do_movement()
-
-        glClearColor(0.0f, 0.0f, 0.0f, 0.0f); // Set background color
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT); // Clear buffers
-
-        
-        // Initialize Camera
-        glm::mat4 view = glm::mat4(1.0f); // Initialize view to identity
-        view = camera.GetViewMatrix(); // Set view based on camera
-        glm::mat4 projection = glm::perspective(45.0f, (GLfloat)WIDTH / (GLfloat)HEIGHT, 0.1f, 100.0f); // Initialize projection using initial values
-        glm::mat4 model = glm::mat4(1.0f); // Initialize model to be 4x4 identity
-
-        // BIND TEXTURES HERE PROJECT 10
-	
-	
-        // CHECKERBOARD
-        checkerboardShader.Use(); // Use checkerboard shader
-	
-        GLint squareColorLoc = glGetUniformLocation(checkerboardShader.Program, "squareColor"); // Retrieve uniform location for squareColor
-        GLint lightColorLoc = glGetUniformLocation(checkerboardShader.Program, "lightColor"); // Retrieve uniform location for lightColor
-        GLint lightPosLoc = glGetUniformLocation(checkerboardShader.Program, "lightPos"); // Retrieve uniform location for lightPos
-        GLint viewPosLoc = glGetUniformLocation(checkerboardShader.Program, "viewPos"); // Retrieve uniform location for viewPos
-	
-        glUniform3f(lightColorLoc, 1.0f, 1.0f, 1.0f); // Pass white color to lightColorLoc uniform
-        glUniform3f(lightPosLoc, lightPos.x, lightPos.y, lightPos.z); // Pass light position to lightPosLoc uniform
-        glUniform3f(viewPosLoc, camera.Position.x, camera.Position.y, camera.Position.z); // Pass camera position to viewPosLoc uniform
-
-        glm::mat4 view_square = view; // Create mat4 view_square equal to view generic defined above
-
-        GLint modelLoc = glGetUniformLocation(checkerboardShader.Program, "model"); // Retrieve model uniform location
-        GLint viewLoc = glGetUniformLocation(checkerboardShader.Program, "view"); // Retrieve view uniform location
-        GLint projLoc = glGetUniformLocation(checkerboardShader.Program, "projection"); // Retrieve projection uniform location
-
-        for (int i = 0; i < 8; i++) { // For 8 rows
-            for (int j = 0; j < 8; j++) { // For 8 columns
-                if ((i+j) % 2 == 0) { // Check if i+j is odd or even for color purposes
-                    glUniform3f(squareColorLoc, 1.0f, 0.0f, 1.0f); // If even square color is purple --> pass purple to uniform
-                } else {
-                    glUniform3f(squareColorLoc, 1.0f, 1.0f, 1.0f); // If even square color is white --> pas white to uniform
+            // With the depth pre-pass on the zone is named apart, so --profile reports both modes side by side
+            renderQueue.EnableDepthPrepass(depthPrepass.load()); // Apply --depth-prepass and Z
+            profiler.Begin(renderQueue.DepthPrepass() ? "draw (prepass)" : "draw"); // Time sorting and drawing; each material gets its own zone inside
+            renderQueue.Flush(); // Sort and draw
+            profiler.End(); // End draw
+            if (gpuCulling) { // If the GPU culls and submits the scene
+                profiler.Begin("gpu culling"); // Time dispatch and indirect draws
+                gpuCuller.Cull(frameCamera.GetFrustumPlanes()); // Write this frame's draw commands
+                gpuCuller.Draw(frameCamera.GetViewProjectionMatrix()); // One indirect draw per batch, with the latched camera
+                profiler.End(); // End gpu culling
+            }
+            profiler.Begin("occlusion"); // Time proxy queries
+            occlusion.IssueQueries(cubeGeometry); // Test bounding boxes against this frame's depth for next frame
+            profiler.End(); // End occlusion
+            profiler.Begin("upsample"); // Time the stretch to the window
+            resolution.End(); // Upsample to the window and adjust the scale
+            profiler.End(); // End upsample
+            frameRing.EndFrame(); // Fence this frame's region
+
+            profiler.Begin("swap"); // Time swap
+            if (headless) // If offscreen
+                headlessEndFrame(); // Finish frame for timing
+            else
+                glfwSwapBuffers(window); // Swap screen buffers
+            profiler.End(); // End swap
+
+            // Input latency: time from reading the keys to the swap, plus the part of a tick the blended camera
+            // still trails them by. Only frames whose camera moved are measured; with vsync the swap returns
+            // close to when the frame reaches the screen.
+            if (viewMoved) { // If the camera moved this frame
+                double swapTime = headless ? headlessTime() : glfwGetTime(); // Swap done
+                profiler.Record("input latency", (swapTime - drawnInput + (1.0 - drawnAlpha) * SIMULATION_STEP) * 1000.0); // In ms
+            }
+            if (benchmarkFile) { // If benchmarking
+                double swapTime = headless ? headlessTime() : glfwGetTime(); // Swap done
+                benchmarkTimes.push_back((swapTime - lastSwap) * 1000.0); // Frame time in ms
+                lastSwap = swapTime; // Next frame starts here
+                benchmarkFrame++; // Next tick of the path
+            }
+            profiler.EndFrame(); // Finish profiling this frame
+            if (framesLeft > 0) // If counting down to idle
+                framesLeft--; // One fewer to draw
+
+            // Report state changes issued and elided by the state cache, once per second
+            GLStateCache::FrameStats stateStats = state.EndFrame(); // This frame's counts
+            if (currentFrame - lastStatsReport >= 1.0f) { // If a second has passed
+                cout << "GL state changes: " << stateStats.issued << " issued, " << stateStats.elided << " elided" << endl; // Print counts
+                OcclusionCuller::FrameStats occlusionStats = occlusion.Stats(); // This frame's culling counts
+                if (gpuCulling) // If culling on the GPU
+                    cout << "GPU culling: " << gpuCuller.InstanceCount() << " instances in " << gpuCuller.BatchCount() << " batches" << endl; // Print counts
+                if (resolution.Enabled()) // If dynamic resolution is on
+                    cout << "Resolution: " << resolution.Scale() << " (" << resolution.RenderWidth() << "x" << resolution.RenderHeight() << "), GPU " << resolution.LastMilliseconds() << " ms" << endl; // Print scale
+                if (shadows.Enabled()) { // If shadows are on
+                    CachedShadowMap::FrameStats shadowStats = shadows.Stats(); // This frame's shadow counts
+                    cout << "Shadows: " << shadowStats.staticCasters << " cached casters, " << shadowStats.dynamicCasters << " dynamic, " << shadowStats.rebuilds << " cache builds, " << shadowStats.facesRestored << " faces restored, " << shadowStats.dynamicDraws << " dynamic draws" << endl; // Print counts
                 }
-                view_square = glm::translate(view_square, glm::vec3(j-4.0f, -0.5f, i-9.0f)); // Translate square to posiiton [setting x and z for grid]
-                view_square = glm::scale(view_square, glm::vec3(1.0f, 0.1f, 1.0f)); // Scale squares to be like tiles
-                glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model)); // Pass model to uniform
-                glUniformMatrix4fv(viewLoc, 1, GL_FALSE, glm::value_ptr(view_square)); // Pass view_square to uniform
-                glUniformMatrix4fv(projLoc, 1, GL_FALSE, glm::value_ptr(projection)); // Pass projection to uniform
-                // Draw square
-                glBindVertexArray(VAO); // Bind vertex arrays
-                glDrawArrays(GL_TRIANGLES, 0, 36); // Draw arrays for cube
-                view_square = view; // Reset view_square to original view identity [i.e. Translations are independent]
-                
+                if (clusteredLights.Count()) // If point lights are on
+                    cout << "Clustered lights: " << clusteredLights.Count() << " lights, " << clusteredLights.IndexCount() << " cluster entries" << endl; // Print counts
+                cout << "Occlusion: " << occlusionStats.drawn << " drawn, " << occlusionStats.culled << " culled, " << occlusionStats.conditional << " conditional, " << occlusionStats.queries << " queries" << endl; // Print counts
+                profiler.PrintStats(cout); // Print zone percentiles when profiling
+                lastStatsReport = currentFrame; // Remember report time
+            }
+        }
+        if (headless) // If offscreen
+            headlessMakeCurrent(false); // Hand the context back for cleanup
+        else
+            glfwMakeContextCurrent(nullptr); // Hand the context back for cleanup
+        renderDone.store(true); // Tell the simulation thread
+    });
+
+    // Simulation Loop
+    bool moving = true; // Camera or scene changed on the last tick
+    double inputTime = 0.0; // When the last tick read the keys
+    uint32_t recordedTicks = 0; // Ticks recorded with --record
+    while (!renderDone.load() && (headless || !glfwWindowShouldClose(window))) {
+        double now = headless ? headlessTime() : glfwGetTime(); // Get current time
+
+        // Move the camera in fixed ticks so its speed does not depend on the frame rate
+        int ticks; // Ticks due this frame
+        if (benchmarkFile) { // If drawn frames set the pace
+            std::lock_guard<std::mutex> lock(benchmarkMutex); // Lock counters
+            ticks = (int)(benchmarkWanted - benchmarkReady); // Ticks asked for and not simulated yet
+        } else
+            ticks = fixedStepAdvance(simulationClock, now); // Ticks due by wall time
+        bool changed = false; // Camera or scene changed on one of this frame's ticks
+        for (int t = 0; t < ticks; t++) { // Iterate over ticks
+            previousCamera = camera; // Keep state for interpolation
+            do_movement(); // Callback do_movement()
+            inputTime = now; // Keys were read now
+            if (recordFile) // If recording
+                recordedPath.Record(recordedTicks++, camera.GetPosition(), camera.GetOrientation()); // Pose after this tick
+            changed = changed || cameraMoved(previousCamera, camera); // Camera changed this tick
+            entities.Each<Transform, Velocity>([&](Entity, const Transform& transform, const Velocity& velocity) {
+                sceneGraph.SetPosition(transform.node, sceneGraph.Position(transform.node) + velocity.linear * (GLfloat)SIMULATION_STEP); // Move by one tick
+            });
+        }
+        const std::vector<GLuint>& moved = sceneGraph.Update(); // Propagate transforms touched this frame, none for a static scene
+        for (size_t n = 0; n < moved.size(); n++) { // Iterate over changed nodes
+            GLuint object = sceneGraph.Object(moved[n]); // Drawn object, if any
+            if (object == SceneGraph::NONE) // If a grouping node
+                continue;
+            sceneModels[object] = sceneGraph.World(moved[n]); // Copy model matrix
+            if (!isDynamic[object]) { // If it moved for the first time
+                isDynamic[object] = true; // Known dynamic
+                dynamicObjects.push_back(object); // Shadow map draws it every frame from now on
             }
         }
-	
-	
-        // CUBE
-        cubeShader.Use(); // Activate cube shader
-
-        // Set uniform locations
-        GLint cubeColorLoc = glGetUniformLocation(cubeShader.Program, "cubeColor"); // Retrieve uniform location
-        lightColorLoc = glGetUniformLocation(cubeShader.Program, "lightColor"); // Reset uniform location for cubeShader
-        lightPosLoc = glGetUniformLocation(cubeShader.Program, "lightPos"); // Reset uniform location for cubeShader
-        viewPosLoc = glGetUniformLocation(cubeShader.Program, "viewPos"); // Reset uniform location for cubeShader
-
-        // Pass to shaders
-        glUniform3f(cubeColorLoc, 1.0f, 0.0f, 0.0f); // Pass cube color to uniform
-        glUniform3f(lightColorLoc, 1.0f, 1.0f, 1.0f); // Pass light color to uniform
-        glUniform3f(lightPosLoc, lightPos.x, lightPos.y, lightPos.z); // Pass light position to uniform
-        glUniform3f(viewPosLoc, camera.Position.x, camera.Position.y, camera.Position.z); // Pass camera position to uniform
-
-        glm::mat4 view_cube = view; // Create mat4 view_cube equal to identity view
-        view_cube = glm::translate(view_cube, glm::vec3(0.0f, 0.0f, -5.0f)); // Translate cube back
-
-        // Get uniform location
-        modelLoc = glGetUniformLocation(cubeShader.Program, "model"); // Reset modelLoc using cubeShader
-        viewLoc = glGetUniformLocation(cubeShader.Program, "view"); // Reset viewLoc using cubeShader
-        projLoc = glGetUniformLocation(cubeShader.Program, "projection"); // Reset projLoc using cubeShader
-        // Pass locations to shader
-        glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model)); // Pass model to shader
-        glUniformMatrix4fv(viewLoc, 1, GL_FALSE, glm::value_ptr(view_cube)); // Pass view_cube to shader
-        glUniformMatrix4fv(projLoc, 1, GL_FALSE, glm::value_ptr(projection)); // Pass projection to shader
-        // Draw cube
-        glBindVertexArray(VAO); // Bind vertex arrays
-        glDrawArrays(GL_TRIANGLES, 0, 36); // Draw cube
-	
-	
-	
-        // SPHERE
-        sphereShader.Use(); // Activate sphereShader
-
-        GLint sphereColorLoc = glGetUniformLocation(sphereShader.Program, "sphereColor"); // Retrieve sphereColor location
-        lightColorLoc = glGetUniformLocation(sphereShader.Program, "lightColor"); // Reset lightColor location for sphereShader
-        lightPosLoc = glGetUniformLocation(sphereShader.Program, "lightPos"); // Reset lightPos location for sphereShader
-        viewPosLoc = glGetUniformLocation(sphereShader.Program, "viewPos"); // Reset viewPos location for sphereShader
-
-        glUniform3f(sphereColorLoc, 0.0f, 0.0f, 1.0f); // Pass in sphere color to uniform
-        glUniform3f(lightColorLoc, 1.0f, 1.0f, 1.0f); // Pass in light color to uniform
-        glUniform3f(lightPosLoc, lightPos.x, lightPos.y, lightPos.z); // Pass in light position to uniform
-        glUniform3f(viewPosLoc, camera.Position.x, camera.Position.y, camera.Position.z); // Pass in camera position to uniform
-
-        modelLoc = glGetUniformLocation(sphereShader.Program, "model"); // Reset model uniform location for sphereShader
-        viewLoc = glGetUniformLocation(sphereShader.Program, "view"); // Reset view uniform location for sphereShader
-        projLoc = glGetUniformLocation(sphereShader.Program, "projection"); // Reset projection uniform location for sphereShader
-
-        glm::mat4 view_sphere = view; // Create mat4 view_sphere equal to view identity
-        view_sphere = glm::translate(view_sphere, glm::vec3(1.2f, 0.0f, -5.0f)); // Translate sphere back and to the left
-        view_sphere = glm::scale(view_sphere, glm::vec3(0.5f, 0.5f, 0.5f)); // Scale down sphere
-        
-        glUniformMatrix4fv(viewLoc, 1, GL_FALSE, glm::value_ptr(view_sphere)); // Pass view_sphere to uniform
-        glUniformMatrix4fv(projLoc, 1, GL_FALSE, glm::value_ptr(projection)); // Pass projection to uniform
-        glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model)); // Pass model to uniform
-
-        sphereModel.Draw(sphereShader); // Draw sphere obj model
-	
-	
-        
-        // CYLINDER
-        cylinderShader.Use(); // Activate cylinder shader
-
-        GLint cylinderColorLoc = glGetUniformLocation(cylinderShader.Program, "cylinderColor"); // Retrieve cylinderColor location
-        lightColorLoc = glGetUniformLocation(cylinderShader.Program, "lightColor"); // Reset lightColor location
-        lightPosLoc = glGetUniformLocation(cylinderShader.Program, "lightPos"); // Reset lightPos location
-        viewPosLoc = glGetUniformLocation(cylinderShader.Program, "viewPos"); // Reset viewPos location
-
-        glUniform3f(cylinderColorLoc, 0.0f, 1.0f, 0.0f); // Pass color to uniform
-        glUniform3f(lightColorLoc, 1.0f, 1.0f, 1.0f); // Pass light color to uniform
-        glUniform3f(lightPosLoc, lightPos.x, lightPos.y, lightPos.z); // Pass light position to uniform
-        glUniform3f(viewPosLoc, camera.Position.x, camera.Position.y, camera.Position.z); // Pass camera position to uniform
-
-        modelLoc = glGetUniformLocation(cylinderShader.Program, "model"); // Reset view location for cylinderShader
-        viewLoc = glGetUniformLocation(cylinderShader.Program, "view"); // Reset view location for cylinderShader
-        projLoc = glGetUniformLocation(cylinderShader.Program, "projection"); // Reset view location for cylinderShader
-
-        glm::mat4 view_cylinder = view; // Create mat4 view_cylinder using generic view identity
-        view_cylinder = glm::translate(view_cylinder, glm::vec3(-1.7f, -3.0f, -5.0f)); // Translate cylinder back, to the right, and down
-        view_cylinder = glm::scale(view_cylinder, glm::vec3(0.5, 3.0, 0.5)); // Increase height of cylinder
-
-        glUniformMatrix4fv(viewLoc, 1, GL_FALSE, glm::value_ptr(view_cylinder)); // Pass view_cylinder to shader
-        glUniformMatrix4fv(projLoc, 1, GL_FALSE, glm::value_ptr(projection)); // Pass projection to shader
-        glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model)); // Pass moel to shader
-
-        cylinderModel.Draw(cylinderShader); // Draw obj model
-        
-
-        glBindVertexArray(0); // Bind zero at end
-        glfwSwapBuffers(window); // Swap screen buffers
+        if (ticks > 0) // If the state was stepped
+            moving = changed || !moved.empty(); // Remember whether anything moved
+        if (ticks > 0 && lateLatch) { // If the render thread latches the camera
+            CameraLatch& latch = cameraLatch.Back(); // Slot to fill
+            latch.previousCamera = previousCamera; // Camera before the last tick
+            latch.camera = camera; // Camera after the last tick
+            latch.tickTime = now - simulationClock.accumulator; // When the last tick was due
+            latch.inputTime = inputTime; // When it read the keys
+            cameraLatch.Publish(); // Hand to the render thread, ahead of the snapshot
+        }
+        if (ticks > 0 && (moving || !onDemand)) { // If the state changed
+            FrameSnapshot& next = snapshots.Back(); // Slot to fill
+            next.previousCamera = previousCamera; // Camera before the last tick
+            next.camera = camera; // Camera after the last tick
+            next.tickTime = now - simulationClock.accumulator; // When the last tick was due
+            next.inputTime = inputTime; // When it read the keys
+            next.models = sceneModels; // Model matrices, same size every time so no allocation
+            next.dynamicObjects = dynamicObjects; // Objects that have moved so far
+            snapshots.Publish(); // Hand to the render thread
+            requestRedraw(); // Wake the render thread
+        }
+        if (benchmarkFile && ticks > 0) { // If a frame asked for these ticks
+            std::lock_guard<std::mutex> lock(benchmarkMutex); // Lock counters
+            benchmarkReady += ticks; // Published
+            benchmarkWake.notify_all(); // Wake the render thread
+        }
+        if (windowDamaged) { // If the window needs repainting
+            windowDamaged = false; // Handled
+            requestRedraw(); // Draw the current state again
+        }
 
+        // Sleep until the next tick is due, waking early for input
+        double wait = SIMULATION_STEP - simulationClock.accumulator; // Seconds until the next tick
+        if (benchmarkFile) { // If the render thread sets the pace
+            if (!headless) // If windowed
+                glfwPollEvents(); // Keep the window responsive
+            std::unique_lock<std::mutex> lock(benchmarkMutex); // Lock counters
+            benchmarkWake.wait_for(lock, std::chrono::milliseconds(1), [&]() { return benchmarkWanted > benchmarkReady; }); // Until asked for a tick, looking at the window now and then
+        } else if (headless) // If offscreen
+            std::this_thread::sleep_for(std::chrono::duration<double>(wait)); // No events to wait for
+        else if (onDemand && !moving && !keyHeld()) { // If nothing will change until there is input
+            glfwWaitEvents(); // Block until input or a repaint request
+            fixedStepResume(simulationClock, glfwGetTime()); // Do not simulate the idle time
+        } else
+            glfwWaitEventsTimeout(wait); // Callback glfwWaitEventsTimeout to process events
+    }
+    quit.store(true); // Stop the render thread
+    requestRedraw(); // Wake it if it is idle
+    {
+        std::lock_guard<std::mutex> lock(benchmarkMutex); // Taken so the wake cannot slip past a waiting render thread
+        benchmarkWake.notify_all(); // Wake it if it waits for a benchmark tick
     }
+    renderThread.join(); // Wait for it to hand the context back
+    if (recordFile && recordedPath.Save(recordFile)) // If a path was recorded and saved
+        cout << "Camera path: " << recordedPath.TickCount() << " ticks, " << recordedPath.SampleCount() << " poses written to " << recordFile << endl; // Report
+    if (benchmarkFile) // If benchmarking
+        benchmarkReport(benchmarkFile, benchmarkTimes); // Print frame time statistics
+    if (headless) // If offscreen
+        headlessMakeCurrent(true); // Take EGL context back
+    else
+        glfwMakeContextCurrent(window); // Take window context back
+
     // Deallocate resources
-    glDeleteVertexArrays(1, &VAO); // Deallocate vertex arrays
     glDeleteBuffers(1, &VBO); // Deallocate buffers
+    glDeleteBuffers(1, &EBO); // Deallocate index buffer
+    glDeleteBuffers(1, &cubePositions); // Deallocate position stream
+    for (size_t m = 0; m < models.size(); m++) // Iterate over models
+        delete models[m]; // Deallocate model
+    bakedLighting.Release(); // Deallocate baked lighting while the context is current
+    if (headless) // If offscreen
+        return headlessFinish(); // Report frame times and exit
     glfwTerminate(); // Terminate window
     return 0; // Returns 0 for end of int main()
 
@@ -311,6 +811,10 @@ int main() {
 void key_callback(GLFWwindow* window, int key, int scancode, int action, int mode) {
     if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS) { // If ESC pressed
         glfwSetWindowShouldClose(window, GL_TRUE); // Close window
+    } if (key == GLFW_KEY_Z && action == GLFW_PRESS) { // If Z pressed
+        depthPrepass = !depthPrepass; // Toggle depth pre-pass
+        cout << "Depth pre-pass " << (depthPrepass ? "on" : "off") << endl; // Report mode
+        windowDamaged = true; // Redraw in the new mode
     } if (key >= 0 && key < 1024) { // Allow for 1024 key presses
         if (action == GLFW_PRESS) { // If pressed
             keys[key] = true; // Set keys[key] = true [key pressed]
@@ -320,6 +824,48 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
     }
 }
 
+// Method for window repaint requests
+void refresh_callback(GLFWwindow*) {
+    windowDamaged = true; // Redraw the current state
+}
+
+// Returns true while any key is held down
+bool keyHeld() {
+    for (int k = 0; k < 1024; k++) // Iterate over keys
+        if (keys[k]) // If held
+            return true;
+    return false;
+}
+
+// Returns true if the camera's view changed between two ticks
+bool cameraMoved(const Camera& before, const Camera& after) {
+    return before.GetPosition() != after.GetPosition() || before.GetOrientation() != after.GetOrientation(); // Compare view inputs
+}
+
+// Returns how far past a tick's due time now is, as a fraction of a tick. Never extrapolates.
+float blendAlpha(double now, double tickTime) {
+    float alpha = (float)((now - tickTime) / SIMULATION_STEP); // Fraction of a tick since it was due
+    return alpha < 0.0f ? 0.0f : (alpha > 1.0f ? 1.0f : alpha); // Clamp to the last two ticks
+}
+
+// Prints frame time statistics of a benchmark run
+void benchmarkReport(const char* path, const std::vector<double>& frameTimes) {
+    if (frameTimes.empty()) { // If no frames were drawn
+        cout << "Benchmark: no frames drawn from " << path << endl; // Report
+        return;
+    }
+    std::vector<double> sorted(frameTimes); // Copy
+    std::sort(sorted.begin(), sorted.end()); // Order
+    double total = 0.0; // Sum
+    for (size_t i = 0; i < sorted.size(); i++) // Iterate over frames
+        total += sorted[i]; // Accumulate
+    size_t n = sorted.size() - 1; // Last rank
+    cout << std::fixed << std::setprecision(3); // Milliseconds with microsecond digits
+    cout << "Benchmark: " << path << ", " << sorted.size() << " frames in " << total << " ms, mean " << total / sorted.size() << " ms, p50 " << sorted[n / 2]
+         << " ms, p95 " << sorted[n * 95 / 100] << " ms, p99 " << sorted[n * 99 / 100] << " ms, max " << sorted[n] << " ms" << endl; // Report
+    cout.unsetf(std::ios::floatfield); // Restore float format
+}
+
 // Initiates movement based on keyboard input
 void do_movement() {
     if (keys[GLFW_KEY_LEFT_SHIFT] || keys[GLFW_KEY_RIGHT_SHIFT]) { // If either shift keys are pressed
@@ -0,0 +1,6 @@
+#version 430 core
+// Bounding box proxies only count samples; color and depth writes are masked off while they draw
+layout(early_fragment_tests) in; // Test depth before the (empty) shader runs
+
+void main() {
+}
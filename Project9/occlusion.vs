@@ -0,0 +1,21 @@
+#version 430 core
+layout (location = 0) in vec3 aPos; // Receives aPos of a unit cube centered on the origin
+out gl_PerVertex { vec4 gl_Position; }; // Redeclared for separable programs
+
+// Per-object constants computed once per frame on the CPU (ObjectConstants.h)
+struct ObjectConstants {
+    mat4 mvp; // projection * view * model
+    mat4 model; // model
+    mat4 normalMatrix; // transpose(inverse(model)) in the upper 3x3
+};
+layout (std430, binding = 0) readonly buffer ObjectBuffer {
+    ObjectConstants objects[]; // One entry per object
+};
+uniform uint objectIndex; // Receives index of the object being tested
+uniform vec3 boundsMin; // Receives object-space bounding box minimum
+uniform vec3 boundsMax; // Receives object-space bounding box maximum
+
+void main() {
+    vec3 corner = mix(boundsMin, boundsMax, aPos + 0.5); // Stretch the unit cube over the bounding box
+    gl_Position = objects[objectIndex].mvp * vec4(corner, 1.0);  // Implements transformations with precomputed MVP
+}
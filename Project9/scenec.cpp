@@ -0,0 +1,224 @@
+// Scene compiler: turns a text .scene source into the binary format SceneFile.h maps in place
+//
+//   g++ -std=c++11 scenec.cpp -o scenec
+//   ./scenec default.scene default.p9scene
+//
+// Source format, one statement per line, # starts a comment:
+//   light X Y Z
+//   mesh NAME PATH                                   PATH "cube" is the built-in unit cube
+//   material NAME SHADER R G B [blended]
+//   group NAME PARENT [position X Y Z] [rotate DEGREES AX AY AZ] [scale X Y Z]
+//   object NAME PARENT MESH MATERIAL [position X Y Z] [rotate DEGREES AX AY AZ] [scale X Y Z] [velocity X Y Z]
+// PARENT is an earlier group or object, or - for a root. Names are only used while compiling.
+
+#include <cmath> // cmath include
+#include <cstdio> // cstdio include
+#include <fstream> // fstream include
+#include <iostream> // iostream include
+#include <map> // map include
+#include <sstream> // sstream include
+#include <string> // string include
+#include <vector> // vector include
+
+#include "SceneFile.h" // Include scene file format
+
+using namespace std; // Use namespace std
+
+// Everything read from the source
+struct SceneSource {
+    float lightPos[3]; // Light position
+    vector<SceneFileMesh> meshes; // Mesh table
+    vector<SceneFileMaterial> materials; // Material table
+    vector<SceneFileObject> objects; // Object table
+    string strings; // String table
+    map<string, uint32_t> meshNames, materialNames, objectNames; // Name lookups
+    map<string, uint32_t> stringOffsets; // Deduplicated strings
+};
+
+// Adds a string to the table once and returns its offset
+uint32_t addString(SceneSource& scene, const string& text) {
+    map<string, uint32_t>::iterator it = scene.stringOffsets.find(text); // Look up
+    if (it != scene.stringOffsets.end()) // If already stored
+        return it->second; // Reuse
+    uint32_t offset = (uint32_t)scene.strings.size(); // Next offset
+    scene.strings += text; // Append text
+    scene.strings += '\0'; // Terminate
+    scene.stringOffsets[text] = offset; // Remember
+    return offset; // Return offset
+}
+
+// Prints a source error with its line number
+bool fail(const string& path, int line, const string& message) {
+    cout << "ERROR::SCENEC::" << path << ":" << line << ": " << message << endl; // Print error
+    return false;
+}
+
+// Looks up a name, printing an error if it is missing
+bool lookup(const map<string, uint32_t>& names, const string& name, uint32_t& index, const string& path, int line, const string& kind) {
+    map<string, uint32_t>::const_iterator it = names.find(name); // Look up
+    if (it == names.end()) // If unknown
+        return fail(path, line, "unknown " + kind + " " + name);
+    index = it->second; // Found
+    return true;
+}
+
+// Reads the optional position/rotate/scale clauses of a group or object, and velocity for an object
+bool readTransform(istringstream& in, SceneFileObject& object, const string& path, int line) {
+    object.position[0] = object.position[1] = object.position[2] = 0.0f; // Origin
+    object.rotation[0] = object.rotation[1] = object.rotation[2] = 0.0f; // No rotation
+    object.rotation[3] = 1.0f; // No rotation
+    object.scale[0] = object.scale[1] = object.scale[2] = 1.0f; // Unit scale
+    object.velocity[0] = object.velocity[1] = object.velocity[2] = 0.0f; // Static
+    string clause; // Clause keyword
+    while (in >> clause) { // Until end of line
+        if (clause == "position") { // Translation
+            if (!(in >> object.position[0] >> object.position[1] >> object.position[2]))
+                return fail(path, line, "position needs X Y Z");
+        } else if (clause == "scale") { // Scale
+            if (!(in >> object.scale[0] >> object.scale[1] >> object.scale[2]))
+                return fail(path, line, "scale needs X Y Z");
+        } else if (clause == "velocity") { // Constant motion
+            if (object.mesh == SCENE_FILE_NONE)
+                return fail(path, line, "velocity is only allowed on objects");
+            if (!(in >> object.velocity[0] >> object.velocity[1] >> object.velocity[2]))
+                return fail(path, line, "velocity needs X Y Z");
+        } else if (clause == "rotate") { // Rotation about an axis
+            float degrees, x, y, z; // Angle and axis
+            if (!(in >> degrees >> x >> y >> z))
+                return fail(path, line, "rotate needs DEGREES AX AY AZ");
+            float length = sqrt(x * x + y * y + z * z); // Axis length
+            if (length == 0.0f)
+                return fail(path, line, "rotate axis is zero");
+            float half = degrees * 3.14159265f / 360.0f; // Half angle in radians
+            float s = sin(half) / length; // Scaled sine
+            object.rotation[0] = x * s; // Quaternion x
+            object.rotation[1] = y * s; // Quaternion y
+            object.rotation[2] = z * s; // Quaternion z
+            object.rotation[3] = cos(half); // Quaternion w
+        } else {
+            return fail(path, line, "unknown clause " + clause);
+        }
+    }
+    return true;
+}
+
+// Parses a .scene source
+bool parse(const string& path, SceneSource& scene) {
+    ifstream file(path.c_str()); // Source file
+    if (!file) {
+        cout << "ERROR::SCENEC::FILE_NOT_READ " << path << endl; // Print error
+        return false;
+    }
+    scene.lightPos[0] = 1.0f; scene.lightPos[1] = 1.0f; scene.lightPos[2] = -2.0f; // Default light
+    string text; // Line text
+    int line = 0; // Line number
+    while (getline(file, text)) { // Iterate over lines
+        line++;
+        size_t hash = text.find('#'); // Comment start
+        if (hash != string::npos)
+            text.erase(hash); // Drop comment
+        istringstream in(text); // Line tokens
+        string keyword; // Statement
+        if (!(in >> keyword)) // If blank
+            continue;
+        if (keyword == "light") { // Light position
+            if (!(in >> scene.lightPos[0] >> scene.lightPos[1] >> scene.lightPos[2]))
+                return fail(path, line, "light needs X Y Z");
+        } else if (keyword == "mesh") { // Mesh source
+            string name, source; // Name and path
+            if (!(in >> name >> source))
+                return fail(path, line, "mesh needs NAME PATH");
+            SceneFileMesh mesh = { addString(scene, source) }; // Record
+            scene.meshNames[name] = (uint32_t)scene.meshes.size(); // Remember name
+            scene.meshes.push_back(mesh); // Store
+        } else if (keyword == "material") { // Material
+            string name, shader, flag; // Fields
+            SceneFileMaterial material; // Record
+            if (!(in >> name >> shader >> material.color[0] >> material.color[1] >> material.color[2]))
+                return fail(path, line, "material needs NAME SHADER R G B");
+            material.blended = (in >> flag && flag == "blended") ? 1 : 0; // Optional flag
+            material.name = addString(scene, name); // Name
+            material.shader = addString(scene, shader); // Shader family
+            scene.materialNames[name] = (uint32_t)scene.materials.size(); // Remember name
+            scene.materials.push_back(material); // Store
+        } else if (keyword == "group" || keyword == "object") { // Scene graph node
+            string name, parent; // Names
+            SceneFileObject object; // Record
+            if (!(in >> name >> parent))
+                return fail(path, line, keyword + " needs NAME PARENT");
+            object.parent = SCENE_FILE_NONE; // Root unless named
+            if (parent != "-" && !lookup(scene.objectNames, parent, object.parent, path, line, "parent"))
+                return false;
+            object.mesh = SCENE_FILE_NONE; // Group unless a mesh is given
+            object.material = SCENE_FILE_NONE; // No material
+            if (keyword == "object") { // If drawn
+                string mesh, material; // Names
+                if (!(in >> mesh >> material))
+                    return fail(path, line, "object needs NAME PARENT MESH MATERIAL");
+                if (!lookup(scene.meshNames, mesh, object.mesh, path, line, "mesh") ||
+                    !lookup(scene.materialNames, material, object.material, path, line, "material"))
+                    return false;
+            }
+            if (!readTransform(in, object, path, line))
+                return false;
+            scene.objectNames[name] = (uint32_t)scene.objects.size(); // Remember name
+            scene.objects.push_back(object); // Store
+        } else {
+            return fail(path, line, "unknown statement " + keyword);
+        }
+    }
+    return true;
+}
+
+// Rounds up to a multiple of 4
+uint32_t align4(uint32_t offset) {
+    return (offset + 3) & ~3u;
+}
+
+// Writes the binary scene
+bool write(const string& path, const SceneSource& scene) {
+    SceneFileHeader header; // Header
+    memset(&header, 0, sizeof(header)); // Clear
+    memcpy(header.magic, SCENE_FILE_MAGIC, 4); // Magic
+    header.version = SCENE_FILE_VERSION; // Version
+    for (int c = 0; c < 3; c++) header.lightPos[c] = scene.lightPos[c]; // Light
+    uint32_t offset = sizeof(SceneFileHeader); // Tables follow the header
+    header.meshCount = (uint32_t)scene.meshes.size(); // Meshes
+    header.meshOffset = offset;
+    offset += header.meshCount * sizeof(SceneFileMesh);
+    header.materialCount = (uint32_t)scene.materials.size(); // Materials
+    header.materialOffset = offset;
+    offset += header.materialCount * sizeof(SceneFileMaterial);
+    header.objectCount = (uint32_t)scene.objects.size(); // Objects
+    header.objectOffset = offset;
+    offset += header.objectCount * sizeof(SceneFileObject);
+    header.stringsSize = align4((uint32_t)scene.strings.size() + 1); // Strings padded with NULs, never empty
+    header.stringsOffset = offset;
+    header.fileSize = offset + header.stringsSize; // End of the string table
+
+    vector<char> bytes(header.fileSize, 0); // Whole file
+    memcpy(&bytes[0], &header, sizeof(header)); // Header
+    if (header.meshCount) memcpy(&bytes[header.meshOffset], &scene.meshes[0], header.meshCount * sizeof(SceneFileMesh)); // Meshes
+    if (header.materialCount) memcpy(&bytes[header.materialOffset], &scene.materials[0], header.materialCount * sizeof(SceneFileMaterial)); // Materials
+    if (header.objectCount) memcpy(&bytes[header.objectOffset], &scene.objects[0], header.objectCount * sizeof(SceneFileObject)); // Objects
+    if (!scene.strings.empty()) memcpy(&bytes[header.stringsOffset], scene.strings.data(), scene.strings.size()); // Strings
+
+    ofstream file(path.c_str(), ios::binary); // Output file
+    if (!file.write(&bytes[0], bytes.size())) {
+        cout << "ERROR::SCENEC::FILE_NOT_WRITTEN " << path << endl; // Print error
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    if (argc != 3) { // If misused
+        cout << "usage: scenec input.scene output.p9scene" << endl; // Print usage
+        return 1;
+    }
+    SceneSource scene; // Parsed source
+    if (!parse(argv[1], scene) || !write(argv[2], scene)) // If either step failed
+        return 1;
+    cout << argv[2] << ": " << scene.meshes.size() << " meshes, " << scene.materials.size() << " materials, " << scene.objects.size() << " objects" << endl; // Report
+    return 0;
+}
@@ -6,68 +6,27 @@
 #include <fstream> // Include fstream
 #include <sstream> // Include sstream
 #include <iostream> // Include iostream
+#include <map> // Include map
 
 #include <GL/glew.h> // Include glew
+#include <glm/glm.hpp> // Include glm
+#include <glm/gtc/type_ptr.hpp> // Include glm type_ptr
+
+#include "shaders_embedded.h" // Shaders embedded at build time by embed_shaders.sh
+#include "GLState.h" // Include GL state cache
 
 using namespace std; // Use namespace std
 
 class Shader {
 public:
-    GLuint Program; // Initialize GLuint 
-    Shader(const GLchar* vertexPath, const GLchar* fragmentPath) { // Shader constructor
-        // Retrieve vertex/fragment code from path
-        string vertexCode; // Initialize vertexCode string
-        string fragmentCode; // Initialize fragmentCode string
-        ifstream vShaderFile; // Initialize file for vertex shader
-        ifstream fShaderFile; // Initialize file for fragment shader
-        // Allows for exceptions
-        vShaderFile.exceptions(ifstream::badbit); // Allow vs file exception
-        fShaderFile.exceptions(ifstream::badbit); // Allow frag file exception
-        // Read Shaders
-        try {
-            // Open Files
-            vShaderFile.open(vertexPath); // Try opening .vs using path
-            fShaderFile.open(fragmentPath); // Try opening .frag using path
-            stringstream vShaderStream, fShaderStream; // Initalize stringstream for both
-            // Read file's buffer contents into streams
-            vShaderStream << vShaderFile.rdbuf(); // Read in .vs
-            fShaderStream << fShaderFile.rdbuf(); // Read in .frag
-            // Close file handlers
-            vShaderFile.close(); // Close .vs file
-            fShaderFile.close(); // Close .frag file
-            // Convert stream into string
-            vertexCode = vShaderStream.str(); // Convert and store contents of .vs as string
-            fragmentCode = fShaderStream.str(); // Convert and store contents of .frag as string
-        }
-        catch (ifstream::failure e) {
-            cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ" << endl; // Error message if catch
-        }
-        // Compilation
-        const GLchar* vShaderCode = vertexCode.c_str(); // Initialize GLchar* for vs
-        const GLchar* fShaderCode = fragmentCode.c_str(); // Initalize GLchar* for frag
-        GLuint vertex, fragment; // Initalize GLuint for vs and frag
+    GLuint Program; // Initialize GLuint
+    // Shader constructor. Shaders embedded by embed_shaders.sh are used directly; anything else is read from disk.
+    Shader(const GLchar* vertexPath, const GLchar* fragmentPath) {
         GLint success; // Initalize GLint for success
         GLchar infoLog[512]; // Initialize infoLog
-        // Vertex Shader
-        vertex = glCreateShader(GL_VERTEX_SHADER); // Set vertex = shader
-        glShaderSource(vertex, 1, &vShaderCode, NULL); // Get source
-        glCompileShader(vertex); // Compile vertex shader
-        // Print compile errors if necessary
-        glGetShaderiv(vertex, GL_COMPILE_STATUS, &success); // Get status
-        if (!success) { // If failure
-            glGetShaderInfoLog(vertex, 512, NULL, infoLog); // Get info on failure
-            cout << "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n" << infoLog << endl; // Print error message if catch
-        }
-        // Fragment Shader
-        fragment = glCreateShader(GL_FRAGMENT_SHADER); // Initalize gragment as shader
-        glShaderSource(fragment, 1, &fShaderCode, NULL); // Get source
-        glCompileShader(fragment); // Compile fragment shader
-        // Print compile errors if necessary
-        glGetShaderiv(fragment, GL_COMPILE_STATUS, &success); // Get status
-        if (!success) { // If failure
-            glGetShaderInfoLog(fragment, 512, NULL, infoLog); // Get info on failure
-            cout << "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED\n" << infoLog << endl; // Print error message if catch
-        }
+        // Compile each stage
+        GLuint vertex = CompileStage(GL_VERTEX_SHADER, vertexPath); // Compile vertex shader
+        GLuint fragment = CompileStage(GL_FRAGMENT_SHADER, fragmentPath); // Compile fragment shader
         // Linking Shader Program
         this->Program = glCreateProgram(); // Set program to createProgram output
         glAttachShader(this->Program, vertex); // Attach vertex shader
@@ -85,6 +44,210 @@ public:
     }
     // Uses the current shader
     void Use() {
-        glUseProgram(this->Program); // Use program with shaders from method above
+        GLStateCache::Get().UseProgram(this->Program); // Use program with shaders from method above
+    }
+
+    // Returns the source for a shader, from the embedded table if present or else from disk
+    static string ReadSource(const GLchar* path) {
+        const EmbeddedShader* embedded = FindEmbeddedShader(path); // Look for embedded copy
+        if (embedded) // If embedded
+            return embedded->source; // Use embedded source
+        string code; // Initialize code string
+        ifstream shaderFile; // Initialize file for shader
+        shaderFile.exceptions(ifstream::badbit); // Allow file exception
+        try {
+            shaderFile.open(path); // Try opening file using path
+            stringstream shaderStream; // Initalize stringstream
+            shaderStream << shaderFile.rdbuf(); // Read file's buffer contents into stream
+            shaderFile.close(); // Close file handler
+            code = shaderStream.str(); // Convert stream into string
+        }
+        catch (ifstream::failure e) {
+            cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ" << endl; // Error message if catch
+        }
+        return code; // Return source
+    }
+
+    // Compiles one stage, preferring embedded SPIR-V, then embedded GLSL, then the file on disk
+    static GLuint CompileStage(GLenum type, const GLchar* path) {
+        GLint success; // Initalize GLint for success
+        GLchar infoLog[512]; // Initialize infoLog
+        const char* stageName = (type == GL_VERTEX_SHADER) ? "VERTEX" : (type == GL_COMPUTE_SHADER) ? "COMPUTE" : "FRAGMENT"; // Stage name for errors
+        GLuint shader = glCreateShader(type); // Create shader object
+        const EmbeddedShader* embedded = FindEmbeddedShader(path); // Look for embedded copy
+
+        // SPIR-V path skips the GLSL front-end entirely
+        if (embedded && embedded->spirv && GLEW_ARB_gl_spirv) { // If binary available and supported
+            glShaderBinary(1, &shader, GL_SHADER_BINARY_FORMAT_SPIR_V_ARB, embedded->spirv, (GLsizei)embedded->spirvSize); // Upload binary
+            glSpecializeShaderARB(shader, "main", 0, NULL, NULL); // Specialize entry point
+            glGetShaderiv(shader, GL_COMPILE_STATUS, &success); // Get status
+            if (success) // If specialization succeeded
+                return shader; // Done
+            glDeleteShader(shader); // Discard failed binary
+            shader = glCreateShader(type); // Fall back to GLSL
+        }
+
+        // Compilation
+        string code = ReadSource(path); // Retrieve code from the embedded table or from the path
+        const GLchar* shaderCode = code.c_str(); // Initialize GLchar* for source
+        glShaderSource(shader, 1, &shaderCode, NULL); // Get source
+        glCompileShader(shader); // Compile shader
+        // Print compile errors if necessary
+        glGetShaderiv(shader, GL_COMPILE_STATUS, &success); // Get status
+        if (!success) { // If failure
+            glGetShaderInfoLog(shader, 512, NULL, infoLog); // Get info on failure
+            cout << "ERROR::SHADER::" << stageName << "::COMPILATION_FAILED\n" << infoLog << endl; // Print error message if catch
+        }
+        return shader; // Return compiled shader
+    }
+};
+
+// Separable single-stage programs (GL_ARB_separate_shader_objects). Each unique stage is compiled and linked
+// once and shared by every pipeline that uses it, so cube.vs, sphere.vs and checkerboard.vs become one program.
+class ShaderStage {
+public:
+    // Returns the separable program for a stage, compiling it only the first time its source is seen
+    static GLuint Get(GLenum type, const GLchar* path) {
+        string key = stageKey(type, Shader::ReadSource(path)); // Key on the code itself, not the file name
+        map<string, GLuint>& cache = stageCache(); // Stage cache
+        map<string, GLuint>::iterator it = cache.find(key); // Look up stage
+        if (it != cache.end()) // If already compiled
+            return it->second; // Share it
+
+        GLint success; // Initalize GLint for success
+        GLchar infoLog[512]; // Initialize infoLog
+        GLuint shader = Shader::CompileStage(type, path); // Compile stage
+        GLuint program = glCreateProgram(); // Create program for the stage
+        glProgramParameteri(program, GL_PROGRAM_SEPARABLE, GL_TRUE); // Mark separable before linking
+        glAttachShader(program, shader); // Attach stage
+        glLinkProgram(program); // Link program
+        glGetProgramiv(program, GL_LINK_STATUS, &success); // Get linking status
+        if (!success) { // If failure
+            glGetProgramInfoLog(program, 512, NULL, infoLog); // Get info on failure
+            cout << "ERROR::SHADER::STAGE::LINKING_FAILED\n" << infoLog << endl; // Print error message
+        }
+        glDetachShader(program, shader); // Detach stage
+        glDeleteShader(shader); // Delete stage shader
+        cache[key] = program; // Remember stage
+        return program; // Return separable program
+    }
+
+    // Number of unique stages compiled so far
+    static size_t Count() {
+        return stageCache().size(); // Size of cache
+    }
+
+private:
+    // Cache of stage programs keyed by stage type and source
+    static map<string, GLuint>& stageCache() {
+        static map<string, GLuint> cache; // Shared cache
+        return cache; // Return cache
+    }
+
+    // Builds a cache key from the stage type and its source. Comments count as whitespace and every run of
+    // whitespace becomes one space, or one newline if it spans lines, so only edits that cannot change the
+    // compiled stage share a key; tokens stay apart and preprocessor lines stay lines.
+    static string stageKey(GLenum type, const string& code) {
+        string key = to_string(type) + ":"; // Start with stage type
+        size_t start = key.size(); // Where the source begins, leading whitespace is dropped
+        bool space = false, newline = false; // Whitespace run pending, and whether it spans lines
+        for (size_t i = 0; i < code.size(); i++) { // Iterate over source
+            if (code[i] == '/' && i + 1 < code.size() && code[i + 1] == '/') { // If line comment
+                while (i + 1 < code.size() && code[i + 1] != '\n') // Skip to end of line, keeping the newline
+                    i++;
+                space = true; // Comment separates tokens
+            } else if (code[i] == '/' && i + 1 < code.size() && code[i + 1] == '*') { // If block comment
+                size_t end = code.find("*/", i + 2); // Comment end
+                end = end == string::npos ? code.size() : end + 2; // Unterminated runs to the end
+                newline = newline || code.find('\n', i) < end; // Spans lines
+                i = end - 1; // Skip comment
+                space = true; // Comment separates tokens
+            } else if (isspace((unsigned char)code[i])) { // If whitespace
+                newline = newline || code[i] == '\n'; // Spans lines
+                space = true; // Pending separator
+            } else {
+                if (space && key.size() > start) // If separated from the previous token
+                    key += newline ? '\n' : ' '; // One separator for the run
+                space = newline = false; // Run written
+                key += code[i]; // Keep character
+            }
+        }
+        return key; // Return key
+    }
+};
+
+// Vertex and fragment stages combined through a program pipeline object. Falls back to a monolithic
+// program when GL_ARB_separate_shader_objects is not available.
+class ShaderPipeline {
+public:
+    GLuint Pipeline; // Program pipeline object, 0 when monolithic
+    GLuint VertexProgram; // Separable vertex program
+    GLuint FragmentProgram; // Separable fragment program
+    GLuint Program; // Program that receives plain glUniform* calls (fragment stage or monolithic program)
+
+    // Pipeline constructor
+    ShaderPipeline(const GLchar* vertexPath, const GLchar* fragmentPath) : Pipeline(0) {
+        if (!GLEW_ARB_separate_shader_objects) { // If separable programs unsupported
+            this->Program = Shader(vertexPath, fragmentPath).Program; // Link monolithic program
+            this->VertexProgram = this->Program; // Both stages live in one program
+            this->FragmentProgram = this->Program; // Both stages live in one program
+            return;
+        }
+        this->VertexProgram = ShaderStage::Get(GL_VERTEX_SHADER, vertexPath); // Shared vertex stage
+        this->FragmentProgram = ShaderStage::Get(GL_FRAGMENT_SHADER, fragmentPath); // Shared fragment stage
+        this->Program = this->FragmentProgram; // Material uniforms live in the fragment stage
+        glGenProgramPipelines(1, &this->Pipeline); // Create pipeline
+        glUseProgramStages(this->Pipeline, GL_VERTEX_SHADER_BIT, this->VertexProgram); // Attach vertex stage
+        glUseProgramStages(this->Pipeline, GL_FRAGMENT_SHADER_BIT, this->FragmentProgram); // Attach fragment stage
+    }
+
+    // Uses the pipeline
+    void Use() {
+        GLStateCache& state = GLStateCache::Get(); // State cache
+        if (this->Pipeline == 0) { // If monolithic
+            state.UseProgram(this->Program); // Use program
+            return;
+        }
+        state.UseProgram(0); // Pipelines only apply with no program bound
+        state.BindProgramPipeline(this->Pipeline); // Bind pipeline
+        glActiveShaderProgram(this->Pipeline, this->Program); // Route glUniform* calls to the fragment stage
+    }
+
+    // Sets a uint uniform in whichever stage declares it
+    void SetUint(const GLchar* name, GLuint value) {
+        setStages(name, [&](GLuint program, GLint loc) { glProgramUniform1ui(program, loc, value); }); // Set on stages
+    }
+
+    // Sets a vec3 uniform in whichever stage declares it
+    void SetVec3(const GLchar* name, const glm::vec3& value) {
+        setStages(name, [&](GLuint program, GLint loc) { glProgramUniform3fv(program, loc, 1, glm::value_ptr(value)); }); // Set on stages
+    }
+
+    // Sets a vec4 uniform in whichever stage declares it
+    void SetVec4(const GLchar* name, const glm::vec4& value) {
+        setStages(name, [&](GLuint program, GLint loc) { glProgramUniform4fv(program, loc, 1, glm::value_ptr(value)); }); // Set on stages
+    }
+
+    // Sets a mat4 uniform in whichever stage declares it
+    void SetMat4(const GLchar* name, const glm::mat4& value) {
+        setStages(name, [&](GLuint program, GLint loc) { glProgramUniformMatrix4fv(program, loc, 1, GL_FALSE, glm::value_ptr(value)); }); // Set on stages
+    }
+
+private:
+    map<string, pair<GLint, GLint> > locations; // Vertex and fragment stage location per uniform name
+
+    // Applies a uniform setter to every stage that declares the uniform
+    template <typename Setter>
+    void setStages(const GLchar* name, Setter set) {
+        map<string, pair<GLint, GLint> >::iterator it = this->locations.find(name); // Look up cached locations
+        if (it == this->locations.end()) { // If first use of this name
+            GLint vertexLoc = glGetUniformLocation(this->VertexProgram, name); // Look up in vertex stage
+            GLint fragmentLoc = (this->FragmentProgram == this->VertexProgram) ? -1 : glGetUniformLocation(this->FragmentProgram, name); // Look up in fragment stage
+            it = this->locations.insert(make_pair(string(name), make_pair(vertexLoc, fragmentLoc))).first; // Cache locations
+        }
+        if (it->second.first >= 0) // If declared in vertex stage
+            set(this->VertexProgram, it->second.first); // Set it
+        if (it->second.second >= 0) // If declared in fragment stage
+            set(this->FragmentProgram, it->second.second); // Set it
     }
 };
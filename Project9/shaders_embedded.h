@@ -0,0 +1,584 @@
+// Generated by embed_shaders.sh - do not edit
+#pragma once
+
+#include <cstddef> // Include cstddef
+#include <cstring> // Include cstring
+
+#define EMBEDDED_SHADERS_HAVE_SPIRV 0 // Non-zero when SPIR-V binaries are embedded
+
+static const char checkerboard_vs_source[] = R"glsl(
+#version 430 core
+layout (location = 0) in vec3 aPos; // aPos layout for loc 0
+layout (location = 1) in vec3 aNormal; // aNormal layout for loc 1
+layout (location = 2) in vec2 aTexCoords; // Receives aTexCoords, used to find lightmap texels
+
+out vec3 FragPos; // Returns FragPos
+out vec3 Normal; // Returns Normal
+flat out vec4 BakedFace; // Lightmap face: texel corner in the atlas, texels across, kind of bake
+out vec2 BakedData; // Texel within the lightmap face, or the vertex's baked values
+out gl_PerVertex { vec4 gl_Position; }; // Redeclared for separable programs
+invariant gl_Position; // Same depth as the depth pre-pass, so GL_EQUAL matches
+
+// Per-object constants computed once per frame on the CPU (ObjectConstants.h)
+struct ObjectConstants {
+    mat4 mvp; // projection * view * model
+    mat4 model; // model
+    mat4 normalMatrix; // transpose(inverse(model)) in the upper 3x3
+};
+layout (std430, binding = 0) readonly buffer ObjectBuffer {
+    ObjectConstants objects[]; // One entry per object
+};
+uniform uint objectIndex; // Receives index of the object being drawn
+
+// Baked lighting traced offline by lightbake [BakedLighting.h]
+layout (binding = 6) uniform usamplerBuffer bakedObjects; // Kind, placement and face size per object
+layout (binding = 7) uniform samplerBuffer bakedVertices; // Ambient occlusion and key light visibility per vertex
+
+void main() {
+    gl_Position = objects[objectIndex].mvp * vec4(aPos, 1.0f);  // Implements transformations with precomputed MVP
+    FragPos = vec3(objects[objectIndex].model * vec4(aPos, 1.0));  // Sets fragment position
+    Normal = mat3(objects[objectIndex].normalMatrix) * aNormal;  // Transforms normal with precomputed normal matrix
+    uvec4 baked = texelFetch(bakedObjects, int(objectIndex)); // This object's bake
+    BakedFace = vec4(0.0); // Not baked
+    BakedData = vec2(0.0);
+    if (baked.x == 1u) { // If lightmapped, the built-in cube with six vertices per face
+        uint face = uint(gl_VertexID) / 6u; // Face, tiles are 3x2 faces
+        BakedFace = vec4(float(baked.y + (face % 3u) * baked.w), float(baked.z + (face / 3u) * baked.w), float(baked.w), 1.0); // Face's corner texel
+        BakedData = aTexCoords * float(baked.w); // Position on the face in texels
+    } else if (baked.x == 2u) { // If baked per vertex
+        BakedFace.w = 2.0; // Values come with the vertex
+        BakedData = texelFetch(bakedVertices, int(baked.y) + gl_VertexID).rg; // Vertex values
+    }
+}
+)glsl";
+
+static const char cube_vs_source[] = R"glsl(
+#version 430 core
+layout (location = 0) in vec3 aPos; // Receives aPos
+layout (location = 1) in vec3 aNormal; // Receives aNormal
+layout (location = 2) in vec2 aTexCoords; // Receives aTexCoords, used to find lightmap texels
+
+out vec3 FragPos; // Returns FragPos
+out vec3 Normal; // Returns Normal
+flat out vec4 BakedFace; // Lightmap face: texel corner in the atlas, texels across, kind of bake
+out vec2 BakedData; // Texel within the lightmap face, or the vertex's baked values
+out gl_PerVertex { vec4 gl_Position; }; // Redeclared for separable programs
+invariant gl_Position; // Same depth as the depth pre-pass, so GL_EQUAL matches
+
+// Per-object constants computed once per frame on the CPU (ObjectConstants.h)
+struct ObjectConstants {
+    mat4 mvp; // projection * view * model
+    mat4 model; // model
+    mat4 normalMatrix; // transpose(inverse(model)) in the upper 3x3
+};
+layout (std430, binding = 0) readonly buffer ObjectBuffer {
+    ObjectConstants objects[]; // One entry per object
+};
+uniform uint objectIndex; // Receives index of the object being drawn
+
+// Baked lighting traced offline by lightbake [BakedLighting.h]
+layout (binding = 6) uniform usamplerBuffer bakedObjects; // Kind, placement and face size per object
+layout (binding = 7) uniform samplerBuffer bakedVertices; // Ambient occlusion and key light visibility per vertex
+
+void main() {
+    gl_Position = objects[objectIndex].mvp * vec4(aPos, 1.0f);  // Implements transformations with precomputed MVP
+    FragPos = vec3(objects[objectIndex].model * vec4(aPos, 1.0));  // Sets fragment position
+    Normal = mat3(objects[objectIndex].normalMatrix) * aNormal;  // Transforms normal with precomputed normal matrix
+    uvec4 baked = texelFetch(bakedObjects, int(objectIndex)); // This object's bake
+    BakedFace = vec4(0.0); // Not baked
+    BakedData = vec2(0.0);
+    if (baked.x == 1u) { // If lightmapped, the built-in cube with six vertices per face
+        uint face = uint(gl_VertexID) / 6u; // Face, tiles are 3x2 faces
+        BakedFace = vec4(float(baked.y + (face % 3u) * baked.w), float(baked.z + (face / 3u) * baked.w), float(baked.w), 1.0); // Face's corner texel
+        BakedData = aTexCoords * float(baked.w); // Position on the face in texels
+    } else if (baked.x == 2u) { // If baked per vertex
+        BakedFace.w = 2.0; // Values come with the vertex
+        BakedData = texelFetch(bakedVertices, int(baked.y) + gl_VertexID).rg; // Vertex values
+    }
+}
+)glsl";
+
+static const char cull_comp_source[] = R"glsl(
+#version 430 core
+layout (local_size_x = 64) in; // 64 instances per work group
+
+// Records shared with the CPU [GpuInstance, GpuBatch and DrawElementsIndirectCommand in GpuCulling.h]
+struct Instance {
+    mat4 model; // Object to world
+    mat4 normalMatrix; // Normal matrix in the upper 3x3
+    vec4 boundsMin; // Object-space bounding box minimum
+    vec4 boundsMax; // Object-space bounding box maximum
+    uint batch; // Batch the instance is drawn with
+    uint slot; // Index within its batch
+    uint pad0; // Padding
+    uint pad1; // Padding
+};
+struct Batch {
+    uint count; // Indices per draw
+    uint firstIndex; // First index
+    int baseVertex; // Added to every index
+    uint firstCommand; // First command slot of the batch
+};
+struct Command {
+    uint count; // Indices per draw
+    uint instanceCount; // 1 to draw, 0 to skip
+    uint firstIndex; // First index
+    int baseVertex; // Added to every index
+    uint baseInstance; // Instance index, fed to the vertex stage through the instance stream
+};
+layout (std430, binding = 2) readonly buffer InstanceBuffer {
+    Instance instances[]; // Every instance
+};
+layout (std430, binding = 3) readonly buffer BatchBuffer {
+    Batch batches[]; // Every batch
+};
+layout (std430, binding = 4) writeonly buffer CommandBuffer {
+    Command commands[]; // Draw commands, grouped by batch
+};
+layout (std430, binding = 5) buffer DrawCountBuffer {
+    uint drawCounts[]; // Commands written per batch, cleared every frame
+};
+uniform uint instanceTotal; // Receives number of instances
+uniform vec4 frustumPlanes[6]; // Receives world-space planes, inside where dot(xyz, p) + w >= 0
+uniform bool compact; // Receives true to pack visible commands, false to write every slot
+
+void main() {
+    uint id = gl_GlobalInvocationID.x; // Instance handled by this invocation
+    if (id >= instanceTotal) // If past the last instance
+        return;
+    Instance instance = instances[id]; // Instance record
+
+    // World-space box: transformed center, extent grown by the absolute rotation/scale
+    vec3 center = 0.5 * (instance.boundsMin.xyz + instance.boundsMax.xyz); // Object-space center
+    vec3 extent = 0.5 * (instance.boundsMax.xyz - instance.boundsMin.xyz); // Object-space half size
+    vec3 worldCenter = (instance.model * vec4(center, 1.0)).xyz; // World-space center
+    mat3 m = mat3(instance.model); // Rotation and scale
+    vec3 worldExtent = abs(m[0]) * extent.x + abs(m[1]) * extent.y + abs(m[2]) * extent.z; // World-space half size
+
+    // Outside if the whole box is behind any plane
+    bool visible = true; // Result
+    for (int p = 0; p < 6; p++) { // Iterate over planes
+        vec4 plane = frustumPlanes[p]; // Plane
+        if (dot(plane.xyz, worldCenter) + plane.w + dot(abs(plane.xyz), worldExtent) < 0.0) // If fully behind
+            visible = false; // Culled
+    }
+
+    Batch batch = batches[instance.batch]; // Batch record
+    uint slot; // Command slot
+    if (compact) { // If drawing with a count from the GPU
+        if (!visible) // If culled
+            return; // Write nothing
+        slot = batch.firstCommand + atomicAdd(drawCounts[instance.batch], 1u); // Next free slot in the batch
+    } else {
+        slot = batch.firstCommand + instance.slot; // Fixed slot, drawn or skipped by instanceCount
+    }
+    commands[slot].count = batch.count; // Indices per draw
+    commands[slot].instanceCount = visible ? 1u : 0u; // Draw or skip
+    commands[slot].firstIndex = batch.firstIndex; // First index
+    commands[slot].baseVertex = batch.baseVertex; // Base vertex
+    commands[slot].baseInstance = id; // Instance index
+}
+)glsl";
+
+static const char cylinder_vs_source[] = R"glsl(
+#version 430 core
+layout (location = 0) in vec3 aPos; // Receives aPos
+layout (location = 1) in vec3 aNormal; // Receives aNormal
+layout (location = 2) in vec2 aTexCoords; // Receives aTexCoords, used to find lightmap texels
+
+out vec3 FragPos; // Returns FragPos
+out vec3 Normal; // Returns Normal
+flat out vec4 BakedFace; // Lightmap face: texel corner in the atlas, texels across, kind of bake
+out vec2 BakedData; // Texel within the lightmap face, or the vertex's baked values
+out gl_PerVertex { vec4 gl_Position; }; // Redeclared for separable programs
+invariant gl_Position; // Same depth as the depth pre-pass, so GL_EQUAL matches
+
+// Per-object constants computed once per frame on the CPU (ObjectConstants.h)
+struct ObjectConstants {
+    mat4 mvp; // projection * view * model
+    mat4 model; // model
+    mat4 normalMatrix; // transpose(inverse(model)) in the upper 3x3
+};
+layout (std430, binding = 0) readonly buffer ObjectBuffer {
+    ObjectConstants objects[]; // One entry per object
+};
+uniform uint objectIndex; // Receives index of the object being drawn
+
+// Baked lighting traced offline by lightbake [BakedLighting.h]
+layout (binding = 6) uniform usamplerBuffer bakedObjects; // Kind, placement and face size per object
+layout (binding = 7) uniform samplerBuffer bakedVertices; // Ambient occlusion and key light visibility per vertex
+
+void main()
+{
+    gl_Position = objects[objectIndex].mvp * vec4(aPos, 1.0f);  // Implements transformations with precomputed MVP
+    FragPos = vec3(objects[objectIndex].model * vec4(aPos, 1.0));  // Sets fragment position
+    Normal = mat3(objects[objectIndex].normalMatrix) * aNormal;  // Transforms normal with precomputed normal matrix
+    uvec4 baked = texelFetch(bakedObjects, int(objectIndex)); // This object's bake
+    BakedFace = vec4(0.0); // Not baked
+    BakedData = vec2(0.0);
+    if (baked.x == 1u) { // If lightmapped, the built-in cube with six vertices per face
+        uint face = uint(gl_VertexID) / 6u; // Face, tiles are 3x2 faces
+        BakedFace = vec4(float(baked.y + (face % 3u) * baked.w), float(baked.z + (face / 3u) * baked.w), float(baked.w), 1.0); // Face's corner texel
+        BakedData = aTexCoords * float(baked.w); // Position on the face in texels
+    } else if (baked.x == 2u) { // If baked per vertex
+        BakedFace.w = 2.0; // Values come with the vertex
+        BakedData = texelFetch(bakedVertices, int(baked.y) + gl_VertexID).rg; // Vertex values
+    }
+}
+)glsl";
+
+static const char depth_frag_source[] = R"glsl(
+#version 430 core
+// Depth-only passes (depth pre-pass, shadow maps) write depth and no color
+layout(early_fragment_tests) in; // Test depth before the (empty) shader runs
+
+void main() {
+}
+)glsl";
+
+static const char depth_vs_source[] = R"glsl(
+#version 430 core
+layout (location = 0) in vec3 aPos; // Receives aPos from the position-only stream
+out gl_PerVertex { vec4 gl_Position; }; // Redeclared for separable programs
+invariant gl_Position; // Same depth as the color pass, so GL_EQUAL matches
+
+// Per-object constants computed once per frame on the CPU (ObjectConstants.h)
+struct ObjectConstants {
+    mat4 mvp; // projection * view * model
+    mat4 model; // model
+    mat4 normalMatrix; // transpose(inverse(model)) in the upper 3x3
+};
+layout (std430, binding = 0) readonly buffer ObjectBuffer {
+    ObjectConstants objects[]; // One entry per object
+};
+uniform uint objectIndex; // Receives index of the object being drawn
+
+void main() {
+    gl_Position = objects[objectIndex].mvp * vec4(aPos, 1.0f);  // Implements transformations with precomputed MVP
+}
+)glsl";
+
+static const char indirect_vs_source[] = R"glsl(
+#version 430 core
+layout (location = 0) in vec3 aPos; // Receives aPos
+layout (location = 1) in vec3 aNormal; // Receives aNormal
+layout (location = 3) in uint aInstance; // Receives instance index from the instance stream [offset by baseInstance]
+
+out vec3 FragPos; // Returns FragPos
+out vec3 Normal; // Returns Normal
+flat out vec4 BakedFace; // Lightmap face: texel corner in the atlas, texels across, kind of bake
+out vec2 BakedData; // Texel within the lightmap face, or the vertex's baked values
+out gl_PerVertex { vec4 gl_Position; }; // Redeclared for separable programs
+
+// Instances written once by the CPU and culled on the GPU [GpuInstance in GpuCulling.h]
+struct Instance {
+    mat4 model; // Object to world
+    mat4 normalMatrix; // Normal matrix in the upper 3x3
+    vec4 boundsMin; // Object-space bounding box minimum
+    vec4 boundsMax; // Object-space bounding box maximum
+    uint batch; // Batch the instance is drawn with
+    uint slot; // Index within its batch
+    uint pad0; // Padding
+    uint pad1; // Padding
+};
+layout (std430, binding = 2) readonly buffer InstanceBuffer {
+    Instance instances[]; // Every instance
+};
+uniform mat4 viewProjection; // Receives projection * view
+
+void main() {
+    vec4 world = instances[aInstance].model * vec4(aPos, 1.0); // World position
+    gl_Position = viewProjection * world; // Implements transformations
+    FragPos = world.xyz; // Sets fragment position
+    Normal = mat3(instances[aInstance].normalMatrix) * aNormal; // Transforms normal with the instance's precomputed matrix
+    BakedFace = vec4(0.0); // Instances are never baked
+    BakedData = vec2(0.0);
+}
+)glsl";
+
+static const char lit_frag_source[] = R"glsl(
+#version 430 core
+// Lit surface shared by every scene material: key light with shadows and baked lighting, plus clustered point
+// lights. Materials differ only in objectColor [Material::color in RenderQueue.h].
+out vec4 FragColor; // Returns FragColor
+
+in vec3 Normal; // Receives Normal
+in vec3 FragPos; // Receives FragPos
+
+// Per-frame constants written to the ring buffer once per frame [FrameConstants in ObjectConstants.h]
+layout(std140, binding = 1) uniform FrameConstants {
+    vec3 lightPos; // Light position
+    vec3 viewPos; // Camera position
+    vec3 lightColor; // Light color
+    uvec4 clusterGrid; // Tiles across, tiles down, depth slices, point light count
+    vec4 clusterDepth; // Near plane, far plane, slice scale, slice bias
+    vec4 clusterTile; // Pixels per tile across and down
+    vec4 shadowParams; // Shadow near plane, far plane (0 when off), normal offset and filter radius per unit depth
+};
+
+// Clustered point lights written to the ring buffer once per frame [ClusteredLights.h]
+struct PointLight {
+    vec4 positionRadius; // World position, radius in w
+    vec4 color; // Color
+};
+layout(std430, binding = 1) readonly buffer PointLights {
+    PointLight lights[]; // Every light
+};
+layout(std430, binding = 6) readonly buffer LightClusters {
+    uvec2 clusters[]; // First index and light count per cluster
+};
+layout(std430, binding = 7) readonly buffer LightIndices {
+    uint lightIndices[]; // Light indices grouped by cluster
+};
+
+// Key light's shadows, a depth cube map around lightPos compared in hardware [CachedShadowMap.h]
+layout(binding = 4) uniform samplerCubeShadow shadowMap;
+
+// Fraction of the key light reaching this fragment, averaged over eight filtered taps around its direction
+float keyLightVisibility(vec3 norm) {
+    if (shadowParams.y <= 0.0) // If shadows are off
+        return 1.0;
+    vec3 toFrag = FragPos - lightPos; // Light to fragment
+    float axis = max(abs(toFrag.x), max(abs(toFrag.y), abs(toFrag.z))); // Depth along the cube face's axis
+    toFrag += norm * shadowParams.z * axis; // Push off the surface by a few texels, which grow with depth
+    axis = max(abs(toFrag.x), max(abs(toFrag.y), abs(toFrag.z))); // Depth of the pushed point
+    float n = shadowParams.x, f = shadowParams.y; // Light's depth range
+    float depth = ((f + n) / (f - n) - 2.0 * f * n / ((f - n) * axis)) * 0.5 + 0.5; // Window depth the face would store
+    float radius = shadowParams.w * axis; // Filter radius, constant in texels
+    float visible = 0.0; // Lit taps
+    for (int i = 0; i < 8; i++) { // Iterate over the corners of a cube
+        vec3 offset = vec3(i & 1, (i >> 1) & 1, (i >> 2) & 1) * 2.0 - 1.0; // Corner direction
+        visible += texture(shadowMap, vec4(toFrag + offset * radius, depth)); // Compare
+    }
+    return visible / 8.0; // Average
+}
+
+// Ambient occlusion and key light visibility traced offline by lightbake [BakedLighting.h]
+layout(binding = 5) uniform sampler2D bakedAtlas; // Lightmap tiles
+flat in vec4 BakedFace; // Lightmap face: texel corner in the atlas, texels across, kind of bake
+in vec2 BakedData; // Texel within the lightmap face, or the vertex's baked values
+
+// Baked ambient occlusion and key light visibility, both 1 for objects that are not baked
+vec2 bakedLighting() {
+    if (BakedFace.w > 1.5) // If baked per vertex
+        return BakedData;
+    if (BakedFace.w > 0.5) { // If lightmapped
+        vec2 texel = BakedFace.xy + clamp(BakedData, vec2(0.5), vec2(BakedFace.z - 0.5)); // Filter inside the face so neighbouring faces never bleed in
+        return texture(bakedAtlas, texel / vec2(textureSize(bakedAtlas, 0))).rg; // Bilinear
+    }
+    return vec2(1.0); // Not baked
+}
+
+uniform vec3 objectColor; // Material color
+
+void main() {
+    // ambient
+    float ambientStrengh = 0.8; // Set ambient strength
+    vec3 ambient = ambientStrengh * lightColor; // Sets ambient
+    
+    // diffuse
+    vec3 norm = normalize(Normal); // Normalizes normal
+    vec3 lightDir = normalize(lightPos - FragPos); // Gets lightDir
+    float diff = max(dot(norm, lightDir), 0.0); // Gets diff
+    vec3 diffuse = diff * lightColor; // Sets diffuse
+
+    // specular
+    float specularStrength = 0.25f; // Sets specularStrength
+    vec3 viewDir = normalize(viewPos - FragPos); // Gets viewDir
+    vec3 reflectDir = reflect(-lightDir, norm); // Gets reflectDir
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), 8); // Gets spec
+    vec3 specular = specularStrength * spec * lightColor; // Sets specular
+
+    // shadow
+    vec2 baked = bakedLighting(); // Baked ambient occlusion and key light visibility
+    ambient *= baked.x; // Occluded ambient light
+    float shadow = min(keyLightVisibility(norm), baked.y); // Moving casters come from the shadow map, static ones are also baked
+
+    // point lights
+    vec3 points = vec3(0.0); // Sum of the point lights in this fragment's cluster
+    if (clusterGrid.w > 0u) { // If there are point lights
+        float zNdc = gl_FragCoord.z * 2.0 - 1.0; // NDC depth
+        float depth = 2.0 * clusterDepth.x * clusterDepth.y / (clusterDepth.y + clusterDepth.x - zNdc * (clusterDepth.y - clusterDepth.x)); // View depth
+        uint slice = uint(clamp(log(depth) * clusterDepth.z - clusterDepth.w, 0.0, float(clusterGrid.z - 1u))); // Depth slice
+        uvec2 tile = min(uvec2(gl_FragCoord.xy / clusterTile.xy), clusterGrid.xy - 1u); // Screen tile
+        uvec2 range = clusters[tile.x + clusterGrid.x * (tile.y + clusterGrid.y * slice)]; // Cluster's light list
+        for (uint i = 0u; i < range.y; i++) { // Iterate over listed lights
+            PointLight light = lights[lightIndices[range.x + i]]; // Light
+            vec3 toLight = light.positionRadius.xyz - FragPos; // Fragment to light
+            float dist = length(toLight); // Distance
+            if (dist >= light.positionRadius.w) // If out of reach
+                continue;
+            vec3 pointDir = toLight / dist; // Direction
+            float falloff = 1.0 - dist / light.positionRadius.w; // Linear falloff to zero at the radius
+            float pointSpec = pow(max(dot(viewDir, reflect(-pointDir, norm)), 0.0), 8); // Specular
+            points += falloff * falloff * (max(dot(norm, pointDir), 0.0) + specularStrength * pointSpec) * light.color.rgb; // Add light
+        }
+    }
+
+    vec3 result = (ambient + shadow * (diffuse + specular) + points) * objectColor; // Calculates result
+    FragColor = vec4(result, 1.0f); // Sets FragColor output
+}
+)glsl";
+
+static const char occlusion_frag_source[] = R"glsl(
+#version 430 core
+// Bounding box proxies only count samples; color and depth writes are masked off while they draw
+layout(early_fragment_tests) in; // Test depth before the (empty) shader runs
+
+void main() {
+}
+)glsl";
+
+static const char occlusion_vs_source[] = R"glsl(
+#version 430 core
+layout (location = 0) in vec3 aPos; // Receives aPos of a unit cube centered on the origin
+out gl_PerVertex { vec4 gl_Position; }; // Redeclared for separable programs
+
+// Per-object constants computed once per frame on the CPU (ObjectConstants.h)
+struct ObjectConstants {
+    mat4 mvp; // projection * view * model
+    mat4 model; // model
+    mat4 normalMatrix; // transpose(inverse(model)) in the upper 3x3
+};
+layout (std430, binding = 0) readonly buffer ObjectBuffer {
+    ObjectConstants objects[]; // One entry per object
+};
+uniform uint objectIndex; // Receives index of the object being tested
+uniform vec3 boundsMin; // Receives object-space bounding box minimum
+uniform vec3 boundsMax; // Receives object-space bounding box maximum
+
+void main() {
+    vec3 corner = mix(boundsMin, boundsMax, aPos + 0.5); // Stretch the unit cube over the bounding box
+    gl_Position = objects[objectIndex].mvp * vec4(corner, 1.0);  // Implements transformations with precomputed MVP
+}
+)glsl";
+
+static const char shadow_vs_source[] = R"glsl(
+#version 430 core
+layout (location = 0) in vec3 aPos; // Receives aPos from the position-only stream
+out gl_PerVertex { vec4 gl_Position; }; // Redeclared for separable programs
+
+// Per-object constants computed once per frame on the CPU (ObjectConstants.h)
+struct ObjectConstants {
+    mat4 mvp; // projection * view * model
+    mat4 model; // model
+    mat4 normalMatrix; // transpose(inverse(model)) in the upper 3x3
+};
+layout (std430, binding = 0) readonly buffer ObjectBuffer {
+    ObjectConstants objects[]; // One entry per object
+};
+uniform uint objectIndex; // Receives index of the caster being drawn
+uniform mat4 lightViewProjection; // Receives the light's transform for the cube face being drawn
+
+void main() {
+    gl_Position = lightViewProjection * (objects[objectIndex].model * vec4(aPos, 1.0f)); // World position seen from the light
+}
+)glsl";
+
+static const char sphere_vs_source[] = R"glsl(
+#version 430 core
+layout (location = 0) in vec3 aPos; // Receives aPos
+layout (location = 1) in vec3 aNormal; // Receives aNormal
+layout (location = 2) in vec2 aTexCoords; // Receives aTexCoords, used to find lightmap texels
+
+out vec3 FragPos; // Returns FragPos
+out vec3 Normal; // Returns Normal
+flat out vec4 BakedFace; // Lightmap face: texel corner in the atlas, texels across, kind of bake
+out vec2 BakedData; // Texel within the lightmap face, or the vertex's baked values
+out gl_PerVertex { vec4 gl_Position; }; // Redeclared for separable programs
+invariant gl_Position; // Same depth as the depth pre-pass, so GL_EQUAL matches
+
+// Per-object constants computed once per frame on the CPU (ObjectConstants.h)
+struct ObjectConstants {
+    mat4 mvp; // projection * view * model
+    mat4 model; // model
+    mat4 normalMatrix; // transpose(inverse(model)) in the upper 3x3
+};
+layout (std430, binding = 0) readonly buffer ObjectBuffer {
+    ObjectConstants objects[]; // One entry per object
+};
+uniform uint objectIndex; // Receives index of the object being drawn
+
+// Baked lighting traced offline by lightbake [BakedLighting.h]
+layout (binding = 6) uniform usamplerBuffer bakedObjects; // Kind, placement and face size per object
+layout (binding = 7) uniform samplerBuffer bakedVertices; // Ambient occlusion and key light visibility per vertex
+
+void main() {
+    gl_Position = objects[objectIndex].mvp * vec4(aPos, 1.0f);  // Implements transformations with precomputed MVP
+    FragPos = vec3(objects[objectIndex].model * vec4(aPos, 1.0));  // Sets fragment position
+    Normal = mat3(objects[objectIndex].normalMatrix) * aNormal;  // Transforms normal with precomputed normal matrix
+    uvec4 baked = texelFetch(bakedObjects, int(objectIndex)); // This object's bake
+    BakedFace = vec4(0.0); // Not baked
+    BakedData = vec2(0.0);
+    if (baked.x == 1u) { // If lightmapped, the built-in cube with six vertices per face
+        uint face = uint(gl_VertexID) / 6u; // Face, tiles are 3x2 faces
+        BakedFace = vec4(float(baked.y + (face % 3u) * baked.w), float(baked.z + (face / 3u) * baked.w), float(baked.w), 1.0); // Face's corner texel
+        BakedData = aTexCoords * float(baked.w); // Position on the face in texels
+    } else if (baked.x == 2u) { // If baked per vertex
+        BakedFace.w = 2.0; // Values come with the vertex
+        BakedData = texelFetch(bakedVertices, int(baked.y) + gl_VertexID).rg; // Vertex values
+    }
+}
+)glsl";
+
+static const char upsample_frag_source[] = R"glsl(
+#version 430 core
+out vec4 FragColor; // Returns FragColor
+
+in vec2 TexCoord; // Receives window position in 0..1
+
+layout(binding = 0) uniform sampler2D scene; // Scene rendered at the reduced resolution [DynamicResolution.h]
+uniform vec4 region; // Rendered fraction of the texture in xy, half a texel in zw
+
+void main() {
+    vec2 uv = clamp(TexCoord * region.xy, region.zw, region.xy - region.zw); // Stay half a texel inside the rendered region
+    FragColor = texture(scene, uv); // Bilinear upsample
+}
+)glsl";
+
+static const char upsample_vs_source[] = R"glsl(
+#version 430 core
+out gl_PerVertex { vec4 gl_Position; }; // Redeclared for separable programs
+out vec2 TexCoord; // Passes window position in 0..1 to the fragment stage
+
+// One triangle covering the window, generated from gl_VertexID with no vertex buffer
+void main() {
+    vec2 corner = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2); // (0,0), (2,0), (0,2)
+    TexCoord = corner; // 0..1 across the window, overshooting where the triangle leaves it
+    gl_Position = vec4(corner * 2.0 - 1.0, 0.0, 1.0); // Clip space
+}
+)glsl";
+
+// Embedded shader entry: file name, GLSL source and optional SPIR-V binary
+struct EmbeddedShader {
+    const char* name; // File name the shader was built from
+    const char* source; // GLSL source
+    const unsigned char* spirv; // SPIR-V binary or nullptr
+    size_t spirvSize; // Size of SPIR-V binary in bytes
+};
+
+static const EmbeddedShader embeddedShaders[] = {
+    { "checkerboard.vs", checkerboard_vs_source, nullptr, 0 },
+    { "cube.vs", cube_vs_source, nullptr, 0 },
+    { "cull.comp", cull_comp_source, nullptr, 0 },
+    { "cylinder.vs", cylinder_vs_source, nullptr, 0 },
+    { "depth.frag", depth_frag_source, nullptr, 0 },
+    { "depth.vs", depth_vs_source, nullptr, 0 },
+    { "indirect.vs", indirect_vs_source, nullptr, 0 },
+    { "lit.frag", lit_frag_source, nullptr, 0 },
+    { "occlusion.frag", occlusion_frag_source, nullptr, 0 },
+    { "occlusion.vs", occlusion_vs_source, nullptr, 0 },
+    { "shadow.vs", shadow_vs_source, nullptr, 0 },
+    { "sphere.vs", sphere_vs_source, nullptr, 0 },
+    { "upsample.frag", upsample_frag_source, nullptr, 0 },
+    { "upsample.vs", upsample_vs_source, nullptr, 0 },
+};
+
+// Returns the embedded shader built from the given file name, or nullptr if it was not embedded
+inline const EmbeddedShader* FindEmbeddedShader(const char* name) {
+    for (size_t i = 0; i < sizeof(embeddedShaders) / sizeof(embeddedShaders[0]); i++) { // Iterate over table
+        if (strcmp(embeddedShaders[i].name, name) == 0) // If names match
+            return &embeddedShaders[i]; // Return entry
+    }
+    return nullptr; // Not embedded
+}
@@ -0,0 +1,19 @@
+#version 430 core
+layout (location = 0) in vec3 aPos; // Receives aPos from the position-only stream
+out gl_PerVertex { vec4 gl_Position; }; // Redeclared for separable programs
+
+// Per-object constants computed once per frame on the CPU (ObjectConstants.h)
+struct ObjectConstants {
+    mat4 mvp; // projection * view * model
+    mat4 model; // model
+    mat4 normalMatrix; // transpose(inverse(model)) in the upper 3x3
+};
+layout (std430, binding = 0) readonly buffer ObjectBuffer {
+    ObjectConstants objects[]; // One entry per object
+};
+uniform uint objectIndex; // Receives index of the caster being drawn
+uniform mat4 lightViewProjection; // Receives the light's transform for the cube face being drawn
+
+void main() {
+    gl_Position = lightViewProjection * (objects[objectIndex].model * vec4(aPos, 1.0f)); // World position seen from the light
+}
@@ -0,0 +1,12 @@
+#version 430 core
+out vec4 FragColor; // Returns FragColor
+
+in vec2 TexCoord; // Receives window position in 0..1
+
+layout(binding = 0) uniform sampler2D scene; // Scene rendered at the reduced resolution [DynamicResolution.h]
+uniform vec4 region; // Rendered fraction of the texture in xy, half a texel in zw
+
+void main() {
+    vec2 uv = clamp(TexCoord * region.xy, region.zw, region.xy - region.zw); // Stay half a texel inside the rendered region
+    FragColor = texture(scene, uv); // Bilinear upsample
+}
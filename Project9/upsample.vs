@@ -0,0 +1,10 @@
+#version 430 core
+out gl_PerVertex { vec4 gl_Position; }; // Redeclared for separable programs
+out vec2 TexCoord; // Passes window position in 0..1 to the fragment stage
+
+// One triangle covering the window, generated from gl_VertexID with no vertex buffer
+void main() {
+    vec2 corner = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2); // (0,0), (2,0), (0,2)
+    TexCoord = corner; // 0..1 across the window, overshooting where the triangle leaves it
+    gl_Position = vec4(corner * 2.0 - 1.0, 0.0, 1.0); // Clip space
+}
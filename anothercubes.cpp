@@ -4,6 +4,7 @@
 #include <GL/glut.h>
 #endif
 #include <cmath>
+#include "headless.h"
 
 namespace Cube {
 const int NUM_VERTICES = 8;
@@ -123,7 +124,7 @@ void display() {
   drawBlueMeshPlanes();
   
   glFlush();
-  glutSwapBuffers();
+  if (!headlessActive()) glutSwapBuffers();
 }
 
 void keyboard(unsigned char key, int x, int y) {
@@ -160,7 +161,8 @@ void keyboard(unsigned char key, int x, int y) {
   glutPostRedisplay(); // Redraw the scene with new camera settings
 }
 
-void timer(int v) {
+// Advances the camera and the moving cubes one step
+void update() {
   if (isMoving) {
     static GLfloat u = 0.0;
 
@@ -187,6 +189,10 @@ void timer(int v) {
       cubeDirection2 *= -1; // Reverse direction when a boundary is hit
     }
   }
+}
+
+void timer(int v) {
+  update();
 
   // Redraw the scene by calling glutPostRedisplay
   glutPostRedisplay();
@@ -205,6 +211,17 @@ void reshape(int w, int h) {
 }
 
 int main(int argc, char** argv) {
+  // --headless renders a fixed number of frames offscreen and exits
+  if (headlessInit(argc, argv, 500, 500, 0, 0, false)) {
+    reshape(headlessWidth(), headlessHeight());
+    while (headlessRunning()) {
+      update();
+      display();
+      headlessEndFrame();
+    }
+    return headlessFinish();
+  }
+
   glutInit(&argc, argv);
   glutInitDisplayMode(GLUT_DOUBLE | GLUT_RGB);
   glutInitWindowSize(500, 500);
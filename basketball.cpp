@@ -3,6 +3,8 @@
 #include <cmath>
 #include <iostream>
 
+#include "fixedstep.h"
+
 const float PI = 3.14159265359;
 const int num_segments = 100;
 
@@ -22,6 +24,12 @@ bool ballShot = false;
 
 int score = 0;
 
+// state before the last tick, blended with the current state when drawing
+float prevBasketX = basketX;
+float prevBallX = ballX;
+float prevBallY = ballY;
+float prevBallSize = ballSize;
+
 const int windowWidth = 1900;
 const int windowHeight = 1080;
 
@@ -31,7 +39,13 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
     }
 }
 
+// advances the game by one fixed tick
 void updateGameLogic() {
+    prevBasketX = basketX;
+    prevBallX = ballX;
+    prevBallY = ballY;
+    prevBallSize = ballSize;
+
     basketX += basketSpeed;
     if (basketX >= 2.0f || basketX <= -2.0f) {
         basketSpeed = -basketSpeed;
@@ -48,6 +62,8 @@ void updateGameLogic() {
             ballX = 0.0f;
             ballY = -0.9f;
             ballSpeed = 0.05f;
+            prevBallX = ballX; // don't interpolate across the reset
+            prevBallY = ballY;
         }
 
         if (ballX > 2.0f || ballX < -2.0f || ballY > 2.0f || ballY < -2.0f) {
@@ -55,9 +71,14 @@ void updateGameLogic() {
             ballX = 0.0f;
             ballY = -0.9f;
             ballSpeed = 0.05f;
+            prevBallX = ballX; // don't interpolate across the reset
+            prevBallY = ballY;
         }
 
         ballSize = std::max(0.01f, 0.05f * (1.0f - (ballY + 0.9f) / 2.0f));
+        if (!ballShot) {
+            prevBallSize = ballSize;
+        }
     }
 }
 
@@ -74,7 +95,7 @@ void draw3DCircle(float radius, float lineWidth) {
     glEnd();
 }
 
-int main() {
+int main(int argc, char** argv) {
     // Initialize GLFW
     if (!glfwInit()) {
         std::cerr << "Failed to initialize GLFW" << std::endl;
@@ -95,6 +116,10 @@ int main() {
     // Set the key callback function
     glfwSetKeyCallback(window, key_callback);
 
+    // vsync unless benchmarking; the game runs at 60 ticks per second either way
+    glfwSwapInterval(fixedStepUncapped(argc, argv) ? 0 : 1);
+    FixedStep clock = fixedStepInit(1.0 / 60.0);
+
     // Set up viewport and projection
     glViewport(0, 0, windowWidth, windowHeight);
     glMatrixMode(GL_PROJECTION);
@@ -105,8 +130,18 @@ int main() {
 
     // Loop until the user closes the window
     while (!glfwWindowShouldClose(window) && score < 5) {
-        // Update game logic
-        updateGameLogic();
+        // Update game logic in fixed ticks
+        int ticks = fixedStepAdvance(clock, glfwGetTime());
+        for (int i = 0; i < ticks; ++i) {
+            updateGameLogic();
+        }
+
+        // Positions between the last two ticks
+        float alpha = fixedStepAlpha(clock);
+        float drawBasketX = fixedStepLerp(prevBasketX, basketX, alpha);
+        float drawBallX = fixedStepLerp(prevBallX, ballX, alpha);
+        float drawBallY = fixedStepLerp(prevBallY, ballY, alpha);
+        float drawBallSize = fixedStepLerp(prevBallSize, ballSize, alpha);
 
         // Render scene
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
@@ -115,7 +150,7 @@ int main() {
 
         // Draw the hoop
         glPushMatrix();
-        glTranslatef(basketX, 1.0f, 0.0f); // Adjust to place the hoop correctly
+        glTranslatef(drawBasketX, 1.0f, 0.0f); // Adjust to place the hoop correctly
         glRotatef(rotationAngleX, 1.0f, 0.0f, 0.0f);
         draw3DCircle(0.2f, 2.0f);
         glPopMatrix();
@@ -123,28 +158,28 @@ int main() {
         // Draw the backboard
         glBegin(GL_QUADS);
         glColor3f(0.0f, 0.0f, 1.0f); // Blue color for the backboard
-        glVertex2f(basketX - 0.5f, 1.0f);
-        glVertex2f(basketX + 0.5f, 1.0f);
-        glVertex2f(basketX + 0.5f, 1.1f);
-        glVertex2f(basketX - 0.5f, 1.1f);
+        glVertex2f(drawBasketX - 0.5f, 1.0f);
+        glVertex2f(drawBasketX + 0.5f, 1.0f);
+        glVertex2f(drawBasketX + 0.5f, 1.1f);
+        glVertex2f(drawBasketX - 0.5f, 1.1f);
         glEnd();
 
         // Draw the rim
         glBegin(GL_QUADS);
         glColor3f(1.0f, 0.0f, 0.0f); // Red color for the rim
-        glVertex2f(basketX - 0.1f, 0.8f);
-        glVertex2f(basketX + 0.1f, 0.8f);
-        glVertex2f(basketX + 0.1f, 0.82f);
-        glVertex2f(basketX - 0.1f, 0.82f);
+        glVertex2f(drawBasketX - 0.1f, 0.8f);
+        glVertex2f(drawBasketX + 0.1f, 0.8f);
+        glVertex2f(drawBasketX + 0.1f, 0.82f);
+        glVertex2f(drawBasketX - 0.1f, 0.82f);
         glEnd();
 
         // Draw the ball with variable size
         glBegin(GL_QUADS);
         glColor3f(1.0f, 0.647f, 0.0f); // Orange color for the ball
-        glVertex2f(ballX - ballSize, ballY - ballSize);
-        glVertex2f(ballX + ballSize, ballY - ballSize);
-        glVertex2f(ballX + ballSize, ballY + ballSize);
-        glVertex2f(ballX - ballSize, ballY + ballSize);
+        glVertex2f(drawBallX - drawBallSize, drawBallY - drawBallSize);
+        glVertex2f(drawBallX + drawBallSize, drawBallY - drawBallSize);
+        glVertex2f(drawBallX + drawBallSize, drawBallY + drawBallSize);
+        glVertex2f(drawBallX - drawBallSize, drawBallY + drawBallSize);
         glEnd();
 
         // Swap front and back buffers
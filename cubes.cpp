@@ -4,6 +4,7 @@
 #include <GL/glut.h>
 #endif
 #include <cmath>
+#include "headless.h"
 
 namespace Cube {
 const int NUM_VERTICES = 8;
@@ -66,10 +67,11 @@ void display() {
   Cube::draw();
   drawBlueMeshPlanes();
   glFlush();
-  glutSwapBuffers();
+  if (!headlessActive()) glutSwapBuffers();
 }
 
-void timer(int v) {
+// Moves the camera one step along its path
+void update() {
   static GLfloat u = 0.0;
 
   // Define the radii of the ellipse for the x and z axes
@@ -90,11 +92,26 @@ void timer(int v) {
   gluLookAt(cameraX, -4, cameraZ,  // Camera position on the elliptical path
             0, 0, 0,               // Look at the center of the cube
             0, 1, 0);              // Up vector
+}
+
+// Paused while p is toggled on: the timer stops and GLUT only redraws when the window needs it
+bool paused = false;
+int timerChain = 0; // only the newest chain keeps running if p is tapped quickly
 
+void timer(int v) {
+  if (paused || v != timerChain) return; // let the chain lapse, nothing changes until unpaused
+  update();
   glutPostRedisplay();
   glutTimerFunc(1000/60, timer, v);
 }
 
+// p pauses and resumes the flight
+void keyboard(unsigned char key, int, int) {
+  if (key != 'p') return;
+  paused = !paused;
+  if (!paused) glutTimerFunc(1000/60, timer, ++timerChain); // restart the chain
+}
+
 
 
 void reshape(int w, int h) {
@@ -106,12 +123,24 @@ void reshape(int w, int h) {
 }
 
 int main(int argc, char** argv) {
+  // --headless renders a fixed number of frames offscreen and exits
+  if (headlessInit(argc, argv, 500, 500, 0, 0, false)) {
+    reshape(headlessWidth(), headlessHeight());
+    while (headlessRunning()) {
+      update();
+      display();
+      headlessEndFrame();
+    }
+    return headlessFinish();
+  }
+
   glutInit(&argc, argv);
   glutInitDisplayMode(GLUT_DOUBLE | GLUT_RGB);
   glutInitWindowSize(500, 500);
   glutCreateWindow("The RGB Color Cube");
   glutReshapeFunc(reshape);
   glutTimerFunc(100, timer, 0);
+  glutKeyboardFunc(keyboard);
   glutDisplayFunc(display);
   glutMainLoop();
   return 0;
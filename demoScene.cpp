@@ -6,6 +6,9 @@
 #include <fstream>
 #include <vector>
 
+#include "fixedstep.h"
+#include "dynres.h"
+
 // Ball object struct
 struct BallPosition {
     float x, y;
@@ -30,6 +33,11 @@ float ballSpeed = 0.05f;
 float ballArc = 1.5f;
 bool ballShot = false;
 
+// state before the last tick, blended with the current state when drawing
+float prevBasketX = basketX;
+float prevBallX = ballX;
+float prevBallY = ballY;
+
 float netX = 0.0f;
 float netY = 0.8f;
 float netWidth = 0.2f;
@@ -53,8 +61,11 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
     }
 }
 
-// function to handle game logic
+// function to handle game logic, called once per fixed tick
 void updateGameLogic() {
+    prevBasketX = basketX;
+    prevBallX = ballX;
+    prevBallY = ballY;
 
     // flip basket if at edge
     basketX += basketSpeed;
@@ -73,6 +84,8 @@ void updateGameLogic() {
             ballShot = false;
             ballX = 0.0f;
             ballY = -0.9f;
+            prevBallX = ballX; // don't interpolate across the reset
+            prevBallY = ballY;
         }
 
         // if not scored, reset ball
@@ -80,6 +93,8 @@ void updateGameLogic() {
             ballShot = false;
             ballX = 0.0f;
             ballY = -0.9f;
+            prevBallX = ballX; // don't interpolate across the reset
+            prevBallY = ballY;
         }
 
         // Update ball trail
@@ -212,7 +227,7 @@ void updateHighScore(int currentScore) {
 }
 
 
-int main() {
+int main(int argc, char** argv) {
 
     // initialize glfw, gl, glu
     if (!glfwInit()) {
@@ -230,6 +245,14 @@ int main() {
     glfwMakeContextCurrent(window);
     glfwSetKeyCallback(window, key_callback);
 
+    // vsync unless benchmarking; the game runs at 60 ticks per second either way
+    glfwSwapInterval(fixedStepUncapped(argc, argv) ? 0 : 1);
+    FixedStep clock = fixedStepInit(1.0 / 60.0);
+
+    // --target-fps lowers the resolution when the GPU falls behind, --resolution-scale fixes it
+    DynRes resolution = dynResParse(argc, argv);
+    DynResLegacy resolutionTarget = dynResLegacyInit(resolution, windowWidth, windowHeight, glfwGetProcAddress);
+
 
     glViewport(0, 0, windowWidth, windowHeight);
     glMatrixMode(GL_PROJECTION);
@@ -245,10 +268,20 @@ int main() {
 
     // draw environment
     while (!glfwWindowShouldClose(window)) {
-        updateGameLogic();
+        int ticks = fixedStepAdvance(clock, glfwGetTime());
+        for (int i = 0; i < ticks; ++i) {
+            updateGameLogic();
+        }
+
+        // positions between the last two ticks
+        float alpha = fixedStepAlpha(clock);
+        float drawBasketX = fixedStepLerp(prevBasketX, basketX, alpha);
+        float drawBallX = fixedStepLerp(prevBallX, ballX, alpha);
+        float drawBallY = fixedStepLerp(prevBallY, ballY, alpha);
 
         // Set the background color to light beige
         glClearColor(0.937f, 0.882f, 0.788f, 1.0f);
+        dynResLegacyBegin(resolutionTarget);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
         glLoadIdentity();
@@ -257,49 +290,52 @@ int main() {
         // Draw the border for the backboard
         glBegin(GL_QUADS);
         glColor3f(0.3f, 0.3f, 0.3f); // Dark grey color for the border
-        glVertex2f(basketX - 0.525f, 1.425f); // Slightly larger than the backboard, but smaller border
-        glVertex2f(basketX + 0.525f, 1.425f);
-        glVertex2f(basketX + 0.525f, 0.775f);
-        glVertex2f(basketX - 0.525f, 0.775f);
+        glVertex2f(drawBasketX - 0.525f, 1.425f); // Slightly larger than the backboard, but smaller border
+        glVertex2f(drawBasketX + 0.525f, 1.425f);
+        glVertex2f(drawBasketX + 0.525f, 0.775f);
+        glVertex2f(drawBasketX - 0.525f, 0.775f);
         glEnd();
 
         // Draw the backboard with a muted blue color
         glBegin(GL_QUADS);
         glColor3f(0.1f, 0.2f, 0.8f); // Sharper blue color
-        glVertex2f(basketX - 0.5f, 1.4f); // Original size of the backboard
-        glVertex2f(basketX + 0.5f, 1.4f);
-        glVertex2f(basketX + 0.5f, 0.8f);
-        glVertex2f(basketX - 0.5f, 0.8f);
+        glVertex2f(drawBasketX - 0.5f, 1.4f); // Original size of the backboard
+        glVertex2f(drawBasketX + 0.5f, 1.4f);
+        glVertex2f(drawBasketX + 0.5f, 0.8f);
+        glVertex2f(drawBasketX - 0.5f, 0.8f);
         glEnd();
 
         glBegin(GL_QUADS);
         glColor3f(1.0f, 0.0f, 0.0f); // Red color for the outline
-        glVertex2f(basketX - 0.12f, 1.0f); // Top-left vertex
-        glVertex2f(basketX + 0.12f, 1.0f); // Top-right vertex
-        glVertex2f(basketX + 0.12f, 0.8f); // Bottom-right vertex
-        glVertex2f(basketX - 0.12f, 0.8f); // Bottom-left vertex
+        glVertex2f(drawBasketX - 0.12f, 1.0f); // Top-left vertex
+        glVertex2f(drawBasketX + 0.12f, 1.0f); // Top-right vertex
+        glVertex2f(drawBasketX + 0.12f, 0.8f); // Bottom-right vertex
+        glVertex2f(drawBasketX - 0.12f, 0.8f); // Bottom-left vertex
         glEnd();
 
         glBegin(GL_QUADS);
         glColor3f(0.1f, 0.2f, 0.8f); // Sharper blue color
-        glVertex2f(basketX - 0.1f, 0.98f); // Top-left vertex
-        glVertex2f(basketX + 0.1f, 0.98f); // Top-right vertex
-        glVertex2f(basketX + 0.1f, 0.82f); // Bottom-right vertex
-        glVertex2f(basketX - 0.1f, 0.82f); // Bottom-left vertex
+        glVertex2f(drawBasketX - 0.1f, 0.98f); // Top-left vertex
+        glVertex2f(drawBasketX + 0.1f, 0.98f); // Top-right vertex
+        glVertex2f(drawBasketX + 0.1f, 0.82f); // Bottom-right vertex
+        glVertex2f(drawBasketX - 0.1f, 0.82f); // Bottom-left vertex
         glEnd();
         
         glColor3f(1.0f, 0.0f, 0.0f);
         glPushMatrix();
-        glTranslatef(basketX, 1.0f, 0.0f);
+        glTranslatef(drawBasketX, 1.0f, 0.0f);
         glRotatef(rotationAngleX, 1.0f, 0.0f, 0.0f);
         draw3DCircle(0.2f, 2.0f);
         glPopMatrix();
 
 	    drawBallTrail(); // Draw the trail
-        drawBall(ballX, ballY, 0.05f);
+        drawBall(drawBallX, drawBallY, 0.05f);
 
         // drawNet();
 
+        // stretch the scaled frame over the window
+        dynResLegacyEnd(resolutionTarget);
+
         glfwSwapBuffers(window);
 
         glfwPollEvents();
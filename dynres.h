@@ -0,0 +1,223 @@
+// Dynamic resolution shared by the demos
+//
+// Renders the scene into a region smaller than the window when the GPU cannot keep up, then stretches it
+// to the window with bilinear filtering. A controller watches measured GPU frame time and picks the
+// resolution scale (fraction of the window's width and height) that holds a target frame rate. GPU time
+// follows the pixel count, the square of the scale, so the controller moves the scale by the square root
+// of how far the frame is from budget, aiming 10% under it. It drops quickly and climbs slowly, and waits a
+// few frames after each change for timer results rendered at the new scale.
+//
+// Typical loop:
+//   DynRes resolution = dynResInit(1000.0 / 60.0);
+//   while (running) {
+//       ... render at dynResScale(resolution) ...
+//       dynResUpdate(resolution, gpuMilliseconds);
+//   }
+//
+// Project 9 renders into a framebuffer object (DynamicResolution.h). The fixed-function demos use the
+// DynResLegacy helpers below, which render into the corner of the back buffer and copy it to a texture.
+//
+// Command line, parsed by dynResParse:
+//   --target-fps N         turn dynamic resolution on and hold N frames per second
+//   --resolution-scale S   render at a fixed scale S (0.25 to 1) with the controller off
+//
+// Include this after GLEW/GLUT/GLFW.
+
+#pragma once
+
+#ifndef __GLEW_H__
+#include <GL/glext.h>
+#endif
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+const int DYNRES_SETTLE_FRAMES = 8; // Frames to wait after a change, longer than timer readback latency
+
+struct DynRes {
+    bool enabled; // Rendering at a reduced scale is on
+    bool fixed; // Scale set on the command line, controller off
+    double targetMs; // GPU milliseconds per frame to stay under
+    float scale; // Current fraction of the window's width and height
+    float minScale, maxScale; // Range the controller moves in
+    double smoothedMs; // Running average of GPU time at the current scale, 0 until the first sample
+    int settle; // Frames left before the average is trusted again
+};
+
+// Creates a controller holding targetMs GPU milliseconds per frame
+inline DynRes dynResInit(double targetMs, float minScale = 0.5f, float maxScale = 1.0f) {
+    DynRes resolution = DynRes(); // Zero-initialized controller
+    resolution.enabled = true;
+    resolution.targetMs = targetMs;
+    resolution.scale = maxScale;
+    resolution.minScale = minScale;
+    resolution.maxScale = maxScale;
+    return resolution;
+}
+
+// Reads --target-fps and --resolution-scale. Returns a disabled controller when neither is given.
+inline DynRes dynResParse(int argc, char** argv) {
+    DynRes resolution = dynResInit(1000.0 / 60.0); // 60 frames per second unless asked otherwise
+    resolution.enabled = false;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--target-fps") == 0 && i + 1 < argc) {
+            double fps = atof(argv[++i]);
+            if (fps > 0.0)
+                resolution.targetMs = 1000.0 / fps;
+            resolution.enabled = true;
+        } else if (strcmp(argv[i], "--resolution-scale") == 0 && i + 1 < argc) {
+            float scale = (float)atof(argv[++i]);
+            resolution.scale = scale < 0.25f ? 0.25f : (scale > 1.0f ? 1.0f : scale);
+            resolution.fixed = true;
+            resolution.enabled = true;
+        }
+    }
+    return resolution;
+}
+
+// Fraction of the window's width and height to render this frame
+inline float dynResScale(const DynRes& resolution) {
+    return resolution.enabled ? resolution.scale : 1.0f;
+}
+
+// Pixels to render along one axis of a window size at the current scale, at least 1
+inline int dynResSize(const DynRes& resolution, int windowSize) {
+    int size = (int)(windowSize * dynResScale(resolution) + 0.5f);
+    return size < 1 ? 1 : size;
+}
+
+// Feeds one frame's GPU time and moves the scale when the average leaves the band around the target.
+// Returns the scale for the next frame.
+inline float dynResUpdate(DynRes& resolution, double gpuMs) {
+    if (!resolution.enabled || resolution.fixed || gpuMs <= 0.0)
+        return dynResScale(resolution);
+    if (resolution.settle > 0) { // Results may still come from the previous scale
+        resolution.settle--;
+        return resolution.scale;
+    }
+    resolution.smoothedMs = resolution.smoothedMs > 0.0 ? resolution.smoothedMs + (gpuMs - resolution.smoothedMs) * 0.1 : gpuMs;
+    double headroom = resolution.targetMs / resolution.smoothedMs; // Above 1 when under budget
+    if (headroom > 0.95 && headroom < 1.25) // Close enough, leave it alone
+        return resolution.scale;
+    float wanted = resolution.scale * (float)sqrt(headroom * 0.9); // Scale that lands 10% under budget
+    float lowest = resolution.scale * 0.85f, highest = resolution.scale * 1.05f; // Drop fast, climb slow
+    wanted = wanted < lowest ? lowest : (wanted > highest ? highest : wanted);
+    wanted = wanted < resolution.minScale ? resolution.minScale : (wanted > resolution.maxScale ? resolution.maxScale : wanted);
+    if (fabs(wanted - resolution.scale) < 0.01f) // Pinned at a limit
+        return resolution.scale;
+    resolution.scale = wanted;
+    resolution.smoothedMs = 0.0; // Start a fresh average at the new scale
+    resolution.settle = DYNRES_SETTLE_FRAMES;
+    return resolution.scale;
+}
+
+// Fixed-function path: the scene is drawn into the bottom-left corner of the back buffer, copied into a
+// texture and stretched back over the whole window. GPU time comes from GL_TIME_ELAPSED queries, looked up
+// through the caller's loader (for example glfwGetProcAddress); without GL_ARB_timer_query the scale stays
+// where it started.
+struct DynResLegacy {
+    DynRes* resolution; // Controller
+    int width, height; // Window size
+    int renderWidth, renderHeight; // Region drawn this frame
+    GLuint texture; // Copy of the rendered region
+    GLuint queries[DYNRES_SETTLE_FRAMES]; // Timer queries in flight, one per frame
+    int frame; // Frames timed so far
+    PFNGLGENQUERIESPROC genQueries;
+    PFNGLBEGINQUERYPROC beginQuery;
+    PFNGLENDQUERYPROC endQuery;
+    PFNGLGETQUERYOBJECTIVPROC getQueryObjectiv;
+    PFNGLGETQUERYOBJECTUI64VPROC getQueryObjectui64v;
+};
+
+// Creates the texture and timer queries for a window. getProc looks up GL entry points by name.
+template <typename Loader>
+inline DynResLegacy dynResLegacyInit(DynRes& resolution, int width, int height, Loader getProc) {
+    DynResLegacy target = DynResLegacy(); // Zero-initialized target
+    target.resolution = &resolution;
+    target.width = target.renderWidth = width;
+    target.height = target.renderHeight = height;
+    if (!resolution.enabled)
+        return target;
+    glGenTextures(1, &target.texture);
+    glBindTexture(GL_TEXTURE_2D, target.texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR); // Bilinear upsample
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB8, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, NULL); // Full window, any scale fits
+    glBindTexture(GL_TEXTURE_2D, 0);
+    target.genQueries = (PFNGLGENQUERIESPROC)getProc("glGenQueries");
+    target.beginQuery = (PFNGLBEGINQUERYPROC)getProc("glBeginQuery");
+    target.endQuery = (PFNGLENDQUERYPROC)getProc("glEndQuery");
+    target.getQueryObjectiv = (PFNGLGETQUERYOBJECTIVPROC)getProc("glGetQueryObjectiv");
+    target.getQueryObjectui64v = (PFNGLGETQUERYOBJECTUI64VPROC)getProc("glGetQueryObjectui64v");
+    const char* extensions = (const char*)glGetString(GL_EXTENSIONS);
+    bool timerQuery = extensions && strstr(extensions, "GL_ARB_timer_query");
+    if (!timerQuery || !target.genQueries || !target.beginQuery || !target.endQuery || !target.getQueryObjectiv || !target.getQueryObjectui64v)
+        target.genQueries = NULL; // No GPU timing, controller stays put
+    else
+        target.genQueries(DYNRES_SETTLE_FRAMES, target.queries);
+    return target;
+}
+
+// Starts a frame: restricts drawing to the scaled region and starts timing
+inline void dynResLegacyBegin(DynResLegacy& target) {
+    if (!target.resolution->enabled)
+        return;
+    target.renderWidth = dynResSize(*target.resolution, target.width);
+    target.renderHeight = dynResSize(*target.resolution, target.height);
+    glViewport(0, 0, target.renderWidth, target.renderHeight); // Same aspect ratio, fewer pixels
+    if (target.genQueries)
+        target.beginQuery(GL_TIME_ELAPSED, target.queries[target.frame % DYNRES_SETTLE_FRAMES]);
+}
+
+// Ends a frame: stretches the region over the window, stops timing and feeds the oldest finished timing to
+// the controller. Call before swapping buffers.
+inline void dynResLegacyEnd(DynResLegacy& target) {
+    if (!target.resolution->enabled)
+        return;
+    glBindTexture(GL_TEXTURE_2D, target.texture);
+    glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, 0, target.renderWidth, target.renderHeight);
+    glPushAttrib(GL_ENABLE_BIT | GL_VIEWPORT_BIT | GL_CURRENT_BIT);
+    glViewport(0, 0, target.width, target.height);
+    glDisable(GL_DEPTH_TEST);
+    glDisable(GL_BLEND);
+    glDisable(GL_LIGHTING);
+    glEnable(GL_TEXTURE_2D);
+    glColor4f(1.0f, 1.0f, 1.0f, 1.0f);
+    glMatrixMode(GL_PROJECTION);
+    glPushMatrix();
+    glLoadIdentity();
+    glMatrixMode(GL_MODELVIEW);
+    glPushMatrix();
+    glLoadIdentity();
+    float u0 = 0.5f / target.width, v0 = 0.5f / target.height; // Half a texel in, so filtering never reads past the region
+    float u1 = (target.renderWidth - 0.5f) / target.width, v1 = (target.renderHeight - 0.5f) / target.height;
+    glBegin(GL_QUADS);
+    glTexCoord2f(u0, v0); glVertex2f(-1.0f, -1.0f);
+    glTexCoord2f(u1, v0); glVertex2f(1.0f, -1.0f);
+    glTexCoord2f(u1, v1); glVertex2f(1.0f, 1.0f);
+    glTexCoord2f(u0, v1); glVertex2f(-1.0f, 1.0f);
+    glEnd();
+    glPopMatrix();
+    glMatrixMode(GL_PROJECTION);
+    glPopMatrix();
+    glMatrixMode(GL_MODELVIEW);
+    glPopAttrib();
+    glBindTexture(GL_TEXTURE_2D, 0);
+    if (!target.genQueries)
+        return;
+    target.endQuery(GL_TIME_ELAPSED);
+    target.frame++;
+    if (target.frame < DYNRES_SETTLE_FRAMES) // Ring not full yet
+        return;
+    GLuint oldest = target.queries[target.frame % DYNRES_SETTLE_FRAMES]; // Reused next frame
+    GLint available = 0;
+    target.getQueryObjectiv(oldest, GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available) // Never wait on the GPU; a missed sample is just skipped
+        return;
+    GLuint64 elapsed = 0;
+    target.getQueryObjectui64v(oldest, GL_QUERY_RESULT, &elapsed);
+    dynResUpdate(*target.resolution, elapsed / 1000000.0);
+}
@@ -0,0 +1,89 @@
+// Fixed-timestep main loop shared by the demos
+//
+// Simulation runs in constant ticks (60 per second by default) however fast frames are rendered, so game
+// speed no longer depends on the display's refresh rate. Each frame banks the real time that passed and
+// runs as many whole ticks as fit; the leftover fraction of a tick is returned as an interpolation factor
+// so rendering can blend the previous and current simulation states instead of showing stutter.
+//
+// Typical loop:
+//   FixedStep clock = fixedStepInit(1.0 / 60.0);
+//   while (running) {
+//       int ticks = fixedStepAdvance(clock, now());
+//       for (int i = 0; i < ticks; i++) { previous = current; update(current); }
+//       render(fixedStepLerp(previous, current, fixedStepAlpha(clock)));
+//   }
+//
+// A frame that took too long (breakpoint, window drag, slow machine) runs at most maxTicks ticks and the
+// rest of the backlog is dropped, so catching up never takes longer than the frame it is catching up on.
+//
+// Command line, parsed by fixedStepUncapped:
+//   --uncapped             render without vsync, for benchmarking; simulation speed is unchanged
+
+#pragma once
+
+#include <cstring>
+
+struct FixedStep {
+    double step; // Seconds per tick
+    int maxTicks; // Most ticks run in one frame
+    double accumulator; // Unsimulated time, less than one tick after advancing
+    double last; // Time of the previous advance
+    bool started; // First advance seen
+    unsigned long long ticks; // Ticks run so far
+    double dropped; // Seconds thrown away by the catch-up clamp
+};
+
+// Creates a clock ticking every step seconds
+inline FixedStep fixedStepInit(double step, int maxTicks = 8) {
+    FixedStep clock = FixedStep(); // Zero-initialized clock
+    clock.step = step;
+    clock.maxTicks = maxTicks;
+    return clock;
+}
+
+// Banks the time since the last call and returns the number of ticks to simulate this frame
+inline int fixedStepAdvance(FixedStep& clock, double now) {
+    if (!clock.started) { // First frame only sets the reference time
+        clock.started = true;
+        clock.last = now;
+        return 0;
+    }
+    double elapsed = now - clock.last;
+    clock.last = now;
+    if (elapsed > 0.0)
+        clock.accumulator += elapsed;
+    int ticks = (int)(clock.accumulator / clock.step);
+    if (ticks > clock.maxTicks) { // Spiral of death: drop what cannot be caught up
+        clock.dropped += (ticks - clock.maxTicks) * clock.step;
+        clock.accumulator -= (ticks - clock.maxTicks) * clock.step;
+        ticks = clock.maxTicks;
+    }
+    clock.accumulator -= ticks * clock.step;
+    clock.ticks += ticks;
+    return ticks;
+}
+
+// Restarts the clock after the loop slept through a stretch of idle time (waiting for input with nothing
+// moving), so the wait is neither simulated nor counted as dropped
+inline void fixedStepResume(FixedStep& clock, double now) {
+    clock.last = now;
+}
+
+// Fraction of a tick between the last simulated state and now, in [0, 1]
+inline float fixedStepAlpha(const FixedStep& clock) {
+    double alpha = clock.accumulator / clock.step;
+    return (float)(alpha < 0.0 ? 0.0 : alpha > 1.0 ? 1.0 : alpha);
+}
+
+// Blends the previous and current value of a simulated quantity
+inline float fixedStepLerp(float previous, float current, float alpha) {
+    return previous + (current - previous) * alpha;
+}
+
+// True when --uncapped is on the command line
+inline bool fixedStepUncapped(int argc, char** argv) {
+    for (int i = 1; i < argc; i++)
+        if (strcmp(argv[i], "--uncapped") == 0)
+            return true;
+    return false;
+}
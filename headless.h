@@ -0,0 +1,246 @@
+// Headless rendering backend shared by the demos
+//
+// Runs a demo without a window: an EGL context (Mesa's surfaceless platform when available, otherwise a
+// pbuffer on the default display) renders into an offscreen framebuffer object for a fixed number of
+// frames, then prints frame time statistics and exits. Works on build boxes with no X server, for
+// example with Mesa llvmpipe (LIBGL_ALWAYS_SOFTWARE=1).
+//
+// Command line, parsed by headlessInit:
+//   --headless             render offscreen instead of opening a window
+//   --size WxH             framebuffer size (defaults to the demo's window size)
+//   --frames N             frames to render before exiting (default 300)
+//   --headless-out FILE    write the last frame to FILE as a binary PPM
+//
+// Include this after GLEW/GLUT/GLFW. Link with -lEGL.
+
+#pragma once
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#ifndef __GLEW_H__
+#include <GL/glext.h>
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+struct HeadlessState {
+    bool active; // Headless mode running
+    int width, height; // Framebuffer size
+    int frames, frame; // Frames requested and rendered
+    const char* output; // PPM path for the last frame, or NULL
+    EGLDisplay display; // EGL display
+    EGLContext context; // EGL context
+    EGLSurface surface; // Pbuffer, or EGL_NO_SURFACE when surfaceless
+    GLuint fbo, color, depth; // Offscreen framebuffer
+    std::chrono::steady_clock::time_point start, last; // Run start and last frame end
+    std::vector<double> frameTimes; // Milliseconds per frame
+};
+
+// Returns the headless state
+inline HeadlessState& headlessState() {
+    static HeadlessState state = HeadlessState(); // Zero-initialized state
+    return state;
+}
+
+// True once headlessInit has created the offscreen context
+inline bool headlessActive() {
+    return headlessState().active;
+}
+
+// Framebuffer width
+inline int headlessWidth() {
+    return headlessState().width;
+}
+
+// Framebuffer height
+inline int headlessHeight() {
+    return headlessState().height;
+}
+
+// Seconds since headlessInit, for demos that animate by time
+inline double headlessTime() {
+    HeadlessState& s = headlessState();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - s.start).count();
+}
+
+// True while frames remain to be rendered
+inline bool headlessRunning() {
+    HeadlessState& s = headlessState();
+    return s.frame < s.frames;
+}
+
+// Looks up a GL entry point through EGL, so the FBO calls work without a loader in legacy GLUT demos
+template <typename T>
+inline T headlessProc(const char* name) {
+    return (T)eglGetProcAddress(name);
+}
+
+// Creates the EGL context and offscreen framebuffer if --headless is on the command line. major/minor
+// request a context version and core picks the core profile; 0, 0, false gives a compatibility context
+// for fixed-function demos. Returns false when the demo should open its normal window.
+inline bool headlessInit(int argc, char** argv, int defaultWidth, int defaultHeight, int major, int minor, bool core) {
+    HeadlessState& s = headlessState();
+    bool requested = false;
+    s.width = defaultWidth;
+    s.height = defaultHeight;
+    s.frames = 300;
+    s.output = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--headless") == 0)
+            requested = true;
+        else if (strcmp(argv[i], "--size") == 0 && i + 1 < argc)
+            sscanf(argv[++i], "%dx%d", &s.width, &s.height);
+        else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+            s.frames = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--headless-out") == 0 && i + 1 < argc)
+            s.output = argv[++i];
+    }
+    if (!requested)
+        return false;
+
+    // Prefer the surfaceless platform: it needs no X server or GPU device node
+    const char* clientExtensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+    s.display = EGL_NO_DISPLAY;
+    if (clientExtensions && strstr(clientExtensions, "EGL_MESA_platform_surfaceless")) {
+        PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay = headlessProc<PFNEGLGETPLATFORMDISPLAYEXTPROC>("eglGetPlatformDisplayEXT");
+        if (getPlatformDisplay)
+            s.display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+    }
+    if (s.display == EGL_NO_DISPLAY)
+        s.display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    if (s.display == EGL_NO_DISPLAY || !eglInitialize(s.display, NULL, NULL)) {
+        fprintf(stderr, "ERROR::HEADLESS::NO_EGL_DISPLAY\n");
+        exit(1);
+    }
+    const char* displayExtensions = eglQueryString(s.display, EGL_EXTENSIONS);
+    bool surfaceless = displayExtensions && strstr(displayExtensions, "EGL_KHR_surfaceless_context");
+
+    EGLint configAttribs[] = {
+        EGL_SURFACE_TYPE, surfaceless ? 0 : EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8,
+        EGL_NONE
+    };
+    EGLConfig config;
+    EGLint configCount = 0;
+    if (!eglBindAPI(EGL_OPENGL_API) || !eglChooseConfig(s.display, configAttribs, &config, 1, &configCount) || configCount == 0) {
+        fprintf(stderr, "ERROR::HEADLESS::NO_EGL_CONFIG\n");
+        exit(1);
+    }
+
+    EGLint contextAttribs[7] = { EGL_NONE };
+    if (major > 0) {
+        contextAttribs[0] = EGL_CONTEXT_MAJOR_VERSION;
+        contextAttribs[1] = major;
+        contextAttribs[2] = EGL_CONTEXT_MINOR_VERSION;
+        contextAttribs[3] = minor;
+        contextAttribs[4] = EGL_CONTEXT_OPENGL_PROFILE_MASK;
+        contextAttribs[5] = core ? EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT : EGL_CONTEXT_OPENGL_COMPATIBILITY_PROFILE_BIT;
+        contextAttribs[6] = EGL_NONE;
+    }
+    s.context = eglCreateContext(s.display, config, EGL_NO_CONTEXT, contextAttribs);
+    if (s.context == EGL_NO_CONTEXT) {
+        fprintf(stderr, "ERROR::HEADLESS::CONTEXT_CREATION_FAILED %d.%d\n", major, minor);
+        exit(1);
+    }
+    s.surface = EGL_NO_SURFACE;
+    if (!surfaceless) {
+        EGLint pbufferAttribs[] = { EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE }; // Never drawn to; the FBO is
+        s.surface = eglCreatePbufferSurface(s.display, config, pbufferAttribs);
+    }
+    eglMakeCurrent(s.display, s.surface, s.surface, s.context);
+
+    // Offscreen framebuffer the demo renders into
+    PFNGLGENFRAMEBUFFERSPROC genFramebuffers = headlessProc<PFNGLGENFRAMEBUFFERSPROC>("glGenFramebuffers");
+    PFNGLBINDFRAMEBUFFERPROC bindFramebuffer = headlessProc<PFNGLBINDFRAMEBUFFERPROC>("glBindFramebuffer");
+    PFNGLGENRENDERBUFFERSPROC genRenderbuffers = headlessProc<PFNGLGENRENDERBUFFERSPROC>("glGenRenderbuffers");
+    PFNGLBINDRENDERBUFFERPROC bindRenderbuffer = headlessProc<PFNGLBINDRENDERBUFFERPROC>("glBindRenderbuffer");
+    PFNGLRENDERBUFFERSTORAGEPROC renderbufferStorage = headlessProc<PFNGLRENDERBUFFERSTORAGEPROC>("glRenderbufferStorage");
+    PFNGLFRAMEBUFFERRENDERBUFFERPROC framebufferRenderbuffer = headlessProc<PFNGLFRAMEBUFFERRENDERBUFFERPROC>("glFramebufferRenderbuffer");
+    PFNGLCHECKFRAMEBUFFERSTATUSPROC checkFramebufferStatus = headlessProc<PFNGLCHECKFRAMEBUFFERSTATUSPROC>("glCheckFramebufferStatus");
+    genFramebuffers(1, &s.fbo);
+    bindFramebuffer(GL_FRAMEBUFFER, s.fbo);
+    genRenderbuffers(1, &s.color);
+    bindRenderbuffer(GL_RENDERBUFFER, s.color);
+    renderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, s.width, s.height);
+    framebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, s.color);
+    genRenderbuffers(1, &s.depth);
+    bindRenderbuffer(GL_RENDERBUFFER, s.depth);
+    renderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, s.width, s.height);
+    framebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, s.depth);
+    if (checkFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        fprintf(stderr, "ERROR::HEADLESS::FRAMEBUFFER_INCOMPLETE\n");
+        exit(1);
+    }
+    glDrawBuffer(GL_COLOR_ATTACHMENT0);
+    glReadBuffer(GL_COLOR_ATTACHMENT0);
+    glViewport(0, 0, s.width, s.height);
+
+    printf("Headless: %dx%d, %d frames, %s\n", s.width, s.height, s.frames, (const char*)glGetString(GL_RENDERER));
+    s.active = true;
+    s.frame = 0;
+    s.frameTimes.clear();
+    s.start = s.last = std::chrono::steady_clock::now();
+    return true;
+}
+
+// Makes the headless context current on the calling thread, or releases it, for demos that render on a
+// thread other than the one that called headlessInit
+inline void headlessMakeCurrent(bool current) {
+    HeadlessState& s = headlessState();
+    if (current)
+        eglMakeCurrent(s.display, s.surface, s.surface, s.context);
+    else
+        eglMakeCurrent(s.display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+}
+
+// Ends a frame in place of a buffer swap. Waits for the GPU so each recorded time covers the whole frame.
+inline void headlessEndFrame() {
+    HeadlessState& s = headlessState();
+    glFinish();
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    s.frameTimes.push_back(std::chrono::duration<double, std::milli>(now - s.last).count());
+    s.last = now;
+    s.frame++;
+}
+
+// Writes the last frame, prints frame time statistics and destroys the context. Returns the exit code.
+inline int headlessFinish() {
+    HeadlessState& s = headlessState();
+    if (s.output) {
+        std::vector<unsigned char> pixels(s.width * s.height * 3);
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        glReadPixels(0, 0, s.width, s.height, GL_RGB, GL_UNSIGNED_BYTE, &pixels[0]);
+        FILE* file = fopen(s.output, "wb");
+        if (file) {
+            fprintf(file, "P6\n%d %d\n255\n", s.width, s.height);
+            for (int y = s.height - 1; y >= 0; y--) // PPM rows run top to bottom
+                fwrite(&pixels[y * s.width * 3], 1, s.width * 3, file);
+            fclose(file);
+        } else {
+            fprintf(stderr, "ERROR::HEADLESS::OUTPUT_NOT_WRITTEN %s\n", s.output);
+        }
+    }
+    if (!s.frameTimes.empty()) {
+        std::vector<double> sorted(s.frameTimes);
+        std::sort(sorted.begin(), sorted.end());
+        double total = 0.0;
+        for (size_t i = 0; i < sorted.size(); i++)
+            total += sorted[i];
+        size_t n = sorted.size() - 1;
+        printf("Headless: %d frames in %.1f ms, mean %.3f ms, p50 %.3f ms, p95 %.3f ms, p99 %.3f ms\n",
+               s.frame, total, total / sorted.size(), sorted[n / 2], sorted[n * 95 / 100], sorted[n * 99 / 100]);
+    }
+    eglMakeCurrent(s.display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    eglDestroyContext(s.display, s.context);
+    if (s.surface != EGL_NO_SURFACE)
+        eglDestroySurface(s.display, s.surface);
+    eglTerminate(s.display);
+    s.active = false;
+    return 0;
+}
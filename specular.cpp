@@ -10,6 +10,7 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <vector>
+#include "headless.h"
 
 struct Mesh {
 	std::vector<glm::vec3> vertices;
@@ -19,11 +20,17 @@ struct Mesh {
 
 float lightIntensity = 1.0f; // Initial light intensity
 
-void renderMesh(const Mesh& mesh, unsigned int VAO, unsigned int VBO, unsigned int EBO, float intensity) {
+// Uploads a mesh into the VAO's buffers once; the data is static, so nothing is re-sent per frame
+void uploadMesh(const Mesh& mesh, unsigned int VAO, unsigned int VBO, unsigned int EBO) {
 	glBindVertexArray(VAO);
 
+	// Positions followed by normals in one buffer
+	GLsizeiptr positionBytes = mesh.vertices.size() * sizeof(glm::vec3);
+	GLsizeiptr normalBytes = mesh.normals.size() * sizeof(glm::vec3);
 	glBindBuffer(GL_ARRAY_BUFFER, VBO);
-	glBufferData(GL_ARRAY_BUFFER, mesh.vertices.size() * sizeof(glm::vec3), &mesh.vertices[0], GL_STATIC_DRAW);
+	glBufferData(GL_ARRAY_BUFFER, positionBytes + normalBytes, NULL, GL_STATIC_DRAW);
+	glBufferSubData(GL_ARRAY_BUFFER, 0, positionBytes, &mesh.vertices[0]);
+	glBufferSubData(GL_ARRAY_BUFFER, positionBytes, normalBytes, &mesh.normals[0]);
 
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
 	glBufferData(GL_ELEMENT_ARRAY_BUFFER, mesh.indices.size() * sizeof(unsigned int), &mesh.indices[0], GL_STATIC_DRAW);
@@ -31,9 +38,15 @@ void renderMesh(const Mesh& mesh, unsigned int VAO, unsigned int VBO, unsigned i
 	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
 	glEnableVertexAttribArray(0);
 
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)positionBytes); // Normals, not positions
 	glEnableVertexAttribArray(1);
 
+	glBindVertexArray(0);
+}
+
+void renderMesh(const Mesh& mesh, unsigned int VAO, float intensity) {
+	glBindVertexArray(VAO);
+
 	glDrawElements(GL_TRIANGLES, mesh.indices.size(), GL_UNSIGNED_INT, 0);
 
 	glBindVertexArray(0);
@@ -48,14 +61,14 @@ const char* vertexShaderSource = R"(
 	out vec3 Normal;
 
 	uniform mat4 model;
-	uniform mat4 view;
-	uniform mat4 projection;
+	uniform mat4 mvp; // projection * view * model, computed once per frame on the CPU
+	uniform mat3 normalMatrix; // transpose(inverse(mat3(model))), computed once per frame on the CPU
 
 	void main()
 	{
-    	gl_Position = projection * view * model * vec4(aPos, 1.0);
+    	gl_Position = mvp * vec4(aPos, 1.0);
     	FragPos = vec3(model * vec4(aPos, 1.0));
-    	Normal = mat3(transpose(inverse(model))) * aNormal;
+    	Normal = normalMatrix * aNormal;
 	}
 )";
 
@@ -125,21 +138,28 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
 	}
 }
 
-int main() {
-	// Initialize GLFW and GLEW
-	if (!glfwInit()) return -1;
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-
-	// Create a window
-	GLFWwindow* window = glfwCreateWindow(800, 600, "Project 6: Specular Lighting, Objects, Illumination and Shaders", NULL, NULL);
-	if (!window) {
-    	glfwTerminate();
-    	return -1;
+int main(int argc, char** argv) {
+	// --headless renders a fixed number of frames offscreen instead of opening a window
+	bool headless = headlessInit(argc, argv, 800, 600, 3, 3, true);
+	GLFWwindow* window = NULL;
+	if (!headless) {
+		// Initialize GLFW and GLEW
+		if (!glfwInit()) return -1;
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+
+		// Create a window
+		window = glfwCreateWindow(800, 600, "Project 6: Specular Lighting, Objects, Illumination and Shaders", NULL, NULL);
+		if (!window) {
+	    	glfwTerminate();
+	    	return -1;
+		}
+		glfwMakeContextCurrent(window);
 	}
-	glfwMakeContextCurrent(window);
 
-	if (glewInit() != GLEW_OK) return -1;
+	// Without an X server GLEW reports a missing GLX display after it has loaded the GL functions
+	glewExperimental = GL_TRUE;
+	if (glewInit() != GLEW_OK && !headless) return -1;
 
 	glEnable(GL_DEPTH_TEST);
 
@@ -200,9 +220,9 @@ int main() {
 	glm::vec3 viewPos(0.0f, 0.0f, 3.0f);  // Adjusted to view the front face directly
 	glm::vec3 lightPos(0.0f, 0.0f, 2.0f); // Positioned closer to the front face
 
-	int modelLoc, viewLoc, projectionLoc, lightPosLoc, viewPosLoc, objectColorLoc, lightColorLoc, lightIntensityLoc;
+	int modelLoc, mvpLoc, normalMatrixLoc, lightPosLoc, viewPosLoc, objectColorLoc, lightColorLoc, lightIntensityLoc;
 
-	glfwSetKeyCallback(window, key_callback); // Register key callback
+	if (window) glfwSetKeyCallback(window, key_callback); // Register key callback
 
 	Mesh myMesh;
 
@@ -262,8 +282,9 @@ int main() {
 	    1, 0, 4,
 	};
 
+	uploadMesh(myMesh, VAO, VBO, EBO); // Static data, uploaded once before the loop
 
-	while (!glfwWindowShouldClose(window)) {
+	while (headless ? headlessRunning() : !glfwWindowShouldClose(window)) {
 	    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
 	    glUseProgram(shaderProgram);
@@ -278,9 +299,13 @@ int main() {
 	    glm::mat4 view = glm::lookAt(viewPos, glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
 	    glm::mat4 projection = glm::perspective(glm::radians(45.0f), 800.0f / 600.0f, 0.1f, 100.0f);
 
+	    // Per-object constants are computed here once instead of for every vertex
+	    glm::mat4 mvp = projection * view * model;
+	    glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(model)));
+
 	    modelLoc = glGetUniformLocation(shaderProgram, "model");
-	    viewLoc = glGetUniformLocation(shaderProgram, "view");
-	    projectionLoc = glGetUniformLocation(shaderProgram, "projection");
+	    mvpLoc = glGetUniformLocation(shaderProgram, "mvp");
+	    normalMatrixLoc = glGetUniformLocation(shaderProgram, "normalMatrix");
 	    lightPosLoc = glGetUniformLocation(shaderProgram, "lightPos");
 	    viewPosLoc = glGetUniformLocation(shaderProgram, "viewPos");
 	    objectColorLoc = glGetUniformLocation(shaderProgram, "objectColor");
@@ -288,20 +313,25 @@ int main() {
 	    lightIntensityLoc = glGetUniformLocation(shaderProgram, "lightIntensity");
 
 	    glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
-	    glUniformMatrix4fv(viewLoc, 1, GL_FALSE, glm::value_ptr(view));
-	    glUniformMatrix4fv(projectionLoc, 1, GL_FALSE, glm::value_ptr(projection));
+	    glUniformMatrix4fv(mvpLoc, 1, GL_FALSE, glm::value_ptr(mvp));
+	    glUniformMatrix3fv(normalMatrixLoc, 1, GL_FALSE, glm::value_ptr(normalMatrix));
 	    glUniform3fv(lightPosLoc, 1, glm::value_ptr(lightPos));
 	    glUniform3fv(viewPosLoc, 1, glm::value_ptr(viewPos));
 	    glUniform3fv(objectColorLoc, 1, glm::value_ptr(objectColor));
 	    glUniform3fv(lightColorLoc, 1, glm::value_ptr(lightColor));
 	    glUniform1f(lightIntensityLoc, lightIntensity);
 
-	    renderMesh(myMesh, VAO, VBO, EBO, lightIntensity);
+	    renderMesh(myMesh, VAO, lightIntensity);
 
+	    if (headless) {
+	        headlessEndFrame();
+	        continue;
+	    }
 	    glfwSwapBuffers(window);
 	    glfwPollEvents();
 }
 
+	if (headless) return headlessFinish();
 	glfwTerminate();
 
 	return 0;